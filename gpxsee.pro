@@ -43,8 +43,11 @@ HEADERS += src/common/config.h \
     src/common/programpaths.h \
     src/common/tifffile.h \
     src/common/polygon.h \
+    src/common/compactpath.h \
     src/common/color.h \
     src/common/csv.h \
+    src/common/memorybudget.h \
+    src/common/memorycache.h \
     src/GUI/legendentryitem.h \
     src/GUI/legenditem.h \
     src/GUI/crosshairitem.h \
@@ -54,6 +57,9 @@ HEADERS += src/common/config.h \
     src/GUI/axislabelitem.h \
     src/GUI/dirselectwidget.h \
     src/GUI/flowlayout.h \
+    src/GUI/collisiongrid.h \
+    src/GUI/overlayitem.h \
+    src/GUI/heatmapitem.h \
     src/GUI/graphicsscene.h \
     src/GUI/infolabel.h \
     src/GUI/mapaction.h \
@@ -209,6 +215,8 @@ HEADERS += src/common/config.h \
     src/map/bsbmap.h \
     src/map/invalidmap.h \
     src/map/kmzmap.h \
+    src/map/kmzjob.h \
+    src/map/kmzpyramid.h \
     src/map/projection.h \
     src/map/ellipsoid.h \
     src/map/datum.h \
@@ -217,6 +225,8 @@ HEADERS += src/common/config.h \
     src/map/map.h \
     src/map/dem.h \
     src/map/maplist.h \
+    src/map/mapcatalog.h \
+    src/map/catalogmap.h \
     src/map/onlinemap.h \
     src/map/tile.h \
     src/map/emptymap.h \
@@ -236,6 +246,8 @@ HEADERS += src/common/config.h \
     src/map/ct.h \
     src/map/mapsource.h \
     src/map/tileloader.h \
+    src/map/tilefallback.h \
+    src/map/metatile.h \
     src/map/wldfile.h \
     src/map/wmtsmap.h \
     src/map/wmts.h \
@@ -275,7 +287,10 @@ HEADERS += src/common/config.h \
     src/data/track.h \
     src/data/route.h \
     src/data/trackpoint.h \
+    src/data/segmentdata.h \
+    src/data/xmlvalue.h \
     src/data/data.h \
+    src/data/parsecache.h \
     src/data/parser.h \
     src/data/trackdata.h \
     src/data/routedata.h \
@@ -300,6 +315,7 @@ HEADERS += src/common/config.h \
 
 SOURCES += src/main.cpp \
     src/common/coordinates.cpp \
+    src/common/compactpath.cpp \
     src/common/protobuf.cpp \
     src/common/rectc.cpp \
     src/common/range.cpp \
@@ -309,6 +325,7 @@ SOURCES += src/main.cpp \
     src/common/programpaths.cpp \
     src/common/tifffile.cpp \
     src/common/csv.cpp \
+    src/common/memorybudget.cpp \
     src/GUI/legendentryitem.cpp \
     src/GUI/legenditem.cpp \
     src/GUI/crosshairitem.cpp \
@@ -368,6 +385,9 @@ SOURCES += src/main.cpp \
     src/GUI/areaitem.cpp \
     src/GUI/coordinatesitem.cpp \
     src/GUI/pathtickitem.cpp \
+    src/GUI/collisiongrid.cpp \
+    src/GUI/overlayitem.cpp \
+    src/GUI/heatmapitem.cpp \
     src/GUI/graphicsscene.cpp \
     src/GUI/pdfexportdialog.cpp \
     src/GUI/pngexportdialog.cpp \
@@ -445,7 +465,10 @@ SOURCES += src/main.cpp \
     src/map/textpointitem.cpp \
     src/map/bsbmap.cpp \
     src/map/kmzmap.cpp \
+    src/map/kmzpyramid.cpp \
     src/map/maplist.cpp \
+    src/map/mapcatalog.cpp \
+    src/map/catalogmap.cpp \
     src/map/onlinemap.cpp \
     src/map/emptymap.cpp \
     src/map/ozimap.cpp \
@@ -468,6 +491,8 @@ SOURCES += src/main.cpp \
     src/map/linearunits.cpp \
     src/map/mapsource.cpp \
     src/map/tileloader.cpp \
+    src/map/tilefallback.cpp \
+    src/map/metatile.cpp \
     src/map/wldfile.cpp \
     src/map/wmtsmap.cpp \
     src/map/wmts.cpp \
@@ -501,8 +526,11 @@ SOURCES += src/main.cpp \
     src/data/ov2parser.cpp \
     src/data/waypoint.cpp \
     src/data/data.cpp \
+    src/data/parsecache.cpp \
     src/data/poi.cpp \
     src/data/track.cpp \
+    src/data/segmentdata.cpp \
+    src/data/xmlvalue.cpp \
     src/data/route.cpp \
     src/data/path.cpp \
     src/data/gpxparser.cpp \
@@ -98,6 +98,7 @@ int App::run()
 
 	_gui->show();
 
+	_gui->beginBatch();
 	for (int i = 1; i < args.count(); i++) {
 		if (!_gui->openFile(args.at(i), false, silent)) {
 			MapAction *a;
@@ -109,6 +110,7 @@ int App::run()
 			}
 		}
 	}
+	_gui->endBatch();
 
 	if (lastReady)
 		lastReady->trigger();
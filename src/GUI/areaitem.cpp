@@ -71,6 +71,9 @@ void AreaItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 
+	if (_tiled && !_hover)
+		return;
+
 	painter->setPen(_width ? _pen : QPen(Qt::NoPen));
 	painter->drawPath(_painterPath);
 	painter->fillPath(_painterPath, _brush);
@@ -178,8 +181,20 @@ void AreaItem::setDigitalZoom(int zoom)
 	_pen.setWidthF(width() * pow(2, -_digitalZoom));
 }
 
+OverlayPath AreaItem::overlayPath() const
+{
+	/* The overlay is only used without digital zoom and never highlighted */
+	QPen pen(_pen);
+	pen.setWidthF(width());
+
+	return OverlayPath(_painterPath, _width ? pen : QPen(Qt::NoPen), _brush,
+	  zValue());
+}
+
 void AreaItem::hover(bool hvr)
 {
+	_hover = hvr;
+
 	if (hvr)
 		_pen.setWidthF((_width + 1) * pow(2, -_digitalZoom));
 	else
@@ -192,6 +207,7 @@ void AreaItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = true;
 	_pen.setWidthF((width() + 1) * pow(2, -_digitalZoom));
 	update();
 }
@@ -200,6 +216,7 @@ void AreaItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = false;
 	_pen.setWidthF(width() * pow(2, -_digitalZoom));
 	update();
 }
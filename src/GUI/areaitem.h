@@ -27,6 +27,7 @@ public:
 	void setPenStyle(Qt::PenStyle style);
 	void setDigitalZoom(int zoom);
 	void updateStyle();
+	OverlayPath overlayPath() const;
 
 	ToolTip info(bool extended) const;
 
@@ -0,0 +1,34 @@
+#include <cmath>
+#include <QGraphicsItem>
+#include "collisiongrid.h"
+
+bool CollisionGrid::add(QGraphicsItem *item)
+{
+	QRectF rect(item->sceneBoundingRect());
+	int left = (int)floor(rect.left() / _cellSize);
+	int top = (int)floor(rect.top() / _cellSize);
+	int right = (int)floor(rect.right() / _cellSize);
+	int bottom = (int)floor(rect.bottom() / _cellSize);
+
+	for (int y = top; y <= bottom; y++) {
+		for (int x = left; x <= right; x++) {
+			QHash<quint64, QVector<Entry> >::const_iterator it
+			  = _cells.constFind(key(x, y));
+			if (it == _cells.constEnd())
+				continue;
+
+			const QVector<Entry> &cell = *it;
+			for (int i = 0; i < cell.size(); i++) {
+				const Entry &e = cell.at(i);
+				if (e.rect.intersects(rect) && item->collidesWithItem(e.item))
+					return false;
+			}
+		}
+	}
+
+	for (int y = top; y <= bottom; y++)
+		for (int x = left; x <= right; x++)
+			_cells[key(x, y)].append(Entry(item, rect));
+
+	return true;
+}
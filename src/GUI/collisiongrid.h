@@ -0,0 +1,40 @@
+#ifndef COLLISIONGRID_H
+#define COLLISIONGRID_H
+
+#include <QHash>
+#include <QVector>
+#include <QRectF>
+
+class QGraphicsItem;
+
+/*
+  Screen space grid used to hide overlapping items (POIs, waypoint labels).
+  The items are placed in the order they are added, so the caller defines
+  their priority. An item is rejected if it collides with any of the already
+  placed items, but only the items sharing a grid cell with it are tested.
+*/
+class CollisionGrid
+{
+public:
+	CollisionGrid(qreal cellSize) : _cellSize(cellSize) {}
+
+	bool add(QGraphicsItem *item);
+
+private:
+	struct Entry {
+		Entry() : item(0) {}
+		Entry(QGraphicsItem *item, const QRectF &rect)
+		  : item(item), rect(rect) {}
+
+		QGraphicsItem *item;
+		QRectF rect;
+	};
+
+	static quint64 key(int x, int y)
+	  {return ((quint64)(quint32)x << 32) | (quint32)y;}
+
+	qreal _cellSize;
+	QHash<quint64, QVector<Entry> > _cells;
+};
+
+#endif // COLLISIONGRID_H
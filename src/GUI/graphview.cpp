@@ -89,6 +89,9 @@ GraphView::GraphView(QWidget *parent)
 
 	_angleDelta = 0;
 	_dragStart = 0;
+
+	_batch = false;
+	_pendingRedraw = false;
 }
 
 GraphView::~GraphView()
@@ -256,6 +259,13 @@ QRectF GraphView::bounds() const
 
 void GraphView::redraw()
 {
+	/* Hidden views (inactive graph tabs) postpone the layout and the graph
+	   paths creation until they are shown, batches until they end */
+	if (_batch || !isVisible()) {
+		_pendingRedraw = true;
+		return;
+	}
+
 	redraw(viewport()->size() - QSizeF(MARGIN, MARGIN));
 }
 
@@ -266,6 +276,8 @@ void GraphView::redraw(const QSizeF &size)
 	RangeF rx, ry;
 	qreal sx, sy;
 
+	_pendingRedraw = false;
+
 	if (_bounds.isNull()) {
 		removeItem(_xAxis);
 		removeItem(_yAxis);
@@ -348,13 +360,31 @@ void GraphView::redraw(const QSizeF &size)
 	_scene->setSceneRect(_scene->itemsBoundingRect());
 }
 
+void GraphView::endBatch()
+{
+	_batch = false;
+	if (_pendingRedraw)
+		redraw();
+}
+
 void GraphView::resizeEvent(QResizeEvent *e)
 {
-	redraw(e->size() - QSizeF(MARGIN, MARGIN));
+	if (isVisible())
+		redraw(e->size() - QSizeF(MARGIN, MARGIN));
+	else
+		_pendingRedraw = true;
 
 	QGraphicsView::resizeEvent(e);
 }
 
+void GraphView::showEvent(QShowEvent *e)
+{
+	if (_pendingRedraw)
+		redraw();
+
+	QGraphicsView::showEvent(e);
+}
+
 void GraphView::mousePressEvent(QMouseEvent *e)
 {
 	if (e->button() == Qt::LeftButton)
@@ -35,6 +35,9 @@ public:
 
 	void plot(QPainter *painter, const QRectF &target, qreal scale);
 
+	void beginBatch() {_batch = true;}
+	void endBatch();
+
 	void setPalette(const Palette &palette);
 	void setGraphWidth(int width);
 	void showGrid(bool show);
@@ -57,6 +60,7 @@ protected:
 	void setUnits(Units units);
 
 	void resizeEvent(QResizeEvent *e);
+	void showEvent(QShowEvent *e);
 	void mousePressEvent(QMouseEvent *e);
 	void mouseMoveEvent(QMouseEvent *e);
 	void wheelEvent(QWheelEvent *e);
@@ -126,6 +130,8 @@ private:
 
 	int _angleDelta;
 	int _dragStart;
+
+	bool _batch, _pendingRedraw;
 };
 
 #endif // GRAPHVIEW_H
@@ -29,14 +29,18 @@
 #include <QGeoPositionInfoSource>
 #include "common/config.h"
 #include "common/programpaths.h"
+#include "common/memorybudget.h"
 #include "data/data.h"
+#include "data/parsecache.h"
 #include "data/poi.h"
 #include "map/downloader.h"
 #include "map/demloader.h"
 #include "map/maplist.h"
+#include "map/mapcatalog.h"
 #include "map/emptymap.h"
 #include "map/crs.h"
 #include "map/hillshading.h"
+#include "map/kmzmap.h"
 #include "icons.h"
 #include "keys.h"
 #include "settings.h"
@@ -422,6 +426,11 @@ void GUI::createActions()
 	_showAreasAction->setCheckable(true);
 	_showAreasAction->setShortcut(SHOW_AREAS_SHORTCUT);
 	connect(_showAreasAction, &QAction::triggered, this, &GUI::showAreas);
+	_showHeatmapAction = new QAction(tr("Show heatmap"), this);
+	_showHeatmapAction->setMenuRole(QAction::NoRole);
+	_showHeatmapAction->setCheckable(true);
+	connect(_showHeatmapAction, &QAction::triggered, _mapView,
+	  &MapView::showHeatmap);
 	_showWaypointIconsAction = new QAction(tr("Waypoint icons"), this);
 	_showWaypointIconsAction->setMenuRole(QAction::NoRole);
 	_showWaypointIconsAction->setCheckable(true);
@@ -743,6 +752,8 @@ void GUI::createMenus()
 	dataMenu->addAction(_showRoutesAction);
 	dataMenu->addAction(_showAreasAction);
 	dataMenu->addAction(_showWaypointsAction);
+	dataMenu->addSeparator();
+	dataMenu->addAction(_showHeatmapAction);
 
 	_poiMenu = menuBar()->addMenu(tr("&POI"));
 	_poisEnd = _poiMenu->addSeparator();
@@ -1038,8 +1049,10 @@ void GUI::openFile()
 #endif // Q_OS_ANDROID
 	int showError = (files.size() > 1) ? 2 : 1;
 
+	beginBatch();
 	for (int i = 0; i < files.size(); i++)
 		openFile(files.at(i), true, showError);
+	endBatch();
 	if (!files.isEmpty())
 		_dataDir = QFileInfo(files.last()).path();
 }
@@ -1075,7 +1088,9 @@ void GUI::openDir()
 		openFile(_browser->current(), true, showError);
 #else // Q_OS_ANDROID
 		int showError = 2;
+		beginBatch();
 		openDir(dir, showError);
+		endBatch();
 		_dataDir = dir;
 #endif // Q_OS_ANDROID
 	}
@@ -1193,6 +1208,22 @@ bool GUI::loadFile(const QString &fileName, bool tryUnknown, int &showError)
 	}
 }
 
+/* Loading of multiple files - the map view is fitted and the graphs are
+   redrawn only once at the end of the batch */
+void GUI::beginBatch()
+{
+	_mapView->beginBatch();
+	for (int i = 0; i < _tabs.count(); i++)
+		_tabs.at(i)->beginBatch();
+}
+
+void GUI::endBatch()
+{
+	_mapView->endBatch();
+	for (int i = 0; i < _tabs.count(); i++)
+		_tabs.at(i)->endBatch();
+}
+
 void GUI::loadData(const Data &data)
 {
 	QList<QList<GraphItem*> > graphs;
@@ -1622,12 +1653,14 @@ void GUI::reloadFiles()
 	_mapView->clear();
 
 	int showError = 2;
+	beginBatch();
 	for (int i = 0; i < _files.size(); i++) {
 		if (!loadFile(_files.at(i), true, showError)) {
 			_files.removeAt(i);
 			i--;
 		}
 	}
+	endBatch();
 
 	updateStatusBarInfo();
 	updateWindowTitle();
@@ -2552,6 +2585,7 @@ void GUI::dropEvent(QDropEvent *event)
 	int silent = 0;
 	int showError = (urls.size() > 1) ? 2 : 1;
 
+	beginBatch();
 	for (int i = 0; i < urls.size(); i++) {
 		QString file(urls.at(i).toLocalFile());
 
@@ -2565,6 +2599,7 @@ void GUI::dropEvent(QDropEvent *event)
 			}
 		}
 	}
+	endBatch();
 
 	if (lastReady)
 		lastReady->trigger();
@@ -2679,6 +2714,7 @@ void GUI::writeSettings()
 	WRITE(routes, _showRoutesAction->isChecked());
 	WRITE(waypoints, _showWaypointsAction->isChecked());
 	WRITE(areas, _showAreasAction->isChecked());
+	WRITE(heatmap, _showHeatmapAction->isChecked());
 	WRITE(waypointIcons, _showWaypointIconsAction->isChecked());
 	WRITE(waypointLabels, _showWaypointLabelsAction->isChecked());
 	WRITE(routeWaypoints, _showRouteWaypointsAction->isChecked());
@@ -2748,6 +2784,8 @@ void GUI::writeSettings()
 	WRITE(waypointColor, _options.waypointColor);
 	WRITE(poiSize, _options.poiSize);
 	WRITE(poiColor, _options.poiColor);
+	WRITE(heatmapColdColor, _options.heatmapColdColor);
+	WRITE(heatmapHotColor, _options.heatmapHotColor);
 	WRITE(graphWidth, _options.graphWidth);
 	WRITE(pathAntiAliasing, _options.pathAntiAliasing);
 	WRITE(graphAntiAliasing, _options.graphAntiAliasing);
@@ -2782,8 +2820,10 @@ void GUI::writeSettings()
 	WRITE(positionPluginParameters, _options.pluginParams);
 	WRITE(useOpenGL, _options.useOpenGL);
 	WRITE(enableHTTP2, _options.enableHTTP2);
+	WRITE(cacheParsedData, _options.cacheParsedData);
+	WRITE(cacheKMZTiles, _options.cacheKMZTiles);
 	WRITE(pixmapCache, _options.pixmapCache);
-	WRITE(demCache, _options.demCache);
+	WRITE(dataCache, _options.dataCache);
 	WRITE(connectionTimeout, _options.connectionTimeout);
 	WRITE(hiresPrint, _options.hiresPrint);
 	WRITE(printName, _options.printName);
@@ -2950,6 +2990,10 @@ void GUI::readSettings(QString &activeMap, QStringList &disabledPOIs,
 		_showAreasAction->setChecked(true);
 		_mapView->showAreas(true);
 	}
+	if (READ(heatmap).toBool()) {
+		_showHeatmapAction->setChecked(true);
+		_mapView->showHeatmap(true);
+	}
 	if (READ(waypointIcons).toBool()) {
 		_showWaypointIconsAction->setChecked(true);
 		_mapView->showWaypointIcons(true);
@@ -3060,6 +3104,8 @@ void GUI::readSettings(QString &activeMap, QStringList &disabledPOIs,
 	_options.waypointColor = READ(waypointColor).value<QColor>();
 	_options.poiSize = READ(poiSize).toInt();
 	_options.poiColor = READ(poiColor).value<QColor>();
+	_options.heatmapColdColor = READ(heatmapColdColor).value<QColor>();
+	_options.heatmapHotColor = READ(heatmapHotColor).value<QColor>();
 	_options.graphWidth = READ(graphWidth).toInt();
 	_options.graphAntiAliasing = READ(graphAntiAliasing).toBool();
 	_options.elevationFilter = READ(elevationFilter).toInt();
@@ -3093,8 +3139,11 @@ void GUI::readSettings(QString &activeMap, QStringList &disabledPOIs,
 	_options.pluginParams = READ(positionPluginParameters);
 	_options.useOpenGL = READ(useOpenGL).toBool();
 	_options.enableHTTP2 = READ(enableHTTP2).toBool();
+	_options.cacheParsedData = READ(cacheParsedData).toBool();
+	_options.cacheKMZTiles = READ(cacheKMZTiles).toBool();
 	_options.pixmapCache = READ(pixmapCache).toInt();
-	_options.demCache = READ(demCache).toInt();
+	_options.dataCache = Settings::dataCache.read(settings,
+	  Settings::demCache).toInt();
 	_options.connectionTimeout = READ(connectionTimeout).toInt();
 	_options.hiresPrint = READ(hiresPrint).toBool();
 	_options.printName = READ(printName).toBool();
@@ -3138,6 +3187,8 @@ void GUI::loadOptions()
 	_mapView->setWaypointColor(_options.waypointColor);
 	_mapView->setPOISize(_options.poiSize);
 	_mapView->setPOIColor(_options.poiColor);
+	_mapView->setHeatmapColdColor(_options.heatmapColdColor);
+	_mapView->setHeatmapHotColor(_options.heatmapHotColor);
 	_mapView->setRenderHint(QPainter::Antialiasing, _options.pathAntiAliasing);
 	_mapView->setMarkerColor(_options.sliderColor);
 	_mapView->useOpenGL(_options.useOpenGL);
@@ -3179,8 +3230,11 @@ void GUI::loadOptions()
 	Downloader::enableHTTP2(_options.enableHTTP2);
 	Downloader::setTimeout(_options.connectionTimeout);
 
+	Data::useCache(_options.cacheParsedData);
+	KMZMap::useDiskCache(_options.cacheKMZTiles);
+
 	QPixmapCache::setCacheLimit(_options.pixmapCache * 1024);
-	DEM::setCacheSize(_options.demCache * 1024);
+	MemoryBudget::setLimit((qint64)_options.dataCache * 1024 * 1024);
 
 	HillShading::setAlpha(_options.hillshadingAlpha);
 	HillShading::setBlur(_options.hillshadingBlur);
@@ -3248,6 +3302,8 @@ void GUI::updateOptions(const Options &options)
 	SET_VIEW_OPTION(waypointColor, setWaypointColor);
 	SET_VIEW_OPTION(poiSize, setPOISize);
 	SET_VIEW_OPTION(poiColor, setPOIColor);
+	SET_VIEW_OPTION(heatmapColdColor, setHeatmapColdColor);
+	SET_VIEW_OPTION(heatmapHotColor, setHeatmapHotColor);
 	SET_VIEW_OPTION(pathAntiAliasing, useAntiAliasing);
 	SET_VIEW_OPTION(useOpenGL, useOpenGL);
 	SET_VIEW_OPTION(sliderColor, setMarkerColor);
@@ -3319,8 +3375,8 @@ void GUI::updateOptions(const Options &options)
 
 	if (options.pixmapCache != _options.pixmapCache)
 		QPixmapCache::setCacheLimit(options.pixmapCache * 1024);
-	if (options.demCache != _options.demCache)
-		DEM::setCacheSize(options.demCache * 1024);
+	if (options.dataCache != _options.dataCache)
+		MemoryBudget::setLimit((qint64)options.dataCache * 1024 * 1024);
 
 	SET_HS_OPTION(hillshadingAlpha, setAlpha);
 	SET_HS_OPTION(hillshadingBlur, setBlur);
@@ -3333,6 +3389,16 @@ void GUI::updateOptions(const Options &options)
 		Downloader::setTimeout(options.connectionTimeout);
 	if (options.enableHTTP2 != _options.enableHTTP2)
 		Downloader::enableHTTP2(options.enableHTTP2);
+	if (options.cacheParsedData != _options.cacheParsedData) {
+		Data::useCache(options.cacheParsedData);
+		if (!options.cacheParsedData)
+			ParseCache::clear();
+	}
+	if (options.cacheKMZTiles != _options.cacheKMZTiles) {
+		KMZMap::useDiskCache(options.cacheKMZTiles);
+		if (!options.cacheKMZTiles)
+			KMZMap::clearDiskCache();
+	}
 
 	if (options.dataPath != _options.dataPath)
 		_dataDir = options.dataPath;
@@ -3358,7 +3424,8 @@ void GUI::loadInitialMaps(const QString &selected)
 	if (mapDir.isEmpty())
 		return;
 
-	TreeNode<Map*> maps(MapList::loadMaps(mapDir, _mapView->inputProjection()));
+	MapCatalog catalog(ProgramPaths::mapCatalogFile());
+	TreeNode<Map*> maps(catalog.loadMaps(mapDir, _mapView->inputProjection()));
 	createMapNodeMenu(createMapActionsNode(maps), _mapMenu, _mapsEnd);
 
 	// Select the active map according to the user settings
@@ -46,6 +46,8 @@ public:
 
 	bool openFile(const QString &fileName, bool tryUnknown, int &showError);
 	bool loadMap(const QString &fileName, MapAction *&action, int &showError);
+	void beginBatch();
+	void endBatch();
 	void show();
 	void writeSettings();
 
@@ -296,6 +298,7 @@ private:
 	QAction *_showWaypointLabelsAction;
 	QAction *_showWaypointIconsAction;
 	QAction *_showAreasAction;
+	QAction *_showHeatmapAction;
 	QAction *_showRouteWaypointsAction;
 	QAction *_hideMarkersAction;
 	QAction *_showMarkersAction;
@@ -0,0 +1,344 @@
+#include <cmath>
+#include <algorithm>
+#include <QPainter>
+#include <QThread>
+#include "heatmapitem.h"
+
+#define CELL_SIZE     2.0      /* screen pixels */
+#define MARGIN        0.25     /* computed in advance for panning (x size) */
+#define MAX_GRID_SIZE 2048     /* cells per side (printing/export) */
+#define MAX_CELLS     16777216 /* all the threads grids */
+
+/* Liang-Barsky clipping of the a-b line to the [0, w] x [0, h] rect */
+static bool clipLine(QPointF &a, QPointF &b, qreal w, qreal h)
+{
+	QPointF d(b - a);
+	qreal p[4] = {-d.x(), d.x(), -d.y(), d.y()};
+	qreal q[4] = {a.x(), w - a.x(), a.y(), h - a.y()};
+	qreal t0 = 0, t1 = 1;
+
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0) {
+			if (q[i] < 0)
+				return false;
+		} else {
+			qreal t = q[i] / p[i];
+			if (p[i] < 0) {
+				if (t > t1)
+					return false;
+				t0 = qMax(t0, t);
+			} else {
+				if (t < t0)
+					return false;
+				t1 = qMin(t1, t);
+			}
+		}
+	}
+
+	b = a + d * t1;
+	a = a + d * t0;
+
+	return true;
+}
+
+static void rasterizeLine(const HeatmapChunk &chunk, const QPointF &p1,
+  const QPointF &p2, quint32 *cells, int &last)
+{
+	QPointF a((p1 - chunk.origin) / chunk.cell);
+	QPointF b((p2 - chunk.origin) / chunk.cell);
+
+	/* The grid only covers the visible part of the scene */
+	if (!clipLine(a, b, chunk.width, chunk.height)) {
+		last = -1;
+		return;
+	}
+
+	int steps = (int)ceil(qMax(qAbs(b.x() - a.x()), qAbs(b.y() - a.y())));
+
+	for (int i = 0; i <= steps; i++) {
+		QPointF p(steps ? a + (b - a) * ((qreal)i / steps) : a);
+		int x = qBound(0, (int)p.x(), chunk.width - 1);
+		int y = qBound(0, (int)p.y(), chunk.height - 1);
+		int idx = y * chunk.width + x;
+
+		/* Consecutive points in the same cell (e.g. a stopped device
+		   recording its position) are counted only once */
+		if (idx != last) {
+			cells[idx]++;
+			last = idx;
+		}
+	}
+}
+
+/* The chunks are ranges of the path elements of all the paths. The render
+   threads only read the elements of the (shared) paths, the GUI thread may
+   meanwhile only add its cached data (bounds, converters) to the paths. */
+static QVector<quint32> rasterizeChunk(const HeatmapChunk &chunk)
+{
+	QVector<quint32> grid(chunk.width * chunk.height, 0);
+	quint32 *cells = grid.data();
+	const QVector<int> &offsets = *chunk.offsets;
+	int i = std::upper_bound(offsets.constBegin(), offsets.constEnd(),
+	  chunk.from) - offsets.constBegin() - 1;
+	int last = -1;
+
+	for (int e = chunk.from; e < chunk.to; i++) {
+		const QPainterPath &path = chunk.paths->at(i);
+		int end = qMin(chunk.to, offsets.at(i + 1));
+
+		for (int j = e - offsets.at(i); j < end - offsets.at(i); j++) {
+			const QPainterPath::Element &el = path.elementAt(j);
+			if (j && !el.isMoveTo())
+				rasterizeLine(chunk, path.elementAt(j-1), el, cells, last);
+			else
+				last = -1;
+		}
+
+		e = end;
+	}
+
+	return grid;
+}
+
+static void sumGrid(QVector<quint32> &sum, const QVector<quint32> &grid)
+{
+	if (sum.isEmpty()) {
+		sum = grid;
+		return;
+	}
+
+	quint32 *dst = sum.data();
+	const quint32 *src = grid.constData();
+	for (int i = 0; i < sum.size(); i++)
+		dst[i] += src[i];
+}
+
+static int mix(int c1, int c2, qreal t)
+{
+	return qRound(c1 + (c2 - c1) * t);
+}
+
+static QImage colorize(const QVector<quint32> &grid, int width, int height,
+  const QColor &cold, const QColor &hot)
+{
+	const quint32 *cells = grid.constData();
+	quint32 max = 0;
+
+	for (int i = 0; i < grid.size(); i++)
+		max = qMax(max, cells[i]);
+	if (!max)
+		return QImage();
+
+	/* Logarithmic ramp, a few very frequent routes would otherwise make all
+	   the other tracks invisible */
+	qreal lmax = log(1.0 + max);
+	QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
+	for (int y = 0; y < height; y++) {
+		QRgb *line = (QRgb*)img.scanLine(y);
+		for (int x = 0; x < width; x++) {
+			quint32 v = cells[y * width + x];
+			if (!v) {
+				line[x] = 0;
+				continue;
+			}
+
+			qreal t = log(1.0 + v) / lmax;
+			line[x] = qPremultiply(qRgba(mix(cold.red(), hot.red(), t),
+			  mix(cold.green(), hot.green(), t), mix(cold.blue(), hot.blue(),
+			  t), mix(cold.alpha(), hot.alpha(), t)));
+		}
+	}
+
+	return img;
+}
+
+HeatmapJob::HeatmapJob(const QList<QPainterPath> &paths, const QRectF &rect,
+  qreal cell, int generation, int projection) : _paths(paths), _cell(cell),
+  _generation(generation), _projection(projection)
+{
+	_width = qMax(1, (int)ceil(rect.width() / cell));
+	_height = qMax(1, (int)ceil(rect.height() / cell));
+	_rect = QRectF(rect.topLeft(), QSizeF(_width * cell, _height * cell));
+
+	_offsets.append(0);
+	for (int i = 0; i < _paths.size(); i++)
+		_offsets.append(_offsets.last() + _paths.at(i).elementCount());
+
+	int count = _offsets.last();
+	int threads = qMax(1, qMin(qMin(QThread::idealThreadCount(), count),
+	  MAX_CELLS / (_width * _height)));
+
+	/* Every thread accumulates into its own grid, the grids are summed up
+	   in the reduce step */
+	for (int i = 0; i < threads; i++) {
+		HeatmapChunk chunk;
+		chunk.paths = &_paths;
+		chunk.offsets = &_offsets;
+		chunk.from = (int)(((qint64)count * i) / threads);
+		chunk.to = (int)(((qint64)count * (i + 1)) / threads);
+		chunk.origin = _rect.topLeft();
+		chunk.cell = _cell;
+		chunk.width = _width;
+		chunk.height = _height;
+		_chunks.append(chunk);
+	}
+}
+
+void HeatmapJob::run()
+{
+	connect(&_watcher, &QFutureWatcher<QVector<quint32> >::finished, this,
+	  &HeatmapJob::handleFinished);
+	_future = QtConcurrent::mappedReduced<QVector<quint32> >(_chunks,
+	  rasterizeChunk, sumGrid);
+	_watcher.setFuture(_future);
+}
+
+HeatmapItem::HeatmapItem(QGraphicsItem *parent)
+  : QGraphicsItem(parent), _generation(0), _projection(0)
+{
+	_cold = QColor(0, 0, 255, 128);
+	_hot = QColor(255, 0, 0, 255);
+
+	setAcceptedMouseButtons(Qt::NoButton);
+}
+
+HeatmapItem::~HeatmapItem()
+{
+	cancelJobs(true);
+	qDeleteAll(_jobs);
+}
+
+bool HeatmapItem::isRunning() const
+{
+	for (int i = 0; i < _jobs.size(); i++)
+		if (!_jobs.at(i)->isCanceled())
+			return true;
+
+	return false;
+}
+
+void HeatmapItem::runJob(HeatmapJob *job)
+{
+	_jobs.append(job);
+
+	connect(job, &HeatmapJob::finished, this, &HeatmapItem::jobFinished);
+	job->run();
+}
+
+void HeatmapItem::jobFinished(HeatmapJob *job)
+{
+	/* Grids of older paths generations are still valid for the current
+	   projection, they are drawn until the next grid is ready */
+	if (!job->isCanceled() && job->projection() == _projection) {
+		_raster.rect = job->rect();
+		_raster.cell = job->cell();
+		_raster.width = job->width();
+		_raster.height = job->height();
+		_raster.generation = job->generation();
+		_raster.projection = job->projection();
+		_raster.grid = job->grid();
+		_raster.image = colorize(_raster.grid, _raster.width, _raster.height,
+		  _cold, _hot);
+	}
+
+	_jobs.removeOne(job);
+	job->deleteLater();
+
+	update();
+}
+
+void HeatmapItem::cancelJobs(bool wait)
+{
+	for (int i = 0; i < _jobs.size(); i++)
+		_jobs.at(i)->cancel(wait);
+}
+
+void HeatmapItem::setPaths(const QRectF &bounds,
+  const QList<QPainterPath> &paths)
+{
+	cancelJobs(false);
+
+	prepareGeometryChange();
+	_bounds = bounds;
+	_paths = paths;
+	_projection++;
+	_generation++;
+
+	update();
+}
+
+void HeatmapItem::addPath(const QRectF &bounds, const QPainterPath &path)
+{
+	if (bounds != _bounds) {
+		prepareGeometryChange();
+		_bounds = bounds;
+	}
+	_paths.append(path);
+	_generation++;
+
+	update();
+}
+
+void HeatmapItem::setColors(const QColor &cold, const QColor &hot)
+{
+	_cold = cold;
+	_hot = hot;
+
+	_raster.image = colorize(_raster.grid, _raster.width, _raster.height,
+	  _cold, _hot);
+
+	update();
+}
+
+void HeatmapItem::clear()
+{
+	cancelJobs(false);
+
+	prepareGeometryChange();
+	_paths.clear();
+	_bounds = QRectF();
+	_raster = Raster();
+	_projection++;
+	_generation++;
+}
+
+void HeatmapItem::paint(QPainter *painter,
+  const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+	Q_UNUSED(option);
+
+	if (_paths.isEmpty())
+		return;
+
+	/* The visible part of the scene and the cell size in scene units */
+	QTransform t(painter->worldTransform());
+	QRectF sr(t.inverted().mapRect(QRectF(painter->viewport())));
+	QRectF vr(sr.intersected(_bounds));
+	qreal cell = qMax(CELL_SIZE / t.m11(), qMax(sr.width(), sr.height())
+	  * (1.0 + 2 * MARGIN) / MAX_GRID_SIZE);
+	if (vr.isEmpty())
+		return;
+
+	QRectF rect(vr.adjusted(-vr.width() * MARGIN, -vr.height() * MARGIN,
+	  vr.width() * MARGIN, vr.height() * MARGIN).intersected(_bounds));
+
+	/* Printing/export (no widget) can not wait for the next repaint */
+	if (!widget) {
+		HeatmapJob job(_paths, vr, cell, _generation, _projection);
+		job.run();
+		job.wait();
+		QImage img(colorize(job.grid(), job.width(), job.height(), _cold,
+		  _hot));
+		if (!img.isNull())
+			painter->drawImage(job.rect(), img);
+		return;
+	}
+
+	if (_raster.projection == _projection && !_raster.image.isNull())
+		painter->drawImage(_raster.rect, _raster.image);
+
+	if (!isRunning() && (_raster.projection != _projection
+	  || _raster.generation != _generation || _raster.cell != cell
+	  || !_raster.rect.contains(vr)))
+		runJob(new HeatmapJob(_paths, rect, cell, _generation, _projection));
+}
@@ -0,0 +1,121 @@
+#ifndef HEATMAPITEM_H
+#define HEATMAPITEM_H
+
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <QImage>
+#include <QtConcurrent>
+
+struct HeatmapChunk
+{
+	const QList<QPainterPath> *paths;
+	const QVector<int> *offsets;
+	int from, to;
+	QPointF origin;
+	qreal cell;
+	int width, height;
+};
+
+class HeatmapJob : public QObject
+{
+	Q_OBJECT
+
+public:
+	HeatmapJob(const QList<QPainterPath> &paths, const QRectF &rect,
+	  qreal cell, int generation, int projection);
+
+	void run();
+	void cancel(bool wait)
+	{
+		_future.cancel();
+		if (wait)
+			_future.waitForFinished();
+	}
+	void wait() {_future.waitForFinished();}
+	bool isCanceled() const {return _future.isCanceled();}
+
+	const QRectF &rect() const {return _rect;}
+	qreal cell() const {return _cell;}
+	int width() const {return _width;}
+	int height() const {return _height;}
+	int generation() const {return _generation;}
+	int projection() const {return _projection;}
+	QVector<quint32> grid() const {return _future.result();}
+
+signals:
+	void finished(HeatmapJob *job);
+
+private slots:
+	void handleFinished() {emit finished(this);}
+
+private:
+	QFutureWatcher<QVector<quint32> > _watcher;
+	QFuture<QVector<quint32> > _future;
+	QList<QPainterPath> _paths;
+	QVector<int> _offsets;
+	QList<HeatmapChunk> _chunks;
+	QRectF _rect;
+	qreal _cell;
+	int _width, _height;
+	int _generation;
+	int _projection;
+};
+
+/*
+  Track density layer. The (already projected) track paths are counted in a
+  grid of screen pixel sized cells covering the visible part of the scene.
+  The grid is computed in background threads (every thread has its own grid,
+  the grids are summed up afterwards), mapped to the color ramp and drawn as
+  a single image. The last computed grid is drawn until the next one is
+  ready.
+*/
+class HeatmapItem : public QObject, public QGraphicsItem
+{
+	Q_OBJECT
+
+public:
+	HeatmapItem(QGraphicsItem *parent = 0);
+	~HeatmapItem();
+
+	QRectF boundingRect() const {return _bounds;}
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+	  QWidget *widget);
+
+	void setPaths(const QRectF &bounds, const QList<QPainterPath> &paths);
+	void addPath(const QRectF &bounds, const QPainterPath &path);
+	void setColors(const QColor &cold, const QColor &hot);
+	void clear();
+
+private slots:
+	void jobFinished(HeatmapJob *job);
+
+private:
+	struct Raster
+	{
+		Raster() : cell(0), width(0), height(0), generation(-1),
+		  projection(-1) {}
+
+		QRectF rect;
+		qreal cell;
+		int width, height;
+		int generation;
+		int projection;
+		QVector<quint32> grid;
+		QImage image;
+	};
+
+	bool isRunning() const;
+	void runJob(HeatmapJob *job);
+	void cancelJobs(bool wait);
+
+	QList<QPainterPath> _paths;
+	QRectF _bounds;
+	QColor _cold, _hot;
+	/* Incremented on every paths change and on every reprojection */
+	int _generation;
+	int _projection;
+	Raster _raster;
+	QList<HeatmapJob*> _jobs;
+};
+
+#endif // HEATMAPITEM_H
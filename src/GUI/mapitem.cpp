@@ -133,6 +133,9 @@ void MapItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 
+	if (_tiled && !_hover)
+		return;
+
 	painter->setPen(_width ? _pen : QPen(Qt::NoPen));
 	painter->drawPath(_painterPath);
 	painter->fillPath(_painterPath, _brush);
@@ -205,8 +208,20 @@ void MapItem::setDigitalZoom(int zoom)
 	_pen.setWidthF(_width * pow(2, -_digitalZoom));
 }
 
+OverlayPath MapItem::overlayPath() const
+{
+	/* The overlay is only used without digital zoom and never highlighted */
+	QPen pen(_pen);
+	pen.setWidthF(_width);
+
+	return OverlayPath(_painterPath, _width ? pen : QPen(Qt::NoPen), _brush,
+	  zValue());
+}
+
 void MapItem::hover(bool hvr)
 {
+	_hover = hvr;
+
 	if (hvr)
 		_pen.setWidthF((_width + 1) * pow(2, -_digitalZoom));
 	else
@@ -219,6 +234,7 @@ void MapItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = true;
 	_pen.setWidthF((_width + 1) * pow(2, -_digitalZoom));
 	update();
 
@@ -234,6 +250,7 @@ void MapItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = false;
 	_pen.setWidthF(_width * pow(2, -_digitalZoom));
 	update();
 }
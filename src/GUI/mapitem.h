@@ -26,6 +26,7 @@ public:
 	void setWidth(qreal width);
 	void setPenStyle(Qt::PenStyle style);
 	void setDigitalZoom(int zoom);
+	OverlayPath overlayPath() const;
 
 	ToolTip info(bool extended) const;
 
@@ -1,3 +1,4 @@
+#include <limits>
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QWheelEvent>
@@ -23,6 +24,9 @@
 #include "markerinfoitem.h"
 #include "crosshairitem.h"
 #include "motioninfoitem.h"
+#include "collisiongrid.h"
+#include "overlayitem.h"
+#include "heatmapitem.h"
 #include "mapview.h"
 
 
@@ -32,6 +36,8 @@
 #define SCALE_OFFSET     7
 #define COORDINATES_OFFSET SCALE_OFFSET
 #define LEGEND_OFFSET SCALE_OFFSET
+#define POI_GRID_SIZE 64
+#define OVERLAY_RESOLUTION 20
 
 
 MapView::MapView(Map *map, POI *poi, QWidget *parent) : QGraphicsView(parent)
@@ -95,6 +101,16 @@ MapView::MapView(Map *map, POI *poi, QWidget *parent) : QGraphicsView(parent)
 	_legend->setVisible(false);
 	_scene->addItem(_legend);
 
+	_overlay = new OverlayItem();
+	_overlay->setZValue(-std::numeric_limits<qreal>::max());
+	_scene->addItem(_overlay);
+	_overlayGeneration = 0;
+	_overlayTiled = false;
+
+	_heatmap = new HeatmapItem();
+	_heatmap->setVisible(false);
+	_scene->addItem(_heatmap);
+
 	_mapOpacity = 1.0;
 	_backgroundColor = Qt::white;
 	_markerColor = Qt::red;
@@ -122,6 +138,8 @@ MapView::MapView(Map *map, POI *poi, QWidget *parent) : QGraphicsView(parent)
 	_waypointColor = Qt::black;
 	_poiSize = 8;
 	_poiColor = Qt::black;
+	_heatmapColdColor = QColor(0, 0, 255, 128);
+	_heatmapHotColor = Qt::red;
 	_followPosition = false;
 	_showPosition = false;
 	_showPositionCoordinates = false;
@@ -130,6 +148,8 @@ MapView::MapView(Map *map, POI *poi, QWidget *parent) : QGraphicsView(parent)
 
 	_opengl = false;
 	_plot = false;
+	_batch = false;
+	_pendingFit = false;
 	_digitalZoom = 0;
 	_pinchZoom = 0;
 	_wheelDelta = 0;
@@ -189,6 +209,7 @@ PathItem *MapView::addTrack(const Track &track)
 	ti->showMarkerInfo(_markerInfoType);
 	ti->showTicks(_showPathTicks);
 	_scene->addItem(ti);
+	_heatmap->addPath(_scene->sceneRect(), ti->painterPath());
 
 	if (_showTracks) {
 		addPOI(_poi->points(ti->path()));
@@ -306,7 +327,6 @@ MapItem *MapView::addMap(MapAction *map)
 QList<PathItem *> MapView::loadData(const Data &data)
 {
 	QList<PathItem *> paths;
-	int zoom = _map->zoom();
 
 	for (int i = 0; i < data.areas().count(); i++)
 		addArea(data.areas().at(i));
@@ -320,42 +340,51 @@ QList<PathItem *> MapView::loadData(const Data &data)
 	  && _areas.empty())
 		return paths;
 
-	if (fitMapZoom() != zoom)
-		rescale();
+	/* In batch mode, the view is fitted only once at the end of the batch */
+	if (_batch)
+		_pendingFit = true;
 	else
-		updatePOIVisibility();
-
-	centerOn(contentCenter());
+		fitContent();
 
 	return paths;
 }
 
-void MapView::loadMaps(const QList<MapAction *> &maps)
+void MapView::endBatch()
 {
-	int zoom = _map->zoom();
+	_batch = false;
+
+	if (_pendingFit) {
+		_pendingFit = false;
+		fitContent();
+	}
+}
 
+void MapView::loadMaps(const QList<MapAction *> &maps)
+{
 	for (int i = 0; i < maps.size(); i++)
 		addMap(maps.at(i));
 
-	if (fitMapZoom() != zoom)
-		rescale();
-	else
-		updatePOIVisibility();
-
-	centerOn(contentCenter());
+	fitContent();
 }
 
 void MapView::loadDEMs(const QList<Area> &dems)
 {
-	int zoom = _map->zoom();
-
 	for (int i = 0; i < dems.size(); i++)
 		addArea(dems.at(i));
 
+	fitContent();
+}
+
+void MapView::fitContent()
+{
+	int zoom = _map->zoom();
+
 	if (fitMapZoom() != zoom)
 		rescale();
-	else
+	else {
 		updatePOIVisibility();
+		updateOverlay();
+	}
 
 	centerOn(contentCenter());
 }
@@ -375,35 +404,77 @@ QPointF MapView::contentCenter() const
 	return br.isNull() ? sceneRect().center() : _map->ll2xy(br.center());
 }
 
+static bool poiLessThan(const WaypointItem *a, const WaypointItem *b)
+{
+	const QPointF &pa = a->pos();
+	const QPointF &pb = b->pos();
+
+	return (pa.y() == pb.y()) ? (pa.x() < pb.x()) : (pa.y() < pb.y());
+}
+
 void MapView::updatePOIVisibility()
 {
 	if (!_showPOI)
 		return;
 
-	for (POIHash::const_iterator it = _pois.constBegin();
-	  it != _pois.constEnd(); it++)
-		it.value()->show();
-
-	if (!_overlapPOIs) {
+	if (_overlapPOIs) {
 		for (POIHash::const_iterator it = _pois.constBegin();
-		  it != _pois.constEnd(); it++) {
-			for (POIHash::const_iterator jt = _pois.constBegin();
-			  jt != _pois.constEnd(); jt++) {
-				if (it.value()->isVisible() && jt.value()->isVisible()
-				  && it != jt && it.value()->collidesWithItem(jt.value()))
-					jt.value()->hide();
-			}
-		}
+		  it != _pois.constEnd(); it++)
+			it.value()->show();
+		return;
+	}
+
+	/* Only the items in the viewport surroundings are decluttered, the rest
+	   is processed once the view gets close to them. When plotting, the
+	   whole scene is processed. */
+	if (_plot)
+		_poiRect = _scene->sceneRect();
+	else {
+		QRectF vr(mapToScene(viewport()->rect()).boundingRect());
+		_poiRect = vr.adjusted(-vr.width() / 2, -vr.height() / 2,
+		  vr.width() / 2, vr.height() / 2);
+	}
+
+	QList<WaypointItem*> items;
+	for (POIHash::const_iterator it = _pois.constBegin();
+	  it != _pois.constEnd(); it++) {
+		WaypointItem *wi = it.value();
+		if (_poiRect.contains(wi->pos()))
+			items.append(wi);
+		else
+			wi->show();
 	}
+
+	/* Deterministic (position based) priority, the hash order is random */
+	std::sort(items.begin(), items.end(), poiLessThan);
+
+	CollisionGrid grid(POI_GRID_SIZE * pow(2, -_digitalZoom));
+	for (int i = 0; i < items.size(); i++)
+		items.at(i)->setVisible(grid.add(items.at(i)));
+}
+
+void MapView::checkPOIVisibility()
+{
+	if (!_showPOI || _overlapPOIs || _plot)
+		return;
+
+	QRectF vr(mapToScene(viewport()->rect()).boundingRect());
+	if (!_poiRect.contains(vr))
+		updatePOIVisibility();
 }
 
 void MapView::rescale()
 {
+	QList<QPainterPath> heatmap;
+
 	_scene->setSceneRect(_map->bounds());
 	reloadMap();
 
-	for (int i = 0; i < _tracks.size(); i++)
+	/* The heatmap reuses the track paths projected by the track items */
+	for (int i = 0; i < _tracks.size(); i++) {
 		_tracks.at(i)->setMap(_map);
+		heatmap.append(_tracks.at(i)->painterPath());
+	}
 	for (int i = 0; i < _routes.size(); i++)
 		_routes.at(i)->setMap(_map);
 	for (int i = 0; i < _areas.size(); i++)
@@ -416,8 +487,61 @@ void MapView::rescale()
 		it.value()->setMap(_map);
 
 	_crosshair->setMap(_map);
+	_heatmap->setPaths(_scene->sceneRect(), heatmap);
 
 	updatePOIVisibility();
+	updateOverlay();
+}
+
+static bool overlayLessThan(const OverlayPath &a, const OverlayPath &b)
+{
+	return (a.z < b.z);
+}
+
+/* The map resolution changes with the latitude in most projections, so the
+   mode is also re-evaluated when the view is moved */
+bool MapView::isTiled(qreal res) const
+{
+	return (!_plot && !_digitalZoom && res >= OVERLAY_RESOLUTION);
+}
+
+/* The overlay generation changes with the data layers content (paths,
+   styles, visibility), the overlay keeps its tiles otherwise */
+void MapView::updateOverlay(bool changed)
+{
+	QRectF vr(mapToScene(viewport()->rect()).boundingRect());
+	bool tiled = isTiled(_map->resolution(vr));
+	QVector<OverlayPath> paths;
+
+	if (changed)
+		_overlayGeneration++;
+	_overlayTiled = tiled;
+
+	/* At low zoom levels the data layers are rendered into cached tiles
+	   instead of drawing all the paths on every repaint. */
+	for (int i = 0; i < _tracks.size(); i++) {
+		_tracks.at(i)->setTiled(tiled);
+		if (tiled && _tracks.at(i)->isVisible())
+			paths.append(_tracks.at(i)->overlayPath());
+	}
+	for (int i = 0; i < _routes.size(); i++) {
+		_routes.at(i)->setTiled(tiled);
+		if (tiled && _routes.at(i)->isVisible())
+			paths.append(_routes.at(i)->overlayPath());
+	}
+	for (int i = 0; i < _areas.size(); i++) {
+		_areas.at(i)->setTiled(tiled);
+		if (tiled && _areas.at(i)->isVisible())
+			paths.append(_areas.at(i)->overlayPath());
+	}
+
+	if (paths.isEmpty())
+		_overlay->clear();
+	else {
+		std::stable_sort(paths.begin(), paths.end(), overlayLessThan);
+		_overlay->setPaths(_scene->sceneRect(), paths, _deviceRatio,
+		  _overlayGeneration);
+	}
 }
 
 void MapView::setPalette(const Palette &palette)
@@ -433,6 +557,7 @@ void MapView::setPalette(const Palette &palette)
 		_areas.at(i)->setColor(_palette.nextColor());
 
 	updateLegend();
+	updateOverlay();
 }
 
 void MapView::setMap(Map *map)
@@ -612,6 +737,8 @@ void MapView::digitalZoom(int zoom)
 	for (POIHash::const_iterator it = _pois.constBegin();
 	  it != _pois.constEnd(); it++)
 		it.value()->setDigitalZoom(_digitalZoom);
+	updatePOIVisibility();
+	updateOverlay();
 
 	_mapScale->setDigitalZoom(_digitalZoom);
 	_cursorCoordinates->setDigitalZoom(_digitalZoom);
@@ -805,6 +932,8 @@ void MapView::plot(QPainter *painter, const QRectF &target, qreal scale,
 	  LEGEND_OFFSET * p)));
 
 	// Print the view
+	updatePOIVisibility();
+	updateOverlay();
 	render(painter, target, adj.toRect());
 
 	// Revert view changes to display mode
@@ -828,6 +957,8 @@ void MapView::plot(QPainter *painter, const QRectF &target, qreal scale,
 
 	// Exit plot mode
 	_plot = false;
+	updatePOIVisibility();
+	updateOverlay();
 	setUpdatesEnabled(true);
 }
 
@@ -845,6 +976,8 @@ void MapView::clear()
 	_scene->removeItem(_crosshair);
 	_scene->removeItem(_motionInfo);
 	_scene->removeItem(_legend);
+	_scene->removeItem(_overlay);
+	_scene->removeItem(_heatmap);
 	_scene->clear();
 	_scene->addItem(_mapScale);
 	_scene->addItem(_cursorCoordinates);
@@ -853,6 +986,10 @@ void MapView::clear()
 	_scene->addItem(_motionInfo);
 	_legend->clear();
 	_scene->addItem(_legend);
+	_overlay->clear();
+	_scene->addItem(_overlay);
+	_heatmap->clear();
+	_scene->addItem(_heatmap);
 
 	_palette.reset();
 
@@ -860,6 +997,7 @@ void MapView::clear()
 	_rr = RectC();
 	_wr = RectC();
 	_ar = RectC();
+	_pendingFit = false;
 
 	digitalZoom(0);
 
@@ -876,6 +1014,7 @@ void MapView::showTracks(bool show)
 
 	updateLegend();
 	updatePOI();
+	updateOverlay();
 }
 
 void MapView::showRoutes(bool show)
@@ -887,6 +1026,7 @@ void MapView::showRoutes(bool show)
 
 	updateLegend();
 	updatePOI();
+	updateOverlay();
 }
 
 void MapView::showWaypoints(bool show)
@@ -907,6 +1047,12 @@ void MapView::showAreas(bool show)
 		_areas.at(i)->setVisible(show);
 
 	updatePOI();
+	updateOverlay();
+}
+
+void MapView::showHeatmap(bool show)
+{
+	_heatmap->setVisible(show);
 }
 
 void MapView::showWaypointLabels(bool show)
@@ -1051,6 +1197,8 @@ void MapView::setTrackWidth(int width)
 
 	for (int i = 0; i < _tracks.count(); i++)
 		_tracks.at(i)->setWidth(width);
+
+	updateOverlay();
 }
 
 void MapView::setRouteWidth(int width)
@@ -1059,6 +1207,8 @@ void MapView::setRouteWidth(int width)
 
 	for (int i = 0; i < _routes.count(); i++)
 		_routes.at(i)->setWidth(width);
+
+	updateOverlay();
 }
 
 void MapView::setAreaWidth(int width)
@@ -1067,6 +1217,8 @@ void MapView::setAreaWidth(int width)
 
 	for (int i = 0; i < _areas.count(); i++)
 		_areas.at(i)->setWidth(width);
+
+	updateOverlay();
 }
 
 void MapView::setTrackStyle(Qt::PenStyle style)
@@ -1075,6 +1227,8 @@ void MapView::setTrackStyle(Qt::PenStyle style)
 
 	for (int i = 0; i < _tracks.count(); i++)
 		_tracks.at(i)->setPenStyle(style);
+
+	updateOverlay();
 }
 
 void MapView::setRouteStyle(Qt::PenStyle style)
@@ -1083,6 +1237,8 @@ void MapView::setRouteStyle(Qt::PenStyle style)
 
 	for (int i = 0; i < _routes.count(); i++)
 		_routes.at(i)->setPenStyle(style);
+
+	updateOverlay();
 }
 
 void MapView::setAreaStyle(Qt::PenStyle style)
@@ -1091,6 +1247,8 @@ void MapView::setAreaStyle(Qt::PenStyle style)
 
 	for (int i = 0; i < _areas.count(); i++)
 		_areas.at(i)->setPenStyle(style);
+
+	updateOverlay();
 }
 
 void MapView::setAreaOpacity(int opacity)
@@ -1099,6 +1257,8 @@ void MapView::setAreaOpacity(int opacity)
 
 	for (int i = 0; i < _areas.count(); i++)
 		_areas.at(i)->setOpacity(_areaOpacity);
+
+	updateOverlay();
 }
 
 void MapView::setWaypointSize(int size)
@@ -1135,6 +1295,18 @@ void MapView::setPOIColor(const QColor &color)
 		it.value()->setColor(color);
 }
 
+void MapView::setHeatmapColdColor(const QColor &color)
+{
+	_heatmapColdColor = color;
+	_heatmap->setColors(_heatmapColdColor, _heatmapHotColor);
+}
+
+void MapView::setHeatmapHotColor(const QColor &color)
+{
+	_heatmapHotColor = color;
+	_heatmap->setColors(_heatmapColdColor, _heatmapHotColor);
+}
+
 void MapView::setMapOpacity(int opacity)
 {
 	_mapOpacity = opacity / 100.0;
@@ -1228,6 +1400,16 @@ void MapView::scrollContentsBy(int dx, int dy)
 		_mapScale->setResolution(res);
 		_res = res;
 	}
+	if (isTiled(res) != _overlayTiled)
+		updateOverlay(false);
+
+	checkPOIVisibility();
+}
+
+void MapView::resizeEvent(QResizeEvent *event)
+{
+	QGraphicsView::resizeEvent(event);
+	checkPOIVisibility();
 }
 
 void MapView::leaveEvent(QEvent *event)
@@ -1354,6 +1536,7 @@ void MapView::useStyles(bool use)
 		_waypoints.at(i)->updateStyle();
 
 	updateLegend();
+	updateOverlay();
 }
 
 void MapView::setMarkerColor(const QColor &color)
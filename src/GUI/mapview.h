@@ -41,6 +41,8 @@ class QTimeZone;
 class MapAction;
 class CrosshairItem;
 class MotionInfoItem;
+class OverlayItem;
+class HeatmapItem;
 
 class MapView : public QGraphicsView
 {
@@ -57,6 +59,8 @@ public:
 	MapView(Map *map, POI *poi, QWidget *parent = 0);
 
 	QList<PathItem *> loadData(const Data &data);
+	void beginBatch() {_batch = true;}
+	void endBatch();
 	void loadMaps(const QList<MapAction*> &maps);
 	void loadDEMs(const QList<Area> &dems);
 
@@ -87,6 +91,8 @@ public:
 	void setWaypointColor(const QColor &color);
 	void setPOISize(int size);
 	void setPOIColor(const QColor &color);
+	void setHeatmapColdColor(const QColor &color);
+	void setHeatmapHotColor(const QColor &color);
 	void setMapOpacity(int opacity);
 	void setBackgroundColor(const QColor &color);
 	void useOpenGL(bool use);
@@ -125,6 +131,7 @@ public slots:
 	void showTracks(bool show);
 	void showRoutes(bool show);
 	void showAreas(bool show);
+	void showHeatmap(bool show);
 	void showWaypoints(bool show);
 	void showRouteWaypoints(bool show);
 	void setMarkerPosition(qreal pos);
@@ -151,6 +158,7 @@ private:
 	void loadPOI();
 	void clearPOI();
 
+	void fitContent();
 	int fitMapZoom() const;
 	QPointF contentCenter() const;
 	void rescale();
@@ -158,6 +166,9 @@ private:
 	void zoom(int zoom, const QPoint &pos, bool shift);
 	void digitalZoom(int zoom);
 	void updatePOIVisibility();
+	void checkPOIVisibility();
+	void updateOverlay(bool changed = true);
+	bool isTiled(qreal res) const;
 	bool gestureEvent(QGestureEvent *event);
 	void pinchGesture(QPinchGesture *gesture);
 	void skipColor() {_palette.nextColor();}
@@ -173,6 +184,7 @@ private:
 	void drawBackground(QPainter *painter, const QRectF &rect);
 	void paintEvent(QPaintEvent *event);
 	void leaveEvent(QEvent *event);
+	void resizeEvent(QResizeEvent *event);
 
 	bool event(QEvent *event);
 	void scrollContentsBy(int dx, int dy);
@@ -183,11 +195,16 @@ private:
 	CrosshairItem *_crosshair;
 	MotionInfoItem *_motionInfo;
 	LegendItem *_legend;
+	OverlayItem *_overlay;
+	int _overlayGeneration;
+	bool _overlayTiled;
+	HeatmapItem *_heatmap;
 	QList<TrackItem*> _tracks;
 	QList<RouteItem*> _routes;
 	QList<WaypointItem*> _waypoints;
 	QList<PlaneItem*> _areas;
 	POIHash _pois;
+	QRectF _poiRect;
 
 	RectC _tr, _rr, _wr, _ar;
 	qreal _res;
@@ -210,6 +227,7 @@ private:
 	Qt::PenStyle _trackStyle, _routeStyle, _areaStyle;
 	int _waypointSize, _poiSize;
 	QColor _backgroundColor, _waypointColor, _poiColor, _markerColor;
+	QColor _heatmapColdColor, _heatmapHotColor;
 	qreal _areaOpacity;
 	bool _infoBackground;
 
@@ -219,6 +237,7 @@ private:
 
 	int _digitalZoom;
 	bool _plot;
+	bool _batch, _pendingFit;
 	QCursor _cursor;
 
 	qreal _deviceRatio;
@@ -14,6 +14,7 @@
 #include <QSysInfo>
 #include <QButtonGroup>
 #include <QGeoPositionInfoSource>
+#include "common/memorybudget.h"
 #include "map/pcs.h"
 #include "icons.h"
 #include "infolabel.h"
@@ -163,6 +164,11 @@ QWidget *OptionsDialog::createAppearancePage()
 	_areaStyle->setValue(_options.areaStyle);
 	_areaOpacity = new PercentSlider();
 	_areaOpacity->setValue(_options.areaOpacity);
+	// Heatmap
+	_heatmapColdColor = new ColorBox();
+	_heatmapColdColor->setColor(_options.heatmapColdColor);
+	_heatmapHotColor = new ColorBox();
+	_heatmapHotColor->setColor(_options.heatmapHotColor);
 	// Palette & antialiasing
 	_baseColor = new ColorBox();
 	_baseColor->setColor(_options.palette.color());
@@ -184,6 +190,9 @@ QWidget *OptionsDialog::createAppearancePage()
 	pathTabLayout->addRow(tr("Area border style:"), _areaStyle);
 	pathTabLayout->addRow(tr("Area fill opacity:"), _areaOpacity);
 	pathTabLayout->addRow(line());
+	pathTabLayout->addRow(tr("Heatmap low density color:"), _heatmapColdColor);
+	pathTabLayout->addRow(tr("Heatmap high density color:"), _heatmapHotColor);
+	pathTabLayout->addRow(line());
 	pathTabLayout->addRow(tr("Base color:"), _baseColor);
 	pathTabLayout->addRow(tr("Palette shift:"), _colorOffset);
 	pathTabLayout->addRow(line());
@@ -206,6 +215,11 @@ QWidget *OptionsDialog::createAppearancePage()
 	areaLayout->addRow(tr("Opacity:"), _areaOpacity);
 	QGroupBox *areaBox = new QGroupBox(tr("Areas"));
 	areaBox->setLayout(areaLayout);
+	QFormLayout *heatmapLayout = new QFormLayout();
+	heatmapLayout->addRow(tr("Low density color:"), _heatmapColdColor);
+	heatmapLayout->addRow(tr("High density color:"), _heatmapHotColor);
+	QGroupBox *heatmapBox = new QGroupBox(tr("Heatmap"));
+	heatmapBox->setLayout(heatmapLayout);
 	QFormLayout *paletteLayout = new QFormLayout();
 	paletteLayout->addRow(tr("Base color:"), _baseColor);
 	paletteLayout->addRow(tr("Palette shift:"), _colorOffset);
@@ -216,6 +230,7 @@ QWidget *OptionsDialog::createAppearancePage()
 	pathTabLayout->addWidget(trackBox);
 	pathTabLayout->addWidget(routeBox);
 	pathTabLayout->addWidget(areaBox);
+	pathTabLayout->addWidget(heatmapBox);
 	pathTabLayout->addLayout(paletteLayout);
 	pathTabLayout->addLayout(pathAALayout);
 	pathTabLayout->addStretch();
@@ -772,6 +787,10 @@ QWidget *OptionsDialog::createSystemPage()
 	_useOpenGL->setChecked(_options.useOpenGL);
 	_enableHTTP2 = new QCheckBox(tr("Enable HTTP/2"));
 	_enableHTTP2->setChecked(_options.enableHTTP2);
+	_cacheParsedData = new QCheckBox(tr("Cache parsed data files"));
+	_cacheParsedData->setChecked(_options.cacheParsedData);
+	_cacheKMZTiles = new QCheckBox(tr("Cache KMZ overlay tiles on disk"));
+	_cacheKMZTiles->setChecked(_options.cacheKMZTiles);
 
 	_pixmapCache = new QSpinBox();
 	_pixmapCache->setMinimum(64);
@@ -779,11 +798,21 @@ QWidget *OptionsDialog::createSystemPage()
 	_pixmapCache->setSuffix(UNIT_SPACE + tr("MB"));
 	_pixmapCache->setValue(_options.pixmapCache);
 
-	_demCache = new QSpinBox();
-	_demCache->setMinimum(64);
-	_demCache->setMaximum(4096);
-	_demCache->setSuffix(UNIT_SPACE + tr("MB"));
-	_demCache->setValue(_options.demCache);
+	_dataCache = new QSpinBox();
+	_dataCache->setMinimum(64);
+	_dataCache->setMaximum(4096);
+	_dataCache->setSuffix(UNIT_SPACE + tr("MB"));
+	_dataCache->setValue(_options.dataCache);
+
+	QList<MemoryBudget::Stats> stats(MemoryBudget::stats());
+	QStringList statsList;
+	for (int i = 0; i < stats.size(); i++)
+		statsList.append(stats.at(i).name + ": "
+		  + QString::number(stats.at(i).usage / 1048576) + UNIT_SPACE
+		  + tr("MB") + " (" + QString::number(stats.at(i).entries) + ")");
+	QLabel *cacheUsage = new QLabel(QString::number(MemoryBudget::usage()
+	  / 1048576) + UNIT_SPACE + tr("MB"));
+	cacheUsage->setToolTip(statsList.join('\n'));
 
 	_connectionTimeout = new QSpinBox();
 	_connectionTimeout->setMinimum(30);
@@ -795,18 +824,24 @@ QWidget *OptionsDialog::createSystemPage()
 	QWidget *systemTab = new QWidget();
 	QFormLayout *systemTabLayout = new QFormLayout();
 	systemTabLayout->addRow(tr("Image cache size:"), _pixmapCache);
-	systemTabLayout->addRow(tr("DEM cache size:"), _demCache);
+	systemTabLayout->addRow(tr("Data cache size:"), _dataCache);
+	systemTabLayout->addRow(tr("Data cache usage:"), cacheUsage);
 	systemTabLayout->addRow(tr("Connection timeout:"), _connectionTimeout);
 	systemTabLayout->addWidget(_enableHTTP2);
+	systemTabLayout->addWidget(_cacheParsedData);
+	systemTabLayout->addWidget(_cacheKMZTiles);
 	systemTabLayout->addWidget(_useOpenGL);
 	systemTab->setLayout(systemTabLayout);
 #else // Q_OS_MAC
 	QFormLayout *formLayout = new QFormLayout();
 	formLayout->addRow(tr("Image cache size:"), _pixmapCache);
-	formLayout->addRow(tr("DEM cache size:"), _demCache);
+	formLayout->addRow(tr("Data cache size:"), _dataCache);
+	formLayout->addRow(tr("Data cache usage:"), cacheUsage);
 	formLayout->addRow(tr("Connection timeout:"), _connectionTimeout);
 	QFormLayout *checkboxLayout = new QFormLayout();
 	checkboxLayout->addWidget(_enableHTTP2);
+	checkboxLayout->addWidget(_cacheParsedData);
+	checkboxLayout->addWidget(_cacheKMZTiles);
 	checkboxLayout->addWidget(_useOpenGL);
 	QWidget *systemTab = new QWidget();
 	QVBoxLayout *systemTabLayout = new QVBoxLayout();
@@ -947,6 +982,8 @@ void OptionsDialog::accept()
 	_options.areaStyle = (Qt::PenStyle) _areaStyle->itemData(
 	  _areaStyle->currentIndex()).toInt();
 	_options.areaOpacity = _areaOpacity->value();
+	_options.heatmapColdColor = _heatmapColdColor->color();
+	_options.heatmapHotColor = _heatmapHotColor->color();
 	_options.waypointSize = _waypointSize->value();
 	_options.waypointColor = _waypointColor->color();
 	_options.poiSize = _poiSize->value();
@@ -1009,8 +1046,10 @@ void OptionsDialog::accept()
 
 	_options.useOpenGL = _useOpenGL->isChecked();
 	_options.enableHTTP2 = _enableHTTP2->isChecked();
+	_options.cacheParsedData = _cacheParsedData->isChecked();
+	_options.cacheKMZTiles = _cacheKMZTiles->isChecked();
 	_options.pixmapCache = _pixmapCache->value();
-	_options.demCache = _demCache->value();
+	_options.dataCache = _dataCache->value();
 	_options.connectionTimeout = _connectionTimeout->value();
 	_options.dataPath = _dataPath->dir();
 	_options.mapsPath = _mapsPath->dir();
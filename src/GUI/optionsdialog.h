@@ -34,6 +34,8 @@ struct Options {
 	int areaOpacity;
 	QColor waypointColor;
 	QColor poiColor;
+	QColor heatmapColdColor;
+	QColor heatmapHotColor;
 	int waypointSize;
 	int poiSize;
 	int graphWidth;
@@ -85,8 +87,10 @@ struct Options {
 	// System
 	bool useOpenGL;
 	bool enableHTTP2;
+	bool cacheParsedData;
+	bool cacheKMZTiles;
 	int pixmapCache;
-	int demCache;
+	int dataCache;
 	int connectionTimeout;
 	QString dataPath;
 	QString mapsPath;
@@ -144,6 +148,8 @@ private:
 	QSpinBox *_areaWidth;
 	StyleComboBox *_areaStyle;
 	PercentSlider *_areaOpacity;
+	ColorBox *_heatmapColdColor;
+	ColorBox *_heatmapHotColor;
 	QCheckBox *_pathAA;
 	QSpinBox *_waypointSize;
 	ColorBox *_waypointColor;
@@ -196,10 +202,12 @@ private:
 	PluginParameters *_pluginParameters;
 	// System
 	QSpinBox *_pixmapCache;
-	QSpinBox *_demCache;
+	QSpinBox *_dataCache;
 	QSpinBox *_connectionTimeout;
 	QCheckBox *_useOpenGL;
 	QCheckBox *_enableHTTP2;
+	QCheckBox *_cacheParsedData;
+	QCheckBox *_cacheKMZTiles;
 	DirSelectWidget *_dataPath;
 	DirSelectWidget *_mapsPath;
 	DirSelectWidget *_poiPath;
@@ -0,0 +1,242 @@
+#include <cmath>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QStyleOptionGraphicsItem>
+#include "overlayitem.h"
+
+#define TILE_SIZE 256
+
+int OverlayItem::_ids = 0;
+
+static void drawPath(QPainter *painter, const OverlayPath &p,
+  const QPainterPath &path)
+{
+	painter->setPen(p.pen);
+	painter->drawPath(path);
+	if (p.brush.style() != Qt::NoBrush)
+		painter->fillPath(path, p.brush);
+}
+
+static void drawPaths(QPainter *painter, const QVector<OverlayPath> &paths,
+  const QRectF &rect)
+{
+	painter->setBrush(Qt::NoBrush);
+
+	for (int i = 0; i < paths.size(); i++) {
+		const OverlayPath &p = paths.at(i);
+		if (p.rect.intersects(rect))
+			drawPath(painter, p, p.path);
+	}
+}
+
+/* QPainter caches data in the (shared) path when drawing it, so the path
+   itself is only drawn in the GUI thread. The render threads only read the
+   path elements and draw their own copy of the path. */
+static QPainterPath copyPath(const QPainterPath &path)
+{
+	QPainterPath copy;
+
+	copy.setFillRule(path.fillRule());
+	for (int i = 0; i < path.elementCount(); i++) {
+		const QPainterPath::Element &e = path.elementAt(i);
+
+		if (e.isMoveTo())
+			copy.moveTo(e);
+		else if (e.isLineTo())
+			copy.lineTo(e);
+		else if (e.isCurveTo() && i + 2 < path.elementCount()) {
+			copy.cubicTo(e, path.elementAt(i + 1), path.elementAt(i + 2));
+			i += 2;
+		}
+	}
+
+	return copy;
+}
+
+static bool isEmpty(const QVector<OverlayPath> &paths, const QRectF &rect)
+{
+	for (int i = 0; i < paths.size(); i++)
+		if (paths.at(i).rect.intersects(rect))
+			return false;
+
+	return true;
+}
+
+static QRect tileRect(const QPoint &xy)
+{
+	return QRect(xy.x() * TILE_SIZE, xy.y() * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+}
+
+OverlayPath::OverlayPath(const QPainterPath &path, const QPen &pen,
+  const QBrush &brush, qreal z) : path(path), pen(pen), brush(brush), z(z)
+{
+	qreal pw = (pen.style() == Qt::NoPen) ? 0 : pen.widthF() / 2.0;
+
+	rect = path.boundingRect().adjusted(-pw, -pw, pw, pw);
+}
+
+void OverlayTile::render()
+{
+	QRect rect(tileRect(_xy));
+
+	_img = QImage(rect.size() * _ratio, QImage::Format_ARGB32_Premultiplied);
+	_img.setDevicePixelRatio(_ratio);
+	_img.fill(Qt::transparent);
+
+	QPainter painter(&_img);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.translate(-rect.topLeft());
+	painter.setBrush(Qt::NoBrush);
+
+	for (int i = 0; i < _paths.size(); i++) {
+		const OverlayPath &p = _paths.at(i);
+		if (p.rect.intersects(rect))
+			drawPath(&painter, p, copyPath(p.path));
+	}
+}
+
+OverlayItem::OverlayItem(QGraphicsItem *parent) : QGraphicsItem(parent)
+{
+	_ratio = 1.0;
+	_generation = -1;
+	_id = ++_ids;
+
+	setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+	setAcceptedMouseButtons(Qt::NoButton);
+}
+
+OverlayItem::~OverlayItem()
+{
+	cancelJobs(true);
+	qDeleteAll(_jobs);
+}
+
+QString OverlayItem::key(const QPoint &xy) const
+{
+	return "overlay-" + QString::number(_id) + "_" + QString::number(xy.x())
+	  + "_" + QString::number(xy.y());
+}
+
+bool OverlayItem::isRunning(const QPoint &xy) const
+{
+	for (int i = 0; i < _jobs.size(); i++) {
+		const QList<OverlayTile> &tiles = _jobs.at(i)->tiles();
+		for (int j = 0; j < tiles.size(); j++) {
+			const OverlayTile &t = tiles.at(j);
+			if (t.id() == _id && t.xy() == xy)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void OverlayItem::runJob(OverlayJob *job)
+{
+	_jobs.append(job);
+
+	connect(job, &OverlayJob::finished, this, &OverlayItem::jobFinished);
+	job->run();
+}
+
+void OverlayItem::jobFinished(OverlayJob *job)
+{
+	const QList<OverlayTile> &tiles = job->tiles();
+
+	for (int i = 0; i < tiles.size(); i++) {
+		const OverlayTile &t = tiles.at(i);
+		if (t.id() == _id && !t.image().isNull())
+			QPixmapCache::insert(key(t.xy()), QPixmap::fromImage(t.image()));
+	}
+
+	_jobs.removeOne(job);
+	job->deleteLater();
+
+	update();
+}
+
+void OverlayItem::cancelJobs(bool wait)
+{
+	for (int i = 0; i < _jobs.size(); i++)
+		_jobs.at(i)->cancel(wait);
+}
+
+void OverlayItem::setPaths(const QRectF &bounds,
+  const QVector<OverlayPath> &paths, qreal ratio, int generation)
+{
+	/* Keep the rendered tiles when nothing has changed */
+	if (bounds == _bounds && ratio == _ratio && generation == _generation)
+		return;
+
+	cancelJobs(false);
+
+	prepareGeometryChange();
+	_bounds = bounds;
+	_paths = paths;
+	_ratio = ratio;
+	_generation = generation;
+	_id = ++_ids;
+
+	update();
+}
+
+void OverlayItem::clear()
+{
+	if (_paths.isEmpty() && _bounds.isNull())
+		return;
+
+	cancelJobs(false);
+
+	prepareGeometryChange();
+	_bounds = QRectF();
+	_paths.clear();
+	_generation = -1;
+	_id = ++_ids;
+}
+
+void OverlayItem::paint(QPainter *painter,
+  const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+	Q_UNUSED(widget);
+
+	QRectF rect(option->exposedRect.intersected(_bounds));
+	if (_paths.isEmpty() || rect.isEmpty())
+		return;
+
+	int left = (int)floor(rect.left() / TILE_SIZE);
+	int top = (int)floor(rect.top() / TILE_SIZE);
+	int right = (int)floor(rect.right() / TILE_SIZE);
+	int bottom = (int)floor(rect.bottom() / TILE_SIZE);
+	QList<OverlayTile> tiles;
+	QRegion missing;
+
+	for (int y = top; y <= bottom; y++) {
+		for (int x = left; x <= right; x++) {
+			QPoint xy(x, y);
+			QRect tr(tileRect(xy));
+			QPixmap pm;
+
+			if (isEmpty(_paths, tr))
+				continue;
+
+			if (QPixmapCache::find(key(xy), &pm))
+				painter->drawPixmap(tr.topLeft(), pm);
+			else {
+				missing += tr;
+				if (!isRunning(xy))
+					tiles.append(OverlayTile(_paths, _id, xy, _ratio));
+			}
+		}
+	}
+
+	/* Tiles that are not yet rendered are drawn directly */
+	if (!missing.isEmpty()) {
+		painter->save();
+		painter->setClipRegion(missing, Qt::IntersectClip);
+		drawPaths(painter, _paths, missing.boundingRect());
+		painter->restore();
+	}
+
+	if (!tiles.isEmpty())
+		runJob(new OverlayJob(tiles));
+}
@@ -0,0 +1,122 @@
+#ifndef OVERLAYITEM_H
+#define OVERLAYITEM_H
+
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <QPen>
+#include <QImage>
+#include <QtConcurrent>
+
+struct OverlayPath
+{
+	OverlayPath() : z(0) {}
+	OverlayPath(const QPainterPath &path, const QPen &pen, const QBrush &brush,
+	  qreal z);
+
+	QPainterPath path;
+	QPen pen;
+	QBrush brush;
+	QRectF rect;
+	qreal z;
+};
+
+class OverlayTile
+{
+public:
+	OverlayTile() : _id(0), _ratio(1.0) {}
+	OverlayTile(const QVector<OverlayPath> &paths, int id, const QPoint &xy,
+	  qreal ratio) : _paths(paths), _id(id), _xy(xy), _ratio(ratio) {}
+
+	int id() const {return _id;}
+	const QPoint &xy() const {return _xy;}
+	const QImage &image() const {return _img;}
+
+	void render();
+
+private:
+	QVector<OverlayPath> _paths;
+	int _id;
+	QPoint _xy;
+	qreal _ratio;
+	QImage _img;
+};
+
+class OverlayJob : public QObject
+{
+	Q_OBJECT
+
+public:
+	OverlayJob(const QList<OverlayTile> &tiles) : _tiles(tiles) {}
+
+	void run()
+	{
+		connect(&_watcher, &QFutureWatcher<void>::finished, this,
+		  &OverlayJob::handleFinished);
+		_future = QtConcurrent::map(_tiles, &OverlayTile::render);
+		_watcher.setFuture(_future);
+	}
+	void cancel(bool wait)
+	{
+		_future.cancel();
+		if (wait)
+			_future.waitForFinished();
+	}
+	const QList<OverlayTile> &tiles() const {return _tiles;}
+
+signals:
+	void finished(OverlayJob *job);
+
+private slots:
+	void handleFinished() {emit finished(this);}
+
+private:
+	QFutureWatcher<void> _watcher;
+	QFuture<void> _future;
+	QList<OverlayTile> _tiles;
+};
+
+/*
+  Raster cache of the data layers (tracks, routes, areas). The paths of the
+  "tiled" items are rendered into tiles in background threads and the tiles
+  are then drawn like map tiles. Tiles not yet rendered are drawn directly
+  from the paths.
+*/
+class OverlayItem : public QObject, public QGraphicsItem
+{
+	Q_OBJECT
+
+public:
+	OverlayItem(QGraphicsItem *parent = 0);
+	~OverlayItem();
+
+	QPainterPath shape() const {return QPainterPath();}
+	QRectF boundingRect() const {return _bounds;}
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+	  QWidget *widget);
+
+	/* The generation identifies the paths content, the tiles are kept when
+	   it does not change */
+	void setPaths(const QRectF &bounds, const QVector<OverlayPath> &paths,
+	  qreal ratio, int generation);
+	void clear();
+
+private slots:
+	void jobFinished(OverlayJob *job);
+
+private:
+	QString key(const QPoint &xy) const;
+	bool isRunning(const QPoint &xy) const;
+	void runJob(OverlayJob *job);
+	void cancelJobs(bool wait);
+
+	QRectF _bounds;
+	QVector<OverlayPath> _paths;
+	qreal _ratio;
+	int _generation;
+	int _id;
+	QList<OverlayJob*> _jobs;
+
+	static int _ids;
+};
+
+#endif // OVERLAYITEM_H
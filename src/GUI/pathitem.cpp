@@ -37,6 +37,8 @@ PathItem::PathItem(const Path &path, Map *map, QGraphicsItem *parent)
 	_showMarker = true;
 	_showTicks = false;
 	_markerInfoType = MarkerInfoItem::None;
+	_tiled = false;
+	_hover = false;
 
 	_pen = QPen(color(), width());
 
@@ -140,6 +142,10 @@ void PathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 
+	/* Tiled paths are drawn by the overlay item unless highlighted */
+	if (_tiled && !_hover)
+		return;
+
 	painter->setPen(_pen);
 	painter->drawPath(_painterPath);
 
@@ -390,6 +396,8 @@ void PathItem::drawMarkerBackground(bool draw)
 
 void PathItem::hover(bool hvr)
 {
+	_hover = hvr;
+
 	if (hvr) {
 		_pen.setWidth((width() + 1) * pow(2, -_digitalZoom));
 		setZValue(zValue() + 1.0);
@@ -407,6 +415,25 @@ void PathItem::hoverAll(bool hvr)
 	emit selected(hvr);
 }
 
+void PathItem::setTiled(bool tiled)
+{
+	if (_tiled == tiled)
+		return;
+
+	_tiled = tiled;
+	update();
+}
+
+OverlayPath PathItem::overlayPath() const
+{
+	/* The overlay is only used without digital zoom and never highlighted */
+	QPen pen(_pen);
+	pen.setWidthF(width());
+
+	return OverlayPath(_painterPath, pen, QBrush(),
+	  _hover ? zValue() - 1.0 : zValue());
+}
+
 void PathItem::showMarker(bool show)
 {
 	if (_showMarker == show)
@@ -509,6 +536,7 @@ void PathItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = true;
 	_pen.setWidthF((width() + 1) * pow(2, -_digitalZoom));
 	setZValue(zValue() + 1.0);
 	update();
@@ -520,6 +548,7 @@ void PathItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
 	Q_UNUSED(event);
 
+	_hover = false;
 	_pen.setWidthF(width() * pow(2, -_digitalZoom));
 	setZValue(zValue() - 1.0);
 	update();
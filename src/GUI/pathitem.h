@@ -8,6 +8,7 @@
 #include "graphicsscene.h"
 #include "markerinfoitem.h"
 #include "format.h"
+#include "overlayitem.h"
 #include "units.h"
 
 class Map;
@@ -32,6 +33,7 @@ public:
 	const QString &file() const {return _file;}
 	const QString &name() const {return _name;}
 	const Path &path() const {return _path;}
+	const QPainterPath &painterPath() const {return _painterPath;}
 	const QColor &color() const;
 
 	void addGraph(GraphItem *graph);
@@ -49,6 +51,7 @@ public:
 	void showMarker(bool show);
 	void showMarkerInfo(MarkerInfoItem::Type type);
 	void showTicks(bool show);
+	void setTiled(bool tiled);
 
 	void setMarkerPosition(qreal pos);
 
@@ -56,6 +59,8 @@ public:
 	void updateMarkerInfo();
 	void updateStyle();
 
+	OverlayPath overlayPath() const;
+
 	static void setUnits(Units units) {_units = units;}
 	static void setTimeZone(const QTimeZone &zone) {_timeZone = zone;}
 
@@ -118,6 +123,8 @@ private:
 	MarkerInfoItem::Type _markerInfoType;
 	qreal _markerDistance;
 	int _digitalZoom;
+	bool _tiled;
+	bool _hover;
 };
 
 #endif // PATHITEM_H
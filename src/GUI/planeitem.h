@@ -3,6 +3,7 @@
 
 #include "common/rectc.h"
 #include "graphicsscene.h"
+#include "overlayitem.h"
 
 class Map;
 
@@ -11,7 +12,8 @@ class PlaneItem : public QObject, public GraphicsItem
 	Q_OBJECT
 
 public:
-	PlaneItem(GraphicsItem *parent = 0) : GraphicsItem(parent) {}
+	PlaneItem(GraphicsItem *parent = 0)
+	  : GraphicsItem(parent), _tiled(false), _hover(false) {}
 
 	virtual RectC bounds() const = 0;
 	virtual void setMap(Map *map) = 0;
@@ -22,12 +24,25 @@ public:
 	virtual void setPenStyle(Qt::PenStyle style) = 0;
 	virtual void setDigitalZoom(int zoom) = 0;
 	virtual void updateStyle() {}
+	virtual OverlayPath overlayPath() const = 0;
+
+	void setTiled(bool tiled)
+	{
+		if (_tiled == tiled)
+			return;
+		_tiled = tiled;
+		update();
+	}
 
 	virtual const QColor color() const = 0;
 	virtual const QString &name() const = 0;
 
 public slots:
 	virtual void hover(bool hvr) = 0;
+
+protected:
+	bool _tiled;
+	bool _hover;
 };
 
 #endif // PLANEITEM_H
@@ -34,10 +34,10 @@
 
 #ifdef Q_OS_ANDROID
 #define PIXMAP_CACHE 384
-#define DEM_CACHE    128
+#define DATA_CACHE   256
 #else // Q_OS_ANDROID
 #define PIXMAP_CACHE 512
-#define DEM_CACHE    256
+#define DATA_CACHE   512
 #endif // Q_OS_ANDROID
 
 
@@ -166,6 +166,7 @@ SETTING(tracks,              "tracks",                 true                   );
 SETTING(routes,              "routes",                 true                   );
 SETTING(waypoints,           "waypoints",              true                   );
 SETTING(areas,               "areas",                  true                   );
+SETTING(heatmap,             "heatmap",                false                  );
 SETTING(routeWaypoints,      "routeWaypoints",         true                   );
 SETTING(waypointIcons,       "waypointIcons",          false                  );
 SETTING(waypointLabels,      "waypointLabels",         true                   );
@@ -223,6 +224,8 @@ SETTING(waypointSize,        "waypointSize",           8                      );
 SETTING(waypointColor,       "waypointColor",          QColor(Qt::black)      );
 SETTING(poiSize,             "poiSize",                8                      );
 SETTING(poiColor,            "poiColor",               QColor(Qt::black)      );
+SETTING(heatmapColdColor,    "heatmapColdColor",       QColor(0, 0, 255, 128) );
+SETTING(heatmapHotColor,     "heatmapHotColor",        QColor(Qt::red)        );
 SETTING(graphWidth,          "graphWidth",             1                      );
 SETTING(pathAntiAliasing,    "pathAntiAliasing",       true                   );
 SETTING(graphAntiAliasing,   "graphAntiAliasing",      true                   );
@@ -255,8 +258,12 @@ SETTING(hillshadingAltitude, "hillshadingAltitude",    45                     );
 SETTING(hillshadingZFactor,  "hillshadingZFactor",     0.8                    );
 SETTING(useOpenGL,           "useOpenGL",              false                  );
 SETTING(enableHTTP2,         "enableHTTP2",            true                   );
+SETTING(cacheParsedData,     "cacheParsedData",        false                  );
+SETTING(cacheKMZTiles,       "cacheKMZTiles",          false                  );
 SETTING(pixmapCache,         "pixmapCache",            PIXMAP_CACHE           );
-SETTING(demCache,            "demCache",               DEM_CACHE              );
+SETTING(dataCache,           "dataCache",              DATA_CACHE             );
+/* Legacy, replaced by dataCache */
+SETTING(demCache,            "demCache",               DATA_CACHE             );
 SETTING(connectionTimeout,   "connectionTimeout",      30                     );
 SETTING(hiresPrint,          "hiresPrint",             false                  );
 SETTING(printName,           "printName",              true                   );
@@ -36,6 +36,10 @@ public:
 		{
 			return settings.value(_name, _defVal);
 		}
+		QVariant read(const QSettings &settings, const Setting &legacy) const
+		{
+			return settings.value(_name, legacy.read(settings));
+		}
 
 	private:
 		QString _name;
@@ -117,6 +121,7 @@ public:
 	static const Setting routes;
 	static const Setting waypoints;
 	static const Setting areas;
+	static const Setting heatmap;
 	static const Setting routeWaypoints;
 	static const Setting waypointIcons;
 	static const Setting waypointLabels;
@@ -174,6 +179,8 @@ public:
 	static const Setting waypointColor;
 	static const Setting poiSize;
 	static const Setting poiColor;
+	static const Setting heatmapColdColor;
+	static const Setting heatmapHotColor;
 	static const Setting graphWidth;
 	static const Setting pathAntiAliasing;
 	static const Setting graphAntiAliasing;
@@ -206,7 +213,10 @@ public:
 	static const Setting hillshadingZFactor;
 	static const Setting useOpenGL;
 	static const Setting enableHTTP2;
+	static const Setting cacheParsedData;
+	static const Setting cacheKMZTiles;
 	static const Setting pixmapCache;
+	static const Setting dataCache;
 	static const Setting demCache;
 	static const Setting connectionTimeout;
 	static const Setting hiresPrint;
@@ -0,0 +1,95 @@
+#include "compactpath.h"
+
+static inline double X(const QPointF &p) {return p.x();}
+static inline double Y(const QPointF &p) {return p.y();}
+static inline double X(const Coordinates &c) {return c.lon();}
+static inline double Y(const Coordinates &c) {return c.lat();}
+
+static void writeVInt(QByteArray &data, qint64 val)
+{
+	quint64 u = ((quint64)val << 1) ^ (quint64)(val >> 63);
+
+	while (u >= 0x80) {
+		data.append((char)(u | 0x80));
+		u >>= 7;
+	}
+	data.append((char)u);
+}
+
+static inline qint64 readVInt(const char *&cp)
+{
+	quint64 u = 0;
+	int shift = 0;
+	quint8 b;
+
+	do {
+		b = (quint8)*cp++;
+		u |= (quint64)(b & 0x7F) << shift;
+		shift += 7;
+	} while (b & 0x80);
+
+	return (qint64)(u >> 1) ^ -(qint64)(u & 1);
+}
+
+template <class T>
+static void encode(const QVector<T> &points, const T &origin, double scale,
+  QByteArray &data)
+{
+	qint64 px = 0, py = 0;
+
+	data.reserve(points.size() * 6);
+
+	for (int i = 0; i < points.size(); i++) {
+		const T &p = points.at(i);
+		qint64 x = qRound64((X(p) - X(origin)) * scale);
+		qint64 y = qRound64((Y(p) - Y(origin)) * scale);
+
+		writeVInt(data, x - px);
+		writeVInt(data, y - py);
+
+		px = x;
+		py = y;
+	}
+
+	data.squeeze();
+}
+
+template <class T>
+static QVector<T> decode(const QByteArray &data, int size, const T &origin,
+  double scale)
+{
+	QVector<T> points(size);
+	const char *cp = data.constData();
+	qint64 x = 0, y = 0;
+
+	for (int i = 0; i < size; i++) {
+		x += readVInt(cp);
+		y += readVInt(cp);
+		points[i] = T(X(origin) + x / scale, Y(origin) + y / scale);
+	}
+
+	return points;
+}
+
+CompactPath::CompactPath(const QVector<QPointF> &points, const QPointF &origin,
+  double scale) : _size(points.size())
+{
+	encode(points, origin, scale, _data);
+}
+
+CompactPath::CompactPath(const QVector<Coordinates> &points,
+  const Coordinates &origin, double scale) : _size(points.size())
+{
+	encode(points, origin, scale, _data);
+}
+
+QVector<QPointF> CompactPath::points(const QPointF &origin, double scale) const
+{
+	return decode(_data, _size, origin, scale);
+}
+
+QVector<Coordinates> CompactPath::points(const Coordinates &origin,
+  double scale) const
+{
+	return decode(_data, _size, origin, scale);
+}
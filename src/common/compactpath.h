@@ -0,0 +1,39 @@
+#ifndef COMPACTPATH_H
+#define COMPACTPATH_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QPointF>
+#include "coordinates.h"
+
+/*
+  Compact storage of point sequences (lines, polygon rings) for the map data
+  caches. The points are converted to fixed-point integer coordinates
+  relative to an origin (scale = units per degree, chosen to match the
+  precision of the source format so the conversion is lossless) and stored
+  as zigzag/varint encoded deltas - usually 2-4 bytes per point instead of
+  the 16 bytes of a QPointF/Coordinates.
+*/
+class CompactPath
+{
+public:
+	CompactPath() : _size(0) {}
+	CompactPath(const QVector<QPointF> &points, const QPointF &origin,
+	  double scale);
+	CompactPath(const QVector<Coordinates> &points, const Coordinates &origin,
+	  double scale);
+
+	int size() const {return _size;}
+	bool isEmpty() const {return !_size;}
+	/* Heap memory used by the encoded data */
+	qint64 cost() const {return _data.capacity();}
+
+	QVector<QPointF> points(const QPointF &origin, double scale) const;
+	QVector<Coordinates> points(const Coordinates &origin, double scale) const;
+
+private:
+	QByteArray _data;
+	int _size;
+};
+
+#endif // COMPACTPATH_H
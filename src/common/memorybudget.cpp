@@ -0,0 +1,184 @@
+#include <QMutex>
+#include <QVector>
+#include <QAtomicInteger>
+#include "memorybudget.h"
+
+#define DEFAULT_LIMIT 268435456 // 256MB
+
+namespace {
+struct CacheEntry {
+	CacheEntry() : cache(0), entries(0), usage(0) {}
+	CacheEntry(MemoryBudget::Cache *cache)
+	  : cache(cache), entries(0), usage(0) {}
+
+	MemoryBudget::Cache *cache;
+	int entries;
+	qint64 usage;
+};
+
+struct Registry {
+	Registry() : limit(DEFAULT_LIMIT), total(0), stamp(0) {}
+
+	int indexOf(const MemoryBudget::Cache *cache) const
+	{
+		for (int i = 0; i < caches.size(); i++)
+			if (caches.at(i).cache == cache)
+				return i;
+		return -1;
+	}
+
+	QMutex lock;
+	QList<CacheEntry> caches;
+	qint64 limit;
+	qint64 total;
+	QAtomicInteger<quint64> stamp;
+};
+}
+
+/* Function-local static as caches may be static objects themselves (DEM) */
+static Registry &registry()
+{
+	static Registry r;
+	return r;
+}
+
+/* Evicts the least recently used entries of all the caches that can be locked
+   until the total usage fits the limit. The self cache (if any) is already
+   locked by the caller. Must be called with the registry lock held. */
+static void trim(Registry &r, MemoryBudget::Cache *self)
+{
+	QVector<bool> locked(r.caches.size());
+
+	for (int i = 0; i < r.caches.size(); i++) {
+		MemoryBudget::Cache *c = r.caches.at(i).cache;
+		locked[i] = (c == self) ? true : c->tryLock();
+	}
+
+	while (r.total > r.limit) {
+		int lru = -1;
+		quint64 lruStamp = 0;
+
+		for (int i = 0; i < r.caches.size(); i++) {
+			if (!locked.at(i))
+				continue;
+			quint64 stamp = r.caches.at(i).cache->oldest();
+			if (stamp && (lru < 0 || stamp < lruStamp)) {
+				lru = i;
+				lruStamp = stamp;
+			}
+		}
+		if (lru < 0)
+			break;
+
+		CacheEntry &e = r.caches[lru];
+		qint64 cost = e.cache->evict();
+		e.entries--;
+		e.usage -= cost;
+		r.total -= cost;
+	}
+
+	for (int i = 0; i < r.caches.size(); i++) {
+		MemoryBudget::Cache *c = r.caches.at(i).cache;
+		if (locked.at(i) && c != self)
+			c->unlock();
+	}
+}
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+	r.limit = bytes;
+	if (r.total > r.limit)
+		trim(r, 0);
+	r.lock.unlock();
+}
+
+qint64 MemoryBudget::limit()
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+	qint64 limit = r.limit;
+	r.lock.unlock();
+
+	return limit;
+}
+
+qint64 MemoryBudget::usage()
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+	qint64 total = r.total;
+	r.lock.unlock();
+
+	return total;
+}
+
+QList<MemoryBudget::Stats> MemoryBudget::stats()
+{
+	Registry &r = registry();
+	QList<Stats> list;
+
+	r.lock.lock();
+	for (int i = 0; i < r.caches.size(); i++) {
+		const CacheEntry &e = r.caches.at(i);
+		Stats s;
+		s.name = e.cache->name();
+		s.entries = e.entries;
+		s.usage = e.usage;
+		list.append(s);
+	}
+	r.lock.unlock();
+
+	return list;
+}
+
+void MemoryBudget::add(Cache *cache)
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+	r.caches.append(CacheEntry(cache));
+	r.lock.unlock();
+}
+
+void MemoryBudget::remove(Cache *cache)
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+	int idx = r.indexOf(cache);
+	if (idx >= 0) {
+		r.total -= r.caches.at(idx).usage;
+		r.caches.removeAt(idx);
+	}
+	r.lock.unlock();
+}
+
+void MemoryBudget::charge(Cache *cache, qint64 cost, int entries)
+{
+	Registry &r = registry();
+
+	r.lock.lock();
+
+	int idx = r.indexOf(cache);
+	if (idx >= 0) {
+		CacheEntry &e = r.caches[idx];
+		e.entries += entries;
+		e.usage += cost;
+		r.total += cost;
+
+		if (cost > 0 && r.total > r.limit)
+			trim(r, cache);
+	}
+
+	r.lock.unlock();
+}
+
+quint64 MemoryBudget::stamp()
+{
+	return registry().stamp.fetchAndAddRelaxed(1) + 1;
+}
@@ -0,0 +1,64 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QString>
+#include <QList>
+
+/*
+  Global memory budget shared by all the map and data caches. The caches
+  register themselves, report the byte costs of their entries and when the
+  total usage exceeds the limit, the least recently used entries across all
+  the caches are evicted.
+
+  A cache may only be evicted by a "foreign" thread when its lock can be
+  acquired (tryLock), so the objects returned from a cache stay valid as long
+  as the cache lock is held.
+*/
+class MemoryBudget
+{
+public:
+	class Cache
+	{
+	public:
+		Cache(const QString &name) : _name(name) {}
+		virtual ~Cache() {}
+
+		const QString &name() const {return _name;}
+
+		virtual bool tryLock() = 0;
+		virtual void unlock() = 0;
+
+		/* The following functions are called by the budget manager with the
+		   cache lock held (or from the charge() call of the cache itself) */
+
+		/* Usage stamp of the least recently used entry that may be evicted
+		   or zero if there is no such entry */
+		virtual quint64 oldest() const = 0;
+		/* Removes the least recently used entry and returns its cost */
+		virtual qint64 evict() = 0;
+
+	private:
+		QString _name;
+	};
+
+	struct Stats {
+		Stats() : entries(0), usage(0) {}
+
+		QString name;
+		int entries;
+		qint64 usage;
+	};
+
+	static void setLimit(qint64 bytes);
+	static qint64 limit();
+	static qint64 usage();
+	static QList<Stats> stats();
+
+	static void add(Cache *cache);
+	static void remove(Cache *cache);
+	static void charge(Cache *cache, qint64 cost, int entries);
+
+	static quint64 stamp();
+};
+
+#endif // MEMORYBUDGET_H
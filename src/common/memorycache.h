@@ -0,0 +1,158 @@
+#ifndef MEMORYCACHE_H
+#define MEMORYCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include "memorybudget.h"
+
+/*
+  QCache-like LRU cache with byte costs and the total size limited by the
+  global MemoryBudget. The lock is the mutex guarding all the cache accesses
+  (and usage of the returned objects) in the cache user code and must outlive
+  the cache. The most recently used entry is never evicted by the budget
+  manager, so an object stays valid right after its insert() call even when
+  it exceeds the budget on its own.
+*/
+template <class Key, class T>
+class MemoryCache : public MemoryBudget::Cache
+{
+public:
+	MemoryCache(const QString &name, QMutex *lock)
+	  : MemoryBudget::Cache(name), _lock(lock), _first(0), _last(0), _usage(0)
+	  {MemoryBudget::add(this);}
+	~MemoryCache()
+	{
+		MemoryBudget::remove(this);
+		deleteAll();
+	}
+
+	T *object(const Key &key)
+	{
+		typename QHash<Key, Node*>::const_iterator it(_hash.constFind(key));
+		if (it == _hash.constEnd())
+			return 0;
+
+		Node *n = *it;
+		n->stamp = MemoryBudget::stamp();
+		unlink(n);
+		link(n);
+
+		return n->t;
+	}
+	bool contains(const Key &key) const {return _hash.contains(key);}
+	void insert(const Key &key, T *object, qint64 cost)
+	{
+		remove(key);
+
+		Node *n = new Node(key, object, cost, MemoryBudget::stamp());
+		_hash.insert(key, n);
+		link(n);
+		_usage += cost;
+
+		MemoryBudget::charge(this, cost, 1);
+	}
+	bool remove(const Key &key)
+	{
+		Node *n = _hash.take(key);
+		if (!n)
+			return false;
+
+		qint64 cost = n->cost;
+		unlink(n);
+		delete n->t;
+		delete n;
+		_usage -= cost;
+
+		MemoryBudget::charge(this, -cost, -1);
+
+		return true;
+	}
+	void clear()
+	{
+		qint64 usage = _usage;
+		int count = _hash.size();
+
+		deleteAll();
+
+		MemoryBudget::charge(this, -usage, -count);
+	}
+
+	int size() const {return _hash.size();}
+	qint64 totalCost() const {return _usage;}
+
+	bool tryLock() {return _lock->tryLock();}
+	void unlock() {_lock->unlock();}
+	quint64 oldest() const
+	  {return (_last && _last != _first) ? _last->stamp : 0;}
+	qint64 evict()
+	{
+		Node *n = _last;
+		qint64 cost = n->cost;
+
+		unlink(n);
+		_hash.remove(n->key);
+		delete n->t;
+		delete n;
+		_usage -= cost;
+
+		return cost;
+	}
+
+private:
+	struct Node {
+		Node(const Key &key, T *t, qint64 cost, quint64 stamp)
+		  : key(key), t(t), cost(cost), stamp(stamp), prev(0), next(0) {}
+
+		Key key;
+		T *t;
+		qint64 cost;
+		quint64 stamp;
+		Node *prev, *next;
+	};
+
+	MemoryCache(const MemoryCache &);
+	MemoryCache &operator=(const MemoryCache &);
+
+	void link(Node *n)
+	{
+		n->prev = 0;
+		n->next = _first;
+		if (_first)
+			_first->prev = n;
+		_first = n;
+		if (!_last)
+			_last = n;
+	}
+	void unlink(Node *n)
+	{
+		if (n->prev)
+			n->prev->next = n->next;
+		else
+			_first = n->next;
+		if (n->next)
+			n->next->prev = n->prev;
+		else
+			_last = n->prev;
+	}
+	void deleteAll()
+	{
+		for (Node *n = _first; n;) {
+			Node *next = n->next;
+			delete n->t;
+			delete n;
+			n = next;
+		}
+
+		_hash.clear();
+		_first = 0;
+		_last = 0;
+		_usage = 0;
+	}
+
+	QMutex *_lock;
+	QHash<Key, Node*> _hash;
+	Node *_first, *_last;
+	qint64 _usage;
+};
+
+#endif // MEMORYCACHE_H
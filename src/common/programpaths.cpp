@@ -9,6 +9,7 @@
 #define CRS_DIR          "CRS"
 #define DEM_DIR          "DEM"
 #define TILES_DIR        "tiles"
+#define PARSE_CACHE_DIR  "data"
 #define TRANSLATIONS_DIR "translations"
 #define STYLE_DIR        "style"
 #define SYMBOLS_DIR      "symbols"
@@ -17,6 +18,7 @@
 #define PROJECTIONS_FILE "projections.csv"
 #define GCS_FILE         "gcs.csv"
 #define PCS_FILE         "pcs.csv"
+#define MAP_CATALOG_FILE "maps.cat"
 
 #ifdef Q_OS_ANDROID
 #define DATA_LOCATION QStandardPaths::GenericDataLocation
@@ -122,6 +124,12 @@ QString ProgramPaths::tilesDir()
 	  QStandardPaths::CacheLocation)).filePath(TILES_DIR);
 }
 
+QString ProgramPaths::parseCacheDir()
+{
+	return QDir(QStandardPaths::writableLocation(
+	  QStandardPaths::CacheLocation)).filePath(PARSE_CACHE_DIR);
+}
+
 QString ProgramPaths::translationsDir()
 {
 #ifdef Q_OS_ANDROID
@@ -156,3 +164,9 @@ QString ProgramPaths::pcsFile()
 	QString dir(crsDir());
 	return dir.isEmpty() ? QString() : QDir(crsDir()).filePath(PCS_FILE);
 }
+
+QString ProgramPaths::mapCatalogFile()
+{
+	return QDir(QStandardPaths::writableLocation(
+	  QStandardPaths::CacheLocation)).filePath(MAP_CATALOG_FILE);
+}
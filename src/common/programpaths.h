@@ -12,12 +12,14 @@ namespace ProgramPaths
 	QString styleDir(bool writable = false);
 	QString symbolsDir(bool writable = false);
 	QString tilesDir();
+	QString parseCacheDir();
 	QString translationsDir();
 
 	QString ellipsoidsFile();
 	QString gcsFile();
 	QString projectionsFile();
 	QString pcsFile();
+	QString mapCatalogFile();
 }
 
 #endif // PROGRAMPATHS_H
@@ -27,6 +27,7 @@
 #include "vtkparser.h"
 #include "vkxparser.h"
 #include "gpmfparser.h"
+#include "parsecache.h"
 #include "data.h"
 
 
@@ -99,6 +100,7 @@ static QMultiMap<QString, Parser*> parsers()
 }
 
 QMultiMap<QString, Parser*> Data::_parsers = parsers();
+bool Data::_useCache = false;
 
 void Data::processData(QList<TrackData> &trackData, QList<RouteData> &routeData)
 {
@@ -123,12 +125,22 @@ Data::Data(const QString &fileName, bool tryUnknown)
 		return;
 	}
 
+	if (_useCache && ParseCache::load(fileName, trackData, routeData,
+	  _polygons, _waypoints)) {
+		processData(trackData, routeData);
+		_valid = true;
+		return;
+	}
+
 	QMultiMap<QString, Parser*>::iterator it;
 	QString suffix(fi.suffix().toLower());
 	if ((it = _parsers.find(suffix)) != _parsers.end()) {
 		while (it != _parsers.end() && it.key() == suffix) {
 			if (it.value()->parse(&file, trackData, routeData, _polygons,
 			  _waypoints)) {
+				if (_useCache)
+					ParseCache::save(fileName, trackData, routeData, _polygons,
+					  _waypoints);
 				processData(trackData, routeData);
 				_valid = true;
 				return;
@@ -150,6 +162,9 @@ Data::Data(const QString &fileName, bool tryUnknown)
 		for (it = _parsers.begin(); it != _parsers.end(); it++) {
 			if (it.value()->parse(&file, trackData, routeData, _polygons,
 			  _waypoints)) {
+				if (_useCache)
+					ParseCache::save(fileName, trackData, routeData, _polygons,
+					  _waypoints);
 				processData(trackData, routeData);
 				_valid = true;
 				return;
@@ -28,6 +28,8 @@ public:
 	static QString formats();
 	static QStringList filter();
 
+	static void useCache(bool use) {_useCache = use;}
+
 private:
 	void processData(QList<TrackData> &trackData, QList<RouteData> &routeData);
 
@@ -41,6 +43,7 @@ private:
 	QVector<Waypoint> _waypoints;
 
 	static QMultiMap<QString, Parser*> _parsers;
+	static bool _useCache;
 };
 
 #endif // DATA_H
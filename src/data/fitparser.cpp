@@ -1,3 +1,4 @@
+#include <cstring>
 #include <QtEndian>
 #include <QTimeZone>
 #include "GUI/format.h"
@@ -13,6 +14,24 @@
 
 #define TIMESTAMP   253
 
+#define FIT_EPOCH   631065600
+
+/* Compiled field value types */
+enum {SInt8, UInt8, SInt16, UInt16, SInt32, UInt32, String};
+
+/* Compiled field targets - the data the fields are decoded into */
+enum {
+	Timestamp,
+	RecordLat, RecordLon, RecordElevation, RecordHeartRate, RecordCadence,
+	RecordSpeed, RecordPower, RecordTemperature,
+	EventId, EventType, EventData,
+	CoursePointTime, CoursePointLat, CoursePointLon, CoursePointType,
+	CoursePointName,
+	LocationName, LocationLat, LocationLon, LocationSymbol, LocationElevation,
+	LocationDescription,
+	LapEvent, LapEventType, LapLat, LapLon, LapTime, LapTrigger
+};
+
 static QMap<int, QString> coursePointSymbolsInit()
 {
 	QMap<int, QString> map;
@@ -91,292 +110,361 @@ static QMap<int, QString> coursePointSymbols = coursePointSymbolsInit();
 static QMap<int, QString> locationPointSymbols = locationPointSymbolsInit();
 
 
-bool FITParser::readData(QFile *file, char *data, size_t size)
-{
-	qint64 n;
-
-	n = file->read(data, size);
-	if (n < 0) {
-		_errorString = "I/O error";
-		return false;
-	} else if ((size_t)n < size) {
-		_errorString = "Premature end of data";
-		return false;
-	}
-
-	return true;
-}
-
-template<class T> bool FITParser::readValue(CTX &ctx, T &val)
-{
-	if (!readData(ctx.file, (char*)&val, sizeof(T)))
-		return false;
-
-	ctx.len -= sizeof(T);
-	if (sizeof(T) > 1)
-		val = (ctx.endian) ? qFromBigEndian(val) : qFromLittleEndian(val);
-
-	return true;
-}
-
-bool FITParser::skipValue(CTX &ctx, quint8 size)
-{
-	ctx.len -= size;
-	return ctx.file->seek(ctx.file->pos() + size);
-}
-
-bool FITParser::parseDefinitionMessage(CTX &ctx, quint8 header)
+static int valueType(quint8 type, quint8 size)
 {
-	MessageDefinition *def = &(ctx.defs[header & 0x0f]);
-	quint8 numFields;
-
-	def->fields.clear();
-	def->devFields.clear();
-
-	// reserved/unused
-	if (!skipValue(ctx, 1))
-		return false;
-
-	// endianness
-	if (!readValue(ctx, def->endian))
-		return false;
-	if (def->endian > 1) {
-		_errorString = "Bad endian field";
-		return false;
-	}
-	ctx.endian = def->endian;
-
-	// global message number
-	if (!readValue(ctx, def->globalId))
-		return false;
-
-	// definition records
-	if (!readValue(ctx, numFields))
-		return false;
-
-	def->fields.resize(numFields);
-	for (int i = 0; i < def->fields.size(); i++) {
-		if (!readData(ctx.file, (char*)&(def->fields[i]), sizeof(Field)))
-			return false;
-		ctx.len -= sizeof(Field);
-	}
-
-	// developer definition records
-	if (header & 0x20) {
-		if (!readValue(ctx, numFields))
-			return false;
-
-		def->devFields.resize(numFields);
-		for (int i = 0; i < def->devFields.size(); i++) {
-			if (!readData(ctx.file, (char*)&(def->devFields[i]), sizeof(Field)))
-				return false;
-			ctx.len -= sizeof(Field);
-		}
-	}
-
-	return true;
-}
-
-bool FITParser::readField(CTX &ctx, const Field *field, QVariant &val,
-  bool &valid)
-{
-	bool ret;
-
-#define VAL(type, inval) \
-	{type var; \
-	if (field->size == sizeof(var)) { \
-		ret = readValue(ctx, var); \
-		val = var; \
-		valid = (var != (inval)); \
-	} else { \
-		ret = skipValue(ctx, field->size); \
-		valid = false; \
-	}}
-
-	switch (field->type) {
+	switch (type) {
 		case 1: // sint8
-			VAL(qint8, 0x7fU);
-			break;
+			return (size == 1) ? SInt8 : -1;
 		case 2: // uint8
 		case 0: // enum
-			VAL(quint8, 0xffU);
-			break;
+			return (size == 1) ? UInt8 : -1;
 		case 3:
 		case 0x83: // sint16
-			VAL(qint16, 0x7fffU);
-			break;
+			return (size == 2) ? SInt16 : -1;
 		case 4:
 		case 0x84: // uint16
-			VAL(quint16, 0xffffU);
-			break;
+			return (size == 2) ? UInt16 : -1;
 		case 5:
 		case 0x85: // sint32
-			VAL(qint32, 0x7fffffffU);
-			break;
+			return (size == 4) ? SInt32 : -1;
 		case 6:
 		case 0x86: // uint32
-			VAL(quint32, 0xffffffffU);
-			break;
+			return (size == 4) ? UInt32 : -1;
 		case 7: // UTF8 nul terminated string
-			{QByteArray ba(ctx.file->read(field->size));
-			ctx.len -= field->size;
-			ret = (ba.size() == field->size);
-			val = ret ? QString(ba.left(ba.indexOf('\0'))) : QString();
-			valid = (!ba.isEmpty() && ba.at(0) != 0);}
-			break;
+			return String;
 		default:
-			ret = skipValue(ctx, field->size);
-			valid = false;
-			break;
+			return -1;
 	}
-
-	return ret;
 }
 
-bool FITParser::parseData(CTX &ctx, const MessageDefinition *def)
+static int fieldTarget(quint16 globalId, quint8 id)
 {
-	QVariant val;
-	bool valid;
-	Lap lap;
-	Event event;
-	Waypoint waypoint;
+	if (id == TIMESTAMP)
+		return Timestamp;
 
-	if (!def->fields.size() && !def->devFields.size()) {
-		_errorString = "Undefined data message";
-		return false;
-	}
-
-	ctx.endian = def->endian;
-
-	for (int i = 0; i < def->fields.size(); i++) {
-		const Field *field = &def->fields.at(i);
-		if (!readField(ctx, field, val, valid))
-			return false;
-		if (!valid)
-			continue;
-
-		if (field->id == TIMESTAMP)
-			ctx.timestamp = val.toUInt();
-		else if (def->globalId == RECORD) {
-			switch (field->id) {
+	switch (globalId) {
+		case RECORD:
+			switch (id) {
 				case 0:
-					ctx.trackpoint.rcoordinates().setLat(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return RecordLat;
 				case 1:
-					ctx.trackpoint.rcoordinates().setLon(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return RecordLon;
 				case 2:
-					ctx.trackpoint.setElevation((val.toUInt() / 5.0) - 500);
-					break;
+				case 78:
+					return RecordElevation;
 				case 3:
-					ctx.trackpoint.setHeartRate(val.toUInt());
-					break;
+					return RecordHeartRate;
 				case 4:
-					ctx.trackpoint.setCadence(val.toUInt());
-					break;
+					return RecordCadence;
 				case 6:
-					ctx.trackpoint.setSpeed(val.toUInt() / 1000.0f);
-					break;
+				case 73:
+					return RecordSpeed;
 				case 7:
-					ctx.trackpoint.setPower(val.toUInt());
-					break;
+					return RecordPower;
 				case 13:
-					ctx.trackpoint.setTemperature(val.toInt());
-					break;
-				case 73:
-					ctx.trackpoint.setSpeed(val.toUInt() / 1000.0f);
-					break;
-				case 78:
-					ctx.trackpoint.setElevation((val.toUInt() / 5.0) - 500);
-					break;
+					return RecordTemperature;
 			}
-		} else if (def->globalId == EVENT) {
-			switch (field->id) {
+			break;
+		case EVENT:
+			switch (id) {
 				case 0:
-					event.id = val.toUInt();
-					break;
+					return EventId;
 				case 1:
-					event.type = val.toUInt();
-					break;
+					return EventType;
 				case 3:
-					event.data = val.toUInt();
-					break;
+					return EventData;
 			}
-		} else if (def->globalId == COURSEPOINT) {
-			switch (field->id) {
+			break;
+		case COURSEPOINT:
+			switch (id) {
 				case 1:
-					waypoint.setTimestamp(QDateTime::fromSecsSinceEpoch(
-					  val.toUInt() + 631065600, QTimeZone::utc()));
-					break;
+					return CoursePointTime;
 				case 2:
-					waypoint.rcoordinates().setLat(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return CoursePointLat;
 				case 3:
-					waypoint.rcoordinates().setLon(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return CoursePointLon;
 				case 5:
-					waypoint.setSymbol(coursePointSymbols.value(val.toUInt()));
-					break;
+					return CoursePointType;
 				case 6:
-					waypoint.setName(val.toString());
-					break;
+					return CoursePointName;
 			}
-		} else if (def->globalId == LOCATION) {
-			switch (field->id) {
+			break;
+		case LOCATION:
+			switch (id) {
 				case 0:
-					waypoint.setName(val.toString());
-					break;
+					return LocationName;
 				case 1:
-					waypoint.rcoordinates().setLat(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return LocationLat;
 				case 2:
-					waypoint.rcoordinates().setLon(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return LocationLon;
 				case 3:
-					waypoint.setSymbol(locationPointSymbols.value(val.toUInt()));
-					break;
+					return LocationSymbol;
 				case 4:
-					waypoint.setElevation((val.toUInt() / 5.0) - 500);
-					break;
+					return LocationElevation;
 				case 6:
-					waypoint.setDescription(val.toString());
-					break;
+					return LocationDescription;
 			}
-		} else if (def->globalId == LAP) {
-			switch (field->id) {
+			break;
+		case LAP:
+			switch (id) {
 				case 0:
-					lap.event = val.toUInt();
-					break;
+					return LapEvent;
 				case 1:
-					lap.eventType = val.toUInt();
-					break;
+					return LapEventType;
 				case 5:
-					waypoint.rcoordinates().setLat(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return LapLat;
 				case 6:
-					waypoint.rcoordinates().setLon(
-					  (val.toInt() / (double)0x7fffffff) * 180);
-					break;
+					return LapLon;
 				case 7:
-					waypoint.setDescription(Format::timeSpan(val.toUInt() / 1000));
-					break;
+					return LapTime;
 				case 24:
-					lap.trigger = val.toInt();
-					break;
+					return LapTrigger;
 			}
-		}
+			break;
 	}
 
-	for (int i = 0; i < def->devFields.size(); i++)
-		if (!readField(ctx, &def->devFields.at(i), val, valid))
+	return -1;
+}
+
+template<class T> static T read(const char *data, quint8 endian)
+{
+	return endian ? qFromBigEndian<T>(data) : qFromLittleEndian<T>(data);
+}
+
+static bool value(quint8 type, quint8 size, const char *data, quint8 endian,
+  qint64 &val)
+{
+	switch (type) {
+		case SInt8:
+			val = (qint8)*data;
+			return (val != 0x7f);
+		case UInt8:
+			val = (quint8)*data;
+			return (val != 0xff);
+		case SInt16:
+			val = read<qint16>(data, endian);
+			return (val != 0x7fff);
+		case UInt16:
+			val = read<quint16>(data, endian);
+			return (val != 0xffff);
+		case SInt32:
+			val = read<qint32>(data, endian);
+			return (val != 0x7fffffff);
+		case UInt32:
+			val = read<quint32>(data, endian);
+			return (val != 0xffffffff);
+		default:
+			val = 0;
+			return (size && *data);
+	}
+}
+
+static QString string(quint8 type, quint8 size, const char *data, qint64 val)
+{
+	return (type == String)
+	  ? QString::fromUtf8(data, qstrnlen(data, size)) : QString::number(val);
+}
+
+static double semicircles(qint64 val)
+{
+	return ((qint32)val / (double)0x7fffffff) * 180;
+}
+
+static QDateTime timestamp(quint32 val)
+{
+	return QDateTime::fromSecsSinceEpoch(val + FIT_EPOCH, QTimeZone::utc());
+}
+
+
+bool FITParser::available(CTX &ctx, size_t size)
+{
+	if ((size_t)(ctx.end - ctx.ptr) < size) {
+		_errorString = "Premature end of data";
+		return false;
+	}
+
+	return true;
+}
+
+void FITParser::compile(MessageDefinition *def, const Field *fields,
+  int count)
+{
+	for (int i = 0; i < count; i++) {
+		const Field &f = fields[i];
+		int target = fieldTarget(def->globalId, f.id);
+		int type = valueType(f.type, f.size);
+
+		if (target >= 0 && type >= 0)
+			def->fields.append(Decoder(def->size, f.size, type, target));
+		def->size += f.size;
+	}
+}
+
+bool FITParser::parseDefinitionMessage(CTX &ctx, quint8 header)
+{
+	MessageDefinition *def = &(ctx.defs[header & 0x0f]);
+	const Field *fields;
+	quint8 numFields, numDevFields = 0;
+
+	def->fields.clear();
+	def->size = 0;
+
+	// reserved/unused, endianness, global message number, number of fields
+	if (!available(ctx, 5))
+		return false;
+	def->endian = ctx.ptr[1];
+	if (def->endian > 1) {
+		_errorString = "Bad endian field";
+		return false;
+	}
+	def->globalId = read<quint16>(ctx.ptr + 2, def->endian);
+	numFields = ctx.ptr[4];
+	ctx.ptr += 5;
+
+	// definition records
+	if (!available(ctx, numFields * sizeof(Field)))
+		return false;
+	fields = (const Field*)ctx.ptr;
+	ctx.ptr += numFields * sizeof(Field);
+	compile(def, fields, numFields);
+
+	// developer definition records, only their size is of interest
+	if (header & 0x20) {
+		if (!available(ctx, 1))
 			return false;
+		numDevFields = *ctx.ptr++;
+
+		if (!available(ctx, numDevFields * sizeof(Field)))
+			return false;
+		fields = (const Field*)ctx.ptr;
+		ctx.ptr += numDevFields * sizeof(Field);
+		for (int i = 0; i < numDevFields; i++)
+			def->size += fields[i].size;
+	}
+
+	def->defined = (numFields || numDevFields);
+
+	return true;
+}
+
+bool FITParser::parseData(CTX &ctx, const MessageDefinition *def)
+{
+	const char *data = ctx.ptr;
+	qint64 val;
+	Lap lap;
+	Event event;
+	Waypoint waypoint;
+
+	if (!def->defined) {
+		_errorString = "Undefined data message";
+		return false;
+	}
+	if (!available(ctx, def->size))
+		return false;
+	ctx.ptr += def->size;
+
+	for (int i = 0; i < def->fields.size(); i++) {
+		const Decoder &dec = def->fields.at(i);
+		const char *fp = data + dec.offset;
+
+		if (!value(dec.type, dec.size, fp, def->endian, val))
+			continue;
+
+		switch (dec.target) {
+			case Timestamp:
+				ctx.timestamp = (quint32)val;
+				break;
+
+			case RecordLat:
+				ctx.trackpoint.rcoordinates().setLat(semicircles(val));
+				break;
+			case RecordLon:
+				ctx.trackpoint.rcoordinates().setLon(semicircles(val));
+				break;
+			case RecordElevation:
+				ctx.trackpoint.setElevation(((quint32)val / 5.0) - 500);
+				break;
+			case RecordHeartRate:
+				ctx.trackpoint.setHeartRate((quint32)val);
+				break;
+			case RecordCadence:
+				ctx.trackpoint.setCadence((quint32)val);
+				break;
+			case RecordSpeed:
+				ctx.trackpoint.setSpeed((quint32)val / 1000.0f);
+				break;
+			case RecordPower:
+				ctx.trackpoint.setPower((quint32)val);
+				break;
+			case RecordTemperature:
+				ctx.trackpoint.setTemperature((qint32)val);
+				break;
+
+			case EventId:
+				event.id = val;
+				break;
+			case EventType:
+				event.type = val;
+				break;
+			case EventData:
+				event.data = val;
+				break;
+
+			case CoursePointTime:
+				waypoint.setTimestamp(timestamp(val));
+				break;
+			case CoursePointLat:
+				waypoint.rcoordinates().setLat(semicircles(val));
+				break;
+			case CoursePointLon:
+				waypoint.rcoordinates().setLon(semicircles(val));
+				break;
+			case CoursePointType:
+				waypoint.setSymbol(coursePointSymbols.value(val));
+				break;
+			case CoursePointName:
+				waypoint.setName(string(dec.type, dec.size, fp, val));
+				break;
+
+			case LocationName:
+				waypoint.setName(string(dec.type, dec.size, fp, val));
+				break;
+			case LocationLat:
+				waypoint.rcoordinates().setLat(semicircles(val));
+				break;
+			case LocationLon:
+				waypoint.rcoordinates().setLon(semicircles(val));
+				break;
+			case LocationSymbol:
+				waypoint.setSymbol(locationPointSymbols.value(val));
+				break;
+			case LocationElevation:
+				waypoint.setElevation(((quint32)val / 5.0) - 500);
+				break;
+			case LocationDescription:
+				waypoint.setDescription(string(dec.type, dec.size, fp, val));
+				break;
+
+			case LapEvent:
+				lap.event = val;
+				break;
+			case LapEventType:
+				lap.eventType = val;
+				break;
+			case LapLat:
+				waypoint.rcoordinates().setLat(semicircles(val));
+				break;
+			case LapLon:
+				waypoint.rcoordinates().setLon(semicircles(val));
+				break;
+			case LapTime:
+				waypoint.setDescription(Format::timeSpan((quint32)val / 1000));
+				break;
+			case LapTrigger:
+				lap.trigger = val;
+				break;
+		}
+	}
 
 	if (def->globalId == EVENT) {
 		if ((event.id == 42 || event.id == 43) && event.type == 3) {
@@ -386,8 +474,7 @@ bool FITParser::parseData(CTX &ctx, const MessageDefinition *def)
 		}
 	} else if (def->globalId == RECORD) {
 		if (ctx.trackpoint.coordinates().isValid()) {
-			ctx.trackpoint.setTimestamp(QDateTime::fromSecsSinceEpoch(
-			  ctx.timestamp + 631065600, QTimeZone::utc()));
+			ctx.trackpoint.setTimestamp(timestamp(ctx.timestamp));
 			ctx.trackpoint.setRatio(ctx.ratio);
 			if (!ctx.segment) {
 				ctx.track.append(SegmentData());
@@ -401,8 +488,7 @@ bool FITParser::parseData(CTX &ctx, const MessageDefinition *def)
 			ctx.waypoints.append(waypoint);
 	} else if (def->globalId == LOCATION) {
 		if (waypoint.coordinates().isValid()) {
-			waypoint.setTimestamp(QDateTime::fromSecsSinceEpoch(ctx.timestamp
-			  + 631065600, QTimeZone::utc()));
+			waypoint.setTimestamp(timestamp(ctx.timestamp));
 			ctx.waypoints.append(waypoint);
 		}
 	} else if (def->globalId == LAP) {
@@ -411,8 +497,7 @@ bool FITParser::parseData(CTX &ctx, const MessageDefinition *def)
 				waypoint.setName("Finish");
 			else
 				waypoint.setName("Lap " + QString::number(++ctx.laps));
-			waypoint.setTimestamp(QDateTime::fromSecsSinceEpoch(ctx.timestamp
-			  + 631065600, QTimeZone::utc()));
+			waypoint.setTimestamp(timestamp(ctx.timestamp));
 			if (lap.trigger != 7 || ctx.laps > 1)
 				ctx.waypoints.append(waypoint);
 		}
@@ -440,10 +525,7 @@ bool FITParser::parseCompressedMessage(CTX &ctx, quint8 header)
 
 bool FITParser::parseRecord(CTX &ctx)
 {
-	quint8 header;
-
-	if (!readValue(ctx, header))
-		return false;
+	quint8 header = *ctx.ptr++;
 
 	if (header & 0x80)
 		return parseCompressedMessage(ctx, header);
@@ -453,27 +535,26 @@ bool FITParser::parseRecord(CTX &ctx)
 		return parseDataMessage(ctx, header);
 }
 
-bool FITParser::parseHeader(CTX &ctx)
+bool FITParser::parseHeader(CTX &ctx, const char *data, qint64 size)
 {
 	FileHeader hdr;
-	quint16 crc;
-	qint64 len;
 
-	len = ctx.file->read((char*)&hdr, sizeof(hdr));
-	if (len < 0) {
-		_errorString = "I/O error";
+	if (size < (qint64)sizeof(hdr)) {
+		_errorString = "Not a FIT file";
 		return false;
-	} else if ((size_t)len < sizeof(hdr)
-	  || hdr.magic != qToLittleEndian((quint32)FIT_MAGIC)) {
+	}
+	memcpy(&hdr, data, sizeof(hdr));
+	if (hdr.magic != qToLittleEndian((quint32)FIT_MAGIC)) {
 		_errorString = "Not a FIT file";
 		return false;
 	}
 
-	ctx.len = qFromLittleEndian(hdr.dataSize);
-
-	if (hdr.headerSize > sizeof(hdr))
-		if (!readData(ctx.file, (char *)&crc, sizeof(crc)))
-			return false;
+	ctx.ptr = data + qMax((size_t)hdr.headerSize, sizeof(hdr));
+	ctx.end = ctx.ptr + qFromLittleEndian(hdr.dataSize);
+	if (ctx.ptr > data + size || ctx.end > data + size) {
+		_errorString = "Premature end of data";
+		return false;
+	}
 
 	return true;
 }
@@ -483,17 +564,42 @@ bool FITParser::parse(QFile *file, QList<TrackData> &tracks,
 {
 	Q_UNUSED(routes);
 	Q_UNUSED(polygons);
-	CTX ctx(file, waypoints);
+	CTX ctx(waypoints);
+	QByteArray ba;
+	qint64 size = file->size();
+	bool ret = true;
+
+	/* Map the whole file into memory if possible (regular files), otherwise
+	   read it in one shot. The records are then decoded in place. */
+	const char *data = (const char*)file->map(0, size);
+	bool mapped = (data != 0);
+	if (!mapped) {
+		ba = file->readAll();
+		if (ba.size() != size) {
+			_errorString = "I/O error";
+			return false;
+		}
+		data = ba.constData();
+	}
 
-	if (!parseHeader(ctx))
-		return false;
+	if (!parseHeader(ctx, data, size))
+		ret = false;
+	else {
+		while (ctx.ptr < ctx.end) {
+			if (!parseRecord(ctx)) {
+				ret = false;
+				break;
+			}
+		}
+	}
 
-	while (ctx.len)
-		if (!parseRecord(ctx))
-			return false;
+	if (mapped)
+		file->unmap((uchar*)data);
 
-	tracks.append(ctx.track);
-	tracks.last().setFile(file->fileName());
+	if (ret) {
+		tracks.append(ctx.track);
+		tracks.last().setFile(file->fileName());
+	}
 
-	return true;
+	return ret;
 }
@@ -48,25 +48,37 @@ private:
 		quint8 size;
 		quint8 type;
 	};
+	struct Decoder
+	{
+		Decoder() : offset(0), size(0), type(0), target(0) {}
+		Decoder(quint16 offset, quint8 size, quint8 type, quint8 target)
+		  : offset(offset), size(size), type(type), target(target) {}
+
+		quint16 offset;
+		quint8 size;
+		quint8 type;
+		quint8 target;
+	};
 	struct MessageDefinition
 	{
-		MessageDefinition() : globalId(0), endian(0) {}
+		MessageDefinition() : size(0), globalId(0), endian(0), defined(false)
+		  {}
 
-		QVector<Field> fields;
-		QVector<Field> devFields;
+		QVector<Decoder> fields;
+		quint32 size;
 		quint16 globalId;
 		quint8 endian;
+		bool defined;
 	};
 	struct CTX {
-		CTX(QFile *file, QVector<Waypoint> &waypoints)
-		  : file(file), waypoints(waypoints), len(0), endian(0), timestamp(0),
-		  ratio(NAN), laps(0), segment(false) {}
+		CTX(QVector<Waypoint> &waypoints)
+		  : ptr(0), end(0), waypoints(waypoints), timestamp(0), ratio(NAN),
+		  laps(0), segment(false) {}
 
-		QFile *file;
+		const char *ptr;
+		const char *end;
 		QVector<Waypoint> &waypoints;
 		TrackData track;
-		quint32 len;
-		quint8 endian;
 		quint32 timestamp;
 		MessageDefinition defs[16];
 		qreal ratio;
@@ -75,12 +87,10 @@ private:
 		bool segment;
 	};
 
-	bool readData(QFile *file, char *data, size_t size);
-	template<class T> bool readValue(CTX &ctx, T &val);
-	bool skipValue(CTX &ctx, quint8 size);
-	bool readField(CTX &ctx, const Field *field, QVariant &val, bool &valid);
+	bool available(CTX &ctx, size_t size);
+	void compile(MessageDefinition *def, const Field *fields, int count);
 
-	bool parseHeader(CTX &ctx);
+	bool parseHeader(CTX &ctx, const char *data, qint64 size);
 	bool parseRecord(CTX &ctx);
 	bool parseDefinitionMessage(CTX &ctx, quint8 header);
 	bool parseCompressedMessage(CTX &ctx, quint8 header);
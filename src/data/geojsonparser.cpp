@@ -1,3 +1,4 @@
+#include <cstring>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include "map/crs.h"
@@ -147,13 +148,13 @@ static void setSegmentProperties(SegmentData &segment, int segno,
 						QJsonArray seg(times.at(segno).toArray());
 						if (seg.size() == segment.size()) {
 							for (int i = 0; i < seg.size(); i++)
-								segment[i].setTimestamp(timestamp(seg.at(i)));
+								segment.setTimestamp(i, timestamp(seg.at(i)));
 						}
 					}
 				} else {
 					if (times.size() == segment.size()) {
 						for (int i = 0; i < times.size(); i++)
-							segment[i].setTimestamp(timestamp(times.at(i)));
+							segment.setTimestamp(i, timestamp(times.at(i)));
 					}
 				}
 			}
@@ -165,13 +166,13 @@ static void setSegmentProperties(SegmentData &segment, int segno,
 						QJsonArray seg(heart.at(segno).toArray());
 						if (seg.size() == segment.size()) {
 							for (int i = 0; i < seg.size(); i++)
-								segment[i].setHeartRate(hr(seg.at(i)));
+								segment.setHeartRate(i, hr(seg.at(i)));
 						}
 					}
 				} else {
 					if (heart.size() == segment.size()) {
 						for (int i = 0; i < heart.size(); i++)
-							segment[i].setHeartRate(hr(heart.at(i)));
+							segment.setHeartRate(i, hr(heart.at(i)));
 					}
 				}
 			}
@@ -180,6 +181,8 @@ static void setSegmentProperties(SegmentData &segment, int segno,
 }
 
 
+#define RS 0x1E
+
 static bool isWS(char c)
 {
 	return (c == 0x20 || c == 0x09 || c == 0x0A || c == 0x0D) ? true : false;
@@ -190,7 +193,7 @@ static bool possiblyJSONObject(QFile *file)
 	char c;
 
 	while (file->getChar(&c)) {
-		if (isWS(c))
+		if (isWS(c) || c == RS)
 			continue;
 		else if (c == '{')
 			return true;
@@ -201,6 +204,125 @@ static bool possiblyJSONObject(QFile *file)
 	return false;
 }
 
+/*
+ * Streaming support. The file is only scanned for the JSON structure and the
+ * feature collections are processed feature by feature, so only the DOM of
+ * a single feature exists at a time.
+ */
+struct JSONMember {
+	const char *key, *keyEnd;
+	const char *value, *valueEnd;
+};
+
+static void skipWS(const char *&cp, const char *ep)
+{
+	while (cp < ep && isWS(*cp))
+		cp++;
+}
+
+static bool skipString(const char *&cp, const char *ep)
+{
+	for (cp++; cp < ep; cp++) {
+		if (*cp == '\\')
+			cp++;
+		else if (*cp == '"') {
+			cp++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool skipValue(const char *&cp, const char *ep)
+{
+	int depth = 0;
+
+	do {
+		if (cp >= ep)
+			return false;
+
+		switch (*cp) {
+			case '"':
+				if (!skipString(cp, ep))
+					return false;
+				break;
+			case '{':
+			case '[':
+				depth++;
+				cp++;
+				break;
+			case '}':
+			case ']':
+				if (!depth)
+					return false;
+				depth--;
+				cp++;
+				break;
+			default:
+				if (depth)
+					cp++;
+				else {
+					while (cp < ep && !isWS(*cp) && *cp != ',' && *cp != '}'
+					  && *cp != ']')
+						cp++;
+					return true;
+				}
+		}
+	} while (depth);
+
+	return true;
+}
+
+static bool scanObject(const char *&cp, const char *ep,
+  QVector<JSONMember> &members)
+{
+	JSONMember m;
+
+	cp++;
+	skipWS(cp, ep);
+	if (cp < ep && *cp == '}') {
+		cp++;
+		return true;
+	}
+
+	while (cp < ep && *cp == '"') {
+		m.key = cp;
+		if (!skipString(cp, ep))
+			return false;
+		m.keyEnd = cp;
+		skipWS(cp, ep);
+		if (cp >= ep || *cp != ':')
+			return false;
+		cp++;
+		skipWS(cp, ep);
+		m.value = cp;
+		if (!skipValue(cp, ep))
+			return false;
+		m.valueEnd = cp;
+		members.append(m);
+
+		skipWS(cp, ep);
+		if (cp >= ep)
+			return false;
+		if (*cp == '}') {
+			cp++;
+			return true;
+		} else if (*cp != ',')
+			return false;
+		cp++;
+		skipWS(cp, ep);
+	}
+
+	return false;
+}
+
+static bool equals(const char *sp, const char *ep, const char *str)
+{
+	int len = qstrlen(str);
+	return (ep - sp == len + 2 && !memcmp(sp + 1, str, len));
+}
+
 bool GeoJSONParser::a2c(const QJsonArray &data, const Projection &proj,
   Coordinates &c)
 {
@@ -668,29 +790,83 @@ bool GeoJSONParser::featureCollection(const QJsonObject &object,
 }
 
 
-bool GeoJSONParser::parse(QFile *file, QList<TrackData> &tracks,
-  QList<RouteData> &routes, QList<Area> &areas, QVector<Waypoint> &waypoints)
+bool GeoJSONParser::json(const char *data, const char *sp, const char *ep,
+  QJsonObject &object)
 {
-	Q_UNUSED(routes);
+	QJsonParseError error;
+	QJsonDocument doc(QJsonDocument::fromJson(QByteArray::fromRawData(sp,
+	  ep - sp), &error));
 
-	if (!possiblyJSONObject(file)) {
-		_errorString = "Not a GeoJSON file";
+	if (doc.isNull()) {
+		_errorString = QString("JSON parse error on offset %1: %2")
+		  .arg(QString::number((sp - data) + error.offset),
+		  error.errorString());
 		return false;
-	} else
-		file->reset();
+	}
 
-	QJsonParseError error;
-	QJsonDocument doc(QJsonDocument::fromJson(file->readAll(), &error));
+	object = doc.object();
+	return true;
+}
 
-	if (doc.isNull()) {
+bool GeoJSONParser::features(const char *data, const JSONMember &crsMember,
+  const JSONMember &features, const QString &file, QList<TrackData> &tracks,
+  QList<Area> &areas, QVector<Waypoint> &waypoints)
+{
+	Projection proj(GCS::WGS84());
+
+	if (crsMember.key) {
+		QByteArray ba("{");
+		ba.append(crsMember.key, crsMember.valueEnd - crsMember.key);
+		ba.append('}');
+
+		QJsonObject object;
+		if (!json(ba.constData(), ba.constData(), ba.constData() + ba.size(),
+		  object))
+			return false;
+		Projection p;
+		if (!crs(object, p))
+			return false;
+		proj = PROJ(p, proj);
+	}
+
+	const char *cp = features.value + 1;
+	const char *ep = features.valueEnd - 1;
+
+	while (true) {
+		skipWS(cp, ep);
+		if (cp >= ep)
+			break;
+
+		const char *sp = cp;
+		if (!skipValue(cp, ep)) {
+			cp = sp;
+			break;
+		}
+		QJsonObject object;
+		if (!json(data, sp, cp, object))
+			return false;
+		if (!feature(object, file, proj, tracks, areas, waypoints))
+			return false;
+
+		skipWS(cp, ep);
+		if (cp >= ep || *cp != ',')
+			break;
+		cp++;
+	}
+
+	if (cp != ep) {
 		_errorString = QString("JSON parse error on offset %1: %2")
-		  .arg(QString::number(error.offset), error.errorString());
+		  .arg(QString::number(cp - data), "invalid features array");
 		return false;
 	}
 
-	QJsonObject object(doc.object());
+	return true;
+}
+
+bool GeoJSONParser::object(const QJsonObject &object, const QString &file,
+  QList<TrackData> &tracks, QList<Area> &areas, QVector<Waypoint> &waypoints)
+{
 	Projection proj(GCS::WGS84());
-	QString fileName(file->fileName());
 
 	switch (type(object)) {
 		case Point:
@@ -698,16 +874,16 @@ bool GeoJSONParser::parse(QFile *file, QList<TrackData> &tracks,
 		case MultiPoint:
 			return multiPoint(object, proj, QJsonValue(), waypoints);
 		case LineString:
-			return lineString(object, fileName, proj, QJsonValue(), tracks);
+			return lineString(object, file, proj, QJsonValue(), tracks);
 		case MultiLineString:
-			return multiLineString(object, fileName, proj, QJsonValue(), tracks);
+			return multiLineString(object, file, proj, QJsonValue(), tracks);
 		case GeometryCollection:
-			return geometryCollection(object, fileName, proj, QJsonValue(),
+			return geometryCollection(object, file, proj, QJsonValue(),
 			  tracks, areas, waypoints);
 		case Feature:
-			return feature(object, fileName, proj, tracks, areas, waypoints);
+			return feature(object, file, proj, tracks, areas, waypoints);
 		case FeatureCollection:
-			return featureCollection(object, fileName, proj, tracks, areas,
+			return featureCollection(object, file, proj, tracks, areas,
 			  waypoints);
 		case Polygon:
 			return polygon(object, proj, QJsonValue(), areas);
@@ -724,3 +900,98 @@ bool GeoJSONParser::parse(QFile *file, QList<TrackData> &tracks,
 
 	return true;
 }
+
+bool GeoJSONParser::object(const char *data, const char *&cp,
+  const char *ep, const QString &file, QList<TrackData> &tracks,
+  QList<Area> &areas, QVector<Waypoint> &waypoints)
+{
+	const char *sp = cp;
+	QVector<JSONMember> members;
+	JSONMember type, features, crs;
+
+	if (!scanObject(cp, ep, members)) {
+		_errorString = QString("JSON parse error on offset %1: %2")
+		  .arg(QString::number(cp - data), "invalid object");
+		return false;
+	}
+
+	type.key = 0;
+	features.key = 0;
+	crs.key = 0;
+	for (int i = 0; i < members.size(); i++) {
+		const JSONMember &m = members.at(i);
+		if (equals(m.key, m.keyEnd, "type"))
+			type = m;
+		else if (equals(m.key, m.keyEnd, "features"))
+			features = m;
+		else if (equals(m.key, m.keyEnd, "crs"))
+			crs = m;
+	}
+
+	/* Feature collections are streamed, everything else (including invalid
+	   feature collections for proper error reporting) goes through the DOM */
+	if (type.key && features.key && *features.value == '['
+	  && equals(type.value, type.valueEnd, "FeatureCollection"))
+		return this->features(data, crs, features, file, tracks, areas,
+		  waypoints);
+	else {
+		QJsonObject obj;
+		if (!json(data, sp, cp, obj))
+			return false;
+		return object(obj, file, tracks, areas, waypoints);
+	}
+}
+
+bool GeoJSONParser::parse(QFile *file, QList<TrackData> &tracks,
+  QList<RouteData> &routes, QList<Area> &areas, QVector<Waypoint> &waypoints)
+{
+	Q_UNUSED(routes);
+	QByteArray ba;
+	qint64 size = file->size();
+	bool ret = true;
+
+	if (!possiblyJSONObject(file)) {
+		_errorString = "Not a GeoJSON file";
+		return false;
+	} else
+		file->reset();
+
+	const char *data = (const char*)file->map(0, size);
+	bool mapped = (data != 0);
+	if (!mapped) {
+		ba = file->readAll();
+		if (ba.size() != size) {
+			_errorString = "I/O error";
+			return false;
+		}
+		data = ba.constData();
+	}
+
+	/* Besides plain GeoJSON files, newline-delimited GeoJSON and GeoJSON text
+	   sequences (RFC 8142) are supported - all the objects in the file are
+	   processed. */
+	const char *cp = data, *ep = data + size;
+	while (true) {
+		while (cp < ep && (isWS(*cp) || *cp == RS))
+			cp++;
+		if (cp >= ep)
+			break;
+
+		if (*cp != '{') {
+			_errorString = QString("JSON parse error on offset %1: %2")
+			  .arg(QString::number(cp - data), "object expected");
+			ret = false;
+			break;
+		}
+		if (!object(data, cp, ep, file->fileName(), tracks, areas,
+		  waypoints)) {
+			ret = false;
+			break;
+		}
+	}
+
+	if (mapped)
+		file->unmap((uchar*)data);
+
+	return ret;
+}
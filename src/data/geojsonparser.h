@@ -7,6 +7,7 @@
 class QJsonObject;
 class QJsonArray;
 class Projection;
+struct JSONMember;
 
 class GeoJSONParser : public Parser
 {
@@ -56,6 +57,18 @@ private:
 	bool featureCollection(const QJsonObject &object, const QString &file,
 	  const Projection &parent, QList<TrackData> &tracks, QList<Area> &areas,
 	  QVector<Waypoint> &waypoints);
+	bool object(const QJsonObject &object, const QString &file,
+	  QList<TrackData> &tracks, QList<Area> &areas,
+	  QVector<Waypoint> &waypoints);
+
+	bool json(const char *data, const char *sp, const char *ep,
+	  QJsonObject &object);
+	bool features(const char *data, const JSONMember &crsMember,
+	  const JSONMember &features, const QString &file, QList<TrackData> &tracks,
+	  QList<Area> &areas, QVector<Waypoint> &waypoints);
+	bool object(const char *data, const char *&cp, const char *ep,
+	  const QString &file, QList<TrackData> &tracks, QList<Area> &areas,
+	  QVector<Waypoint> &waypoints);
 
 	QString _errorString;
 };
@@ -1,5 +1,6 @@
-#include <QDataStream>
+#include <climits>
 #include <QDateTime>
+#include <QtEndian>
 #include <QTimeZone>
 #include "gpmfparser.h"
 
@@ -33,262 +34,265 @@ constexpr quint32 GPS5 = TAG("GPS5");
 constexpr quint32 GPSU = TAG("GPSU");
 constexpr quint32 SCAL = TAG("SCAL");
 
-static bool hdr(QDataStream &stream, quint32 &type, quint64 &size)
+static quint16 be16(const char *data)
 {
-	quint32 size32;
-
-	stream >> size32 >> type;
-	if (stream.status())
-		return false;
-	if (size32 == 1) {
-		stream >> size;
-		if (stream.status())
-			return false;
-	} else
-		size = size32;
-
-	return true;
+	return qFromBigEndian<quint16>(data);
 }
 
-static bool ftyp(QDataStream &stream)
+static quint32 be32(const char *data)
 {
-	quint32 type, brand;
-	quint64 size;
-
-	if (!hdr(stream, type, size))
-		return false;
-	stream >> brand;
-	if (stream.status())
-		return false;
-
-	if (type != FTYP || brand != MP41)
-		return false;
+	return qFromBigEndian<quint32>(data);
+}
 
-	return (stream.skipRawData(size - 12) == (qint64)size - 12);
+static quint64 be64(const char *data)
+{
+	return qFromBigEndian<quint64>(data);
 }
 
-static bool entry(QDataStream &stream, quint32 size, SegmentData &segment)
+static bool entry(const char *data, quint32 size, SegmentData &segment)
 {
-	quint32 key;
-	quint8 ss, type;
-	quint16 repeat;
+	const char *dp = data, *end = data + size;
 	QDateTime base;
-	QByteArray date(16, Qt::Initialization::Uninitialized);
 	qint32 scale[5] = {1, 1, 1, 1, 1};
 
-	do {
-		stream >> key >> type >> ss >> repeat;
-		if (stream.status())
+	while (dp < end) {
+		if (end - dp < 8)
 			return false;
-		size -= 8;
+		quint32 key = be32(dp);
+		quint8 type = dp[4];
+		quint8 ss = dp[5];
+		quint16 repeat = be16(dp + 6);
+		dp += 8;
+
 		quint32 ps = alignup(ss * repeat, 4);
+		if (ps > (quint32)(end - dp))
+			return false;
+
 		if (!type) {
-			if (!entry(stream, ps, segment))
+			if (!entry(dp, ps, segment))
 				return false;
-		} else {
-			if (key == SCAL && type == 'l' && ss == 4 && repeat == 5) {
-				stream >> scale[0] >> scale[1] >> scale[2] >> scale[3]
-				  >> scale[4];
-				if (stream.status())
-					return false;
-			} else if (key == GPS5 && type == 'l' && ss == 20) {
-				qint64 ms = qRound((1.0 / (double)repeat) * 1000);
-
-				qint32 lat, lon, alt, spd2, spd3;
-				for (quint16 i = 0; i < repeat; i++) {
-					stream >> lat >> lon >> alt >> spd2 >> spd3;
-					if (stream.status())
-						return false;
-					Trackpoint t(Coordinates(lon / (double)scale[1],
-					  lat / (double)scale[0]));
-					t.setTimestamp(base.addMSecs(ms * i));
-					t.setElevation(alt / (double)scale[2]);
-					t.setSpeed(spd2 / (double)scale[3]);
-					segment.append(t);
-				}
-			} else if (key == GPSU && type == 'U' && ss == 16 && repeat == 1) {
-				if (stream.readRawData(date.data(), date.size()) != date.size())
-					return false;
+		} else if (key == SCAL && type == 'l' && ss == 4 && repeat == 5) {
+			for (int i = 0; i < 5; i++)
+				scale[i] = (qint32)be32(dp + i * 4);
+		} else if (key == GPS5 && type == 'l' && ss == 20) {
+			qint64 ms = qRound((1.0 / (double)repeat) * 1000);
+
+			segment.reserve(segment.size() + repeat);
+			for (quint16 i = 0; i < repeat; i++) {
+				const char *vp = dp + i * 20;
+				qint32 lat = (qint32)be32(vp);
+				qint32 lon = (qint32)be32(vp + 4);
+				qint32 alt = (qint32)be32(vp + 8);
+				qint32 spd2 = (qint32)be32(vp + 12);
+
+				Trackpoint t(Coordinates(lon / (double)scale[1],
+				  lat / (double)scale[0]));
+				t.setTimestamp(base.addMSecs(ms * i));
+				t.setElevation(alt / (double)scale[2]);
+				t.setSpeed(spd2 / (double)scale[3]);
+				segment.append(t);
+			}
+		} else if (key == GPSU && type == 'U' && ss == 16 && repeat == 1) {
+			QByteArray date(dp, 16);
 #if QT_VERSION < QT_VERSION_CHECK(6, 7, 0)
-				base = QDateTime::fromString(date, "yyMMddHHmmss.zzz")
-				  .addYears(100);
+			base = QDateTime::fromString(date, "yyMMddHHmmss.zzz")
+			  .addYears(100);
 #else // QT 6.7
-				base = QDateTime::fromString(date, "yyMMddHHmmss.zzz", 2000);
+			base = QDateTime::fromString(date, "yyMMddHHmmss.zzz", 2000);
 #endif // QT 6.7
-				base.setTimeZone(QTimeZone::utc());
-			} else {
-				if (stream.skipRawData(ps) != (qint64)ps)
-					return false;
-			}
+			base.setTimeZone(QTimeZone::utc());
 		}
-		size -= (ps);
-	} while (size);
+
+		dp += ps;
+	}
 
 	return true;
 }
 
-bool GPMFParser::stsd(QDataStream &stream, quint64 atomSize, bool &gpmd)
+/* Reads a part of the file. The data of a mapped file are not copied and
+   only the pages actually accessed are read from the disk. */
+bool GPMFParser::read(quint64 offset, quint64 len, QByteArray &data)
 {
-	if (atomSize && atomSize < 8) {
-		_errorString = "Invalid STSD atom size";
+	if (offset > _size || len > _size - offset || len > INT_MAX)
 		return false;
+
+	if (_map) {
+		data = QByteArray::fromRawData((const char*)_map + offset, (int)len);
+		return true;
+	} else {
+		if (!_file->seek(offset))
+			return false;
+		data = _file->read(len);
+		return (data.size() == (int)len);
 	}
+}
+
+/* Reads the header of the atom at offset, data/size is the atom payload */
+bool GPMFParser::atom(quint64 offset, quint64 end, quint32 &type,
+  quint64 &data, quint64 &size)
+{
+	QByteArray ba;
+	quint64 hs = 8, as;
+
+	if (end - offset < 8 || !read(offset, 8, ba))
+		return false;
+	quint32 size32 = be32(ba.constData());
+	type = be32(ba.constData() + 4);
+
+	if (size32 == 1) {
+		if (end - offset < 16 || !read(offset + 8, 8, ba))
+			return false;
+		as = be64(ba.constData());
+		hs = 16;
+	} else if (size32 == 0)
+		as = end - offset;
+	else
+		as = size32;
+
+	if (as < hs || as > end - offset)
+		return false;
+
+	data = offset + hs;
+	size = as - hs;
+
+	return true;
+}
+
+bool GPMFParser::stsd(quint64 offset, quint64 size, bool &gpmd)
+{
+	QByteArray ba;
 
-	quint32 vf, num;
-	stream >> vf >> num;
-	if (stream.status()) {
+	if (size < 8 || !read(offset, size, ba)) {
 		_errorString = "Error reading STSD data";
 		return false;
 	}
 
+	const char *dp = ba.constData() + 8, *end = ba.constData() + ba.size();
+	quint32 num = be32(ba.constData() + 4);
+
 	for (quint32 i = 0; i < num; i++) {
-		quint32 ds, format;
-		stream >> ds >> format;
-		stream.skipRawData(ds - 8);
-		if (stream.status()) {
+		if (end - dp < 8) {
+			_errorString = "Error reading STSD table entry";
+			return false;
+		}
+		quint32 ds = be32(dp);
+		quint32 format = be32(dp + 4);
+		if (ds < 8 || ds > (quint32)(end - dp)) {
 			_errorString = "Error reading STSD table entry";
 			return false;
 		}
 		if (format == GPMD)
 			gpmd = true;
+		dp += ds;
 	}
 
 	return true;
 }
 
-bool GPMFParser::stsz(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes)
+bool GPMFParser::stsz(quint64 offset, quint64 size, QVector<quint32> &sizes)
 {
-	if (atomSize && atomSize < 12) {
-		_errorString = "Invalid STSZ atom size";
-		return false;
-	}
+	QByteArray ba;
 
-	quint32 vf, ss, num;
-	stream >> vf >> ss >> num;
-	if (stream.status()) {
+	if (size < 12 || !read(offset, size, ba)) {
 		_errorString = "Error reading STSZ data";
 		return false;
 	}
 
+	const char *dp = ba.constData();
+	quint32 ss = be32(dp + 4);
+	quint32 num = be32(dp + 8);
+
 	if (ss)
 		sizes = QVector<quint32>(num, ss);
 	else {
-		sizes.resize(num);
-		for (quint32 i = 0; i < num; i++)
-			stream >> sizes[i];
-		if (stream.status()) {
+		if ((quint64)num * 4 > size - 12) {
 			_errorString = "Error reading STSZ table";
 			return false;
 		}
+		sizes.resize(num);
+		for (quint32 i = 0; i < num; i++)
+			sizes[i] = be32(dp + 12 + i * 4);
 	}
 
 	return true;
 }
 
-bool GPMFParser::stco(QDataStream &stream, quint64 atomSize,
-  QVector<quint64> &chunks)
+bool GPMFParser::stco(quint64 offset, quint64 size, QVector<quint64> &chunks)
 {
-	if (atomSize && atomSize < 8) {
-		_errorString = "Invalid STCO atom size";
-		return false;
-	}
+	QByteArray ba;
 
-	quint32 vf, num, chunk;
-	stream >> vf >> num;
-	if (stream.status()) {
+	if (size < 8 || !read(offset, size, ba)) {
 		_errorString = "Error reading STCO data";
 		return false;
 	}
 
-	chunks.resize(num);
-	for (quint32 i = 0; i < num; i++) {
-		stream >> chunk;
-		chunks[i] = chunk;
-	}
-	if (stream.status()) {
+	const char *dp = ba.constData();
+	quint32 num = be32(dp + 4);
+
+	if ((quint64)num * 4 > size - 8) {
 		_errorString = "Error reading STCO table";
 		return false;
 	}
+	chunks.resize(num);
+	for (quint32 i = 0; i < num; i++)
+		chunks[i] = be32(dp + 8 + i * 4);
 
 	return true;
 }
 
-bool GPMFParser::co64(QDataStream &stream, quint64 atomSize,
-  QVector<quint64> &chunks)
+bool GPMFParser::co64(quint64 offset, quint64 size, QVector<quint64> &chunks)
 {
-	if (atomSize && atomSize < 8) {
-		_errorString = "Invalid CO64 atom size";
-		return false;
-	}
+	QByteArray ba;
 
-	quint32 vf, num;
-	stream >> vf >> num;
-	if (stream.status()) {
+	if (size < 8 || !read(offset, size, ba)) {
 		_errorString = "Error reading CO64 data";
 		return false;
 	}
 
-	chunks.resize(num);
-	for (quint32 i = 0; i < num; i++)
-		stream >> chunks[i];
-	if (stream.status()) {
+	const char *dp = ba.constData();
+	quint32 num = be32(dp + 4);
+
+	if ((quint64)num * 8 > size - 8) {
 		_errorString = "Error reading CO64 table";
 		return false;
 	}
+	chunks.resize(num);
+	for (quint32 i = 0; i < num; i++)
+		chunks[i] = be64(dp + 8 + i * 8);
 
 	return true;
 }
 
-bool GPMFParser::stbl(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes, QVector<quint64> &chunks)
+bool GPMFParser::stbl(quint64 offset, quint64 size, QVector<quint32> &sizes,
+  QVector<quint64> &chunks)
 {
+	quint64 end = offset + size, data, ds;
 	quint32 type;
-	quint64 size;
 	bool gpmd = false;
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading STBL atom header";
+	while (offset < end) {
+		if (!atom(offset, end, type, data, ds)) {
+			_errorString = "Invalid STBL atom";
 			return false;
 		}
-		if (atomSize) {
-			if (size > atomSize) {
-				_errorString = "STBL size overflow";
-				return false;
-			} else
-				atomSize -= size;
-		}
 
 		if (type == STSD) {
-			if (!stsd(stream, size ? size - 8 : 0, gpmd))
+			if (!stsd(data, ds, gpmd))
 				return false;
 		} else if (type == STSZ && gpmd) {
-			if (!stsz(stream, size ? size - 8 : 0, sizes))
+			if (!stsz(data, ds, sizes))
 				return false;
 		} else if (type == STCO && gpmd) {
-			if (!stco(stream, size ? size - 8 : 0, chunks))
+			if (!stco(data, ds, chunks))
 				return false;
 		} else if (type == CO64 && gpmd) {
-			if (!co64(stream, size ? size - 8 : 0, chunks))
+			if (!co64(data, ds, chunks))
 				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in STBL";
-					return false;
-				}
-			} else
-				break;
 		}
-		if (stream.atEnd())
-			break;
-	} while (atomSize);
 
-	if (atomSize) {
-		_errorString = "STBL size underflow";
-		return false;
+		offset = data + ds;
 	}
+
 	if (chunks.size() != sizes.size()) {
 		_errorString = "STSZ/STCO size mismatch";
 		return false;
@@ -297,246 +301,153 @@ bool GPMFParser::stbl(QDataStream &stream, quint64 atomSize,
 	return true;
 }
 
-bool GPMFParser::hdlr(QDataStream &stream, quint64 atomSize, bool &mhlr)
+bool GPMFParser::hdlr(quint64 offset, quint64 size, bool &mhlr)
 {
-	// HDLR atom size can not be zero
-	if (atomSize < 24) {
-		_errorString = "Invalid HDLR atom size";
-		return false;
-	}
+	QByteArray ba;
 
-	quint32 vf, type, subtype, manufacturer, flags, mask;
-	stream >> vf >> type >> subtype >> manufacturer >> flags >> mask;
-	if (stream.status()
-	  || stream.skipRawData(atomSize - 24) != (qint64)atomSize - 24) {
+	if (size < 24 || !read(offset, 12, ba)) {
 		_errorString = "Error reading HDLR data";
 		return false;
 	}
 
+	quint32 type = be32(ba.constData() + 4);
+	quint32 subtype = be32(ba.constData() + 8);
 	mhlr = (type == MHLR && subtype == META);
 
 	return true;
 }
 
-bool GPMFParser::minf(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes, QVector<quint64> &chunks)
+bool GPMFParser::minf(quint64 offset, quint64 size, QVector<quint32> &sizes,
+  QVector<quint64> &chunks)
 {
+	quint64 end = offset + size, data, ds;
 	quint32 type;
-	quint64 size;
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading MINF atom header";
+	while (offset < end) {
+		if (!atom(offset, end, type, data, ds)) {
+			_errorString = "Invalid MINF atom";
 			return false;
 		}
-		if (atomSize) {
-			if (size > atomSize) {
-				_errorString = "MINF size overflow";
-				return false;
-			} else
-				atomSize -= size;
-		}
 
 		if (type == STBL) {
-			if (!stbl(stream, size ? size - 8 : 0, sizes, chunks))
+			if (!stbl(data, ds, sizes, chunks))
 				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in MINF";
-					return false;
-				}
-			} else
-				break;
 		}
-		if (stream.atEnd())
-			break;
-	} while (atomSize);
 
-	if (atomSize) {
-		_errorString = "MINF size underflow";
-		return false;
-	} else
-		return true;
+		offset = data + ds;
+	}
+
+	return true;
 }
 
-bool GPMFParser::mdia(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes, QVector<quint64> &chunks)
+bool GPMFParser::mdia(quint64 offset, quint64 size, QVector<quint32> &sizes,
+  QVector<quint64> &chunks)
 {
+	quint64 end = offset + size, data, ds;
 	quint32 type;
-	quint64 size;
 	bool mhlr = false;
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading MDIA atom header";
+	while (offset < end) {
+		if (!atom(offset, end, type, data, ds)) {
+			_errorString = "Invalid MDIA atom";
 			return false;
 		}
-		if (atomSize) {
-			if (size > atomSize) {
-				_errorString = "MDIA size overflow";
-				return false;
-			} else
-				atomSize -= size;
-		}
 
 		if (type == HDLR) {
-			if (!hdlr(stream, size ? size - 8 : 0, mhlr))
+			if (!hdlr(data, ds, mhlr))
 				return false;
 		} else if (type == MINF && mhlr) {
-			if (!minf(stream, size ? size - 8 : 0, sizes, chunks))
+			if (!minf(data, ds, sizes, chunks))
 				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in MDIA";
-					return false;
-				}
-			} else
-				break;
 		}
-		if (stream.atEnd())
-			break;
-	} while (atomSize);
 
-	if (atomSize) {
-		_errorString = "MDIA size underflow";
-		return false;
-	} else
-		return true;
+		offset = data + ds;
+	}
+
+	return true;
 }
 
-bool GPMFParser::trak(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes, QVector<quint64> &chunks)
+bool GPMFParser::trak(quint64 offset, quint64 size, QVector<quint32> &sizes,
+  QVector<quint64> &chunks)
 {
+	quint64 end = offset + size, data, ds;
 	quint32 type;
-	quint64 size;
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading TRAK atom header";
+	while (offset < end) {
+		if (!atom(offset, end, type, data, ds)) {
+			_errorString = "Invalid TRAK atom";
 			return false;
 		}
-		if (atomSize) {
-			if (size > atomSize) {
-				_errorString = "TRAK size overflow";
-				return false;
-			} else
-				atomSize -= size;
-		}
 
 		if (type == MDIA) {
-			if (!mdia(stream, size ? size - 8 : 0, sizes, chunks))
+			if (!mdia(data, ds, sizes, chunks))
 				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in TRAK";
-					return false;
-				}
-			} else
-				break;
 		}
-		if (stream.atEnd())
-			break;
-	} while (atomSize);
 
-	if (atomSize) {
-		_errorString = "TRAK size underflow";
-		return false;
-	} else
-		return true;
+		offset = data + ds;
+	}
+
+	return true;
 }
 
-bool GPMFParser::moov(QDataStream &stream, quint64 atomSize,
-  QVector<quint32> &sizes, QVector<quint64> &chunks)
+bool GPMFParser::moov(quint64 offset, quint64 size, QVector<quint32> &sizes,
+  QVector<quint64> &chunks)
 {
+	quint64 end = offset + size, data, ds;
 	quint32 type;
-	quint64 size;
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading MOOV atom header";
+	while (offset < end) {
+		if (!atom(offset, end, type, data, ds)) {
+			_errorString = "Invalid MOOV atom";
 			return false;
 		}
-		if (atomSize) {
-			if (size > atomSize) {
-				_errorString = "MOOV size overflow";
-				return false;
-			} else
-				atomSize -= size;
-		}
 
 		if (type == TRAK) {
-			if (!trak(stream, size ? size - 8 : 0, sizes, chunks))
+			if (!trak(data, ds, sizes, chunks))
 				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in MOOV";
-					return false;
-				}
-			} else
-				break;
 		}
-		if (stream.atEnd())
-			break;
-	} while (atomSize);
 
-	if (atomSize) {
-		_errorString = "MOOV size underflow";
-		return false;
-	} else
-		return true;
+		offset = data + ds;
+	}
+
+	return true;
 }
 
-bool GPMFParser::mp4(QFile *file, QVector<quint32> &sizes,
-  QVector<quint64> &chunks)
+bool GPMFParser::mp4(QVector<quint32> &sizes, QVector<quint64> &chunks)
 {
-	QDataStream stream(file);
+	QByteArray ba;
+	quint64 offset, data, ds;
 	quint32 type;
-	quint64 size;
-
-	stream.setByteOrder(QDataStream::BigEndian);
 
-	if (!ftyp(stream)) {
+	if (!atom(0, _size, type, data, ds) || type != FTYP || ds < 4
+	  || !read(data, 4, ba) || be32(ba.constData()) != MP41) {
 		_errorString = "Not a MP4 file";
 		return false;
 	}
 
-	do {
-		if (!hdr(stream, type, size)) {
-			_errorString = "Error reading root atom header";
+	/* The root atoms (including the media data) are skipped using their
+	   sizes, the MOOV atom may be anywhere in the file */
+	for (offset = data + ds; offset < _size; offset = data + ds) {
+		if (!atom(offset, _size, type, data, ds)) {
+			_errorString = "Invalid root atom";
 			return false;
 		}
 
-		if (type == MOOV) {
-			if (!moov(stream, size ? size - 8 : 0, sizes, chunks))
-				return false;
-		} else {
-			if (size) {
-				if (stream.skipRawData(size - 8) != (qint64)size - 8) {
-					_errorString = "Unexpected EOF in root";
-					return false;
-				}
-			} else
-				break;
-		}
-	} while (!stream.atEnd());
+		if (type == MOOV)
+			return moov(data, ds, sizes, chunks);
+	}
 
 	return true;
 }
 
-bool GPMFParser::gpmf(QFile *file, quint64 offset, quint32 size,
-  SegmentData &segment)
+bool GPMFParser::gpmf(quint64 offset, quint32 size, SegmentData &segment)
 {
-	if (!file->seek(offset))
-		return false;
+	QByteArray ba;
 
-	QDataStream stream(file);
-	stream.setByteOrder(QDataStream::BigEndian);
+	if (!read(offset, size, ba))
+		return false;
 
-	return entry(stream, size, segment);
+	return entry(ba.constData(), ba.size(), segment);
 }
 
 bool GPMFParser::parse(QFile *file, QList<TrackData> &tracks,
@@ -547,27 +458,38 @@ bool GPMFParser::parse(QFile *file, QList<TrackData> &tracks,
 	Q_UNUSED(waypoints);
 	QVector<quint32> sizes;
 	QVector<quint64> chunks;
+	SegmentData segment;
+	bool ret = false;
 
-	if (!mp4(file, sizes, chunks))
-		return false;
+	_file = file;
+	_size = file->size();
+	_map = file->map(0, _size);
+
+	if (!mp4(sizes, chunks))
+		goto out;
 	if (chunks.isEmpty()) {
 		_errorString = "No GPMF data found";
-		return false;
+		goto out;
 	}
 
-	SegmentData segment;
 	for (int i = 0; i < chunks.size(); i++) {
-		if (!gpmf(file, chunks.at(i), sizes.at(i), segment)) {
+		if (!gpmf(chunks.at(i), sizes.at(i), segment)) {
 			_errorString = "GPMF parse error";
-			return false;
+			goto out;
 		}
 	}
 
-	if (segment.isEmpty()) {
+	if (segment.isEmpty())
 		_errorString = "No GPS data found in GPMF";
-		return false;
-	} else
+	else {
 		tracks.append(segment);
+		ret = true;
+	}
 
-	return true;
+out:
+	if (_map)
+		file->unmap((uchar*)_map);
+	_map = 0;
+
+	return ret;
 }
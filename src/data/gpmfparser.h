@@ -6,31 +6,40 @@
 class GPMFParser : public Parser
 {
 public:
+	GPMFParser() : _file(0), _map(0), _size(0) {}
+
 	bool parse(QFile *file, QList<TrackData> &tracks, QList<RouteData> &routes,
 	  QList<Area> &polygons, QVector<Waypoint> &waypoints);
 	QString errorString() const {return _errorString;}
 	int errorLine() const {return 0;}
 
 private:
-	bool mp4(QFile *file, QVector<quint32> &sizes, QVector<quint64> &chunks);
-	bool moov(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes,
+	bool read(quint64 offset, quint64 len, QByteArray &data);
+	bool atom(quint64 offset, quint64 end, quint32 &type, quint64 &data,
+	  quint64 &size);
+
+	bool mp4(QVector<quint32> &sizes, QVector<quint64> &chunks);
+	bool moov(quint64 offset, quint64 size, QVector<quint32> &sizes,
 	  QVector<quint64> &chunks);
-	bool trak(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes,
+	bool trak(quint64 offset, quint64 size, QVector<quint32> &sizes,
 	  QVector<quint64> &chunks);
-	bool mdia(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes,
+	bool mdia(quint64 offset, quint64 size, QVector<quint32> &sizes,
 	  QVector<quint64> &chunks);
-	bool hdlr(QDataStream &stream, quint64 atomSize, bool &mhlr);
-	bool minf(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes,
+	bool hdlr(quint64 offset, quint64 size, bool &mhlr);
+	bool minf(quint64 offset, quint64 size, QVector<quint32> &sizes,
 	  QVector<quint64> &chunks);
-	bool stbl(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes,
+	bool stbl(quint64 offset, quint64 size, QVector<quint32> &sizes,
 	  QVector<quint64> &chunks);
-	bool stsd(QDataStream &stream, quint64 atomSize, bool &gpmd);
-	bool stsz(QDataStream &stream, quint64 atomSize, QVector<quint32> &sizes);
-	bool stco(QDataStream &stream, quint64 atomSize, QVector<quint64> &chunks);
-	bool co64(QDataStream &stream, quint64 atomSize, QVector<quint64> &chunks);
+	bool stsd(quint64 offset, quint64 size, bool &gpmd);
+	bool stsz(quint64 offset, quint64 size, QVector<quint32> &sizes);
+	bool stco(quint64 offset, quint64 size, QVector<quint64> &chunks);
+	bool co64(quint64 offset, quint64 size, QVector<quint64> &chunks);
 
-	bool gpmf(QFile *file, quint64 offset, quint32 size, SegmentData &segment);
+	bool gpmf(quint64 offset, quint32 size, SegmentData &segment);
 
+	QFile *_file;
+	const uchar *_map;
+	quint64 _size;
 	QString _errorString;
 };
 
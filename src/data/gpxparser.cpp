@@ -1,12 +1,12 @@
 #include "address.h"
+#include "xmlvalue.h"
 #include "gpxparser.h"
 
 
 qreal GPXParser::number()
 {
-	bool res;
-	qreal ret = _reader.readElementText().toDouble(&res);
-	if (!res)
+	double ret = NAN;
+	if (!XMLValue::number(_reader, ret))
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
 
@@ -15,9 +15,8 @@ qreal GPXParser::number()
 
 QDateTime GPXParser::time()
 {
-	QDateTime d = QDateTime::fromString(_reader.readElementText(),
-	  Qt::ISODate);
-	if (!d.isValid())
+	QDateTime d;
+	if (!XMLValue::dateTime(_reader, d))
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
 
@@ -41,16 +40,16 @@ Link GPXParser::link()
 
 Coordinates GPXParser::coordinates()
 {
-	bool res;
+	double lon, lat;
 	const QXmlStreamAttributes &attr = _reader.attributes();
 
-	qreal lon = attr.value("lon").toDouble(&res);
-	if (!res || (lon < -180.0 || lon > 180.0)) {
+	if (!XMLValue::toDouble(attr.value("lon"), lon)
+	  || (lon < -180.0 || lon > 180.0)) {
 		_reader.raiseError("Invalid longitude");
 		return Coordinates();
 	}
-	qreal lat = attr.value("lat").toDouble(&res);
-	if (!res || (lat < -90.0 || lat > 90.0)) {
+	if (!XMLValue::toDouble(attr.value("lat"), lat)
+	  || (lat < -90.0 || lat > 90.0)) {
 		_reader.raiseError("Invalid latitude");
 		return Coordinates();
 	}
@@ -225,8 +224,9 @@ void GPXParser::trackpoints(SegmentData &segment)
 {
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("trkpt")) {
-			segment.append(Trackpoint(coordinates()));
-			trackpointData(segment.last());
+			Trackpoint t(coordinates());
+			trackpointData(t);
+			segment.append(t);
 		} else
 			_reader.skipCurrentElement();
 	}
@@ -156,7 +156,7 @@ bool IGCParser::readBRecord(CTX &ctx, const char *line, int len,
 	}
 
 	if (time < ctx.time && !segment.isEmpty()
-	  && ctx.date == segment.last().timestamp().date())
+	  && ctx.date == segment.timestamp(segment.size() - 1).date())
 		ctx.date = ctx.date.addDays(1);
 	ctx.time = time;
 
@@ -19,6 +19,7 @@
 #include <QRegularExpression>
 #include <private/qzipreader_p.h>
 #include "common/util.h"
+#include "xmlvalue.h"
 #include "kmlparser.h"
 
 static bool isZIP(QFile *file)
@@ -31,38 +32,35 @@ static bool isZIP(QFile *file)
 
 qreal KMLParser::number()
 {
-	bool res;
-	QString str(_reader.readElementText());
-
-	if (str.isEmpty())
-		return NAN;
+	double ret = NAN;
+	bool empty;
 
-	qreal ret = str.toDouble(&res);
-	if (!res)
+	if (!XMLValue::number(_reader, ret, &empty)) {
+		if (empty && !_reader.error())
+			return NAN;
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
+	}
 
 	return ret;
 }
 
 QDateTime KMLParser::time()
 {
-	QDateTime d = QDateTime::fromString(_reader.readElementText(),
-	  Qt::ISODate);
-	if (!d.isValid())
+	QDateTime d;
+	if (!XMLValue::dateTime(_reader, d))
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
 
 	return d;
 }
 
-bool KMLParser::coord(Trackpoint &trackpoint)
+bool KMLParser::coord(SegmentData &segment, int i)
 {
 	QString data = _reader.readElementText();
 	const QChar *sp, *ep, *cp, *vp;
 	int c = 0;
-	qreal val[3];
-	bool res;
+	double val[3];
 
 	if (data.isEmpty())
 		return true;
@@ -79,16 +77,15 @@ bool KMLParser::coord(Trackpoint &trackpoint)
 			if (c > 2)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			if (c == 1) {
-				trackpoint.setCoordinates(Coordinates(val[0], val[1]));
-				if (!trackpoint.coordinates().isValid())
+				segment.setCoordinates(i, Coordinates(val[0], val[1]));
+				if (!segment.coordinates(i).isValid())
 					return false;
 			} else if (c == 2)
-				trackpoint.setElevation(val[2]);
+				segment.setElevation(i, val[2]);
 
 			while (cp->isSpace())
 				cp++;
@@ -105,8 +102,7 @@ bool KMLParser::pointCoordinates(Waypoint &waypoint)
 	QString data = _reader.readElementText();
 	const QChar *sp, *ep, *cp, *vp;
 	int c = 0;
-	qreal val[3];
-	bool res;
+	double val[3];
 
 
 	sp = data.constData();
@@ -121,8 +117,7 @@ bool KMLParser::pointCoordinates(Waypoint &waypoint)
 			if (c > 1)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			c++;
@@ -131,8 +126,7 @@ bool KMLParser::pointCoordinates(Waypoint &waypoint)
 			if (c < 1)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			waypoint.setCoordinates(Coordinates(val[0], val[1]));
@@ -155,8 +149,7 @@ bool KMLParser::lineCoordinates(SegmentData &segment)
 	QString data = _reader.readElementText();
 	const QChar *sp, *ep, *cp, *vp;
 	int c = 0;
-	qreal val[3];
-	bool res;
+	double val[3];
 
 
 	sp = data.constData();
@@ -171,8 +164,7 @@ bool KMLParser::lineCoordinates(SegmentData &segment)
 			if (c > 1)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			c++;
@@ -181,15 +173,15 @@ bool KMLParser::lineCoordinates(SegmentData &segment)
 			if (c < 1 || c > 2)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
-			segment.append(Trackpoint(Coordinates(val[0], val[1])));
-			if (!segment.last().coordinates().isValid())
+			Trackpoint t(Coordinates(val[0], val[1]));
+			if (!t.coordinates().isValid())
 				return false;
 			if (c == 2)
-				segment.last().setElevation(val[2]);
+				t.setElevation(val[2]);
+			segment.append(t);
 
 			while (cp->isSpace())
 				cp++;
@@ -206,8 +198,7 @@ bool KMLParser::polygonCoordinates(QVector<Coordinates> &points)
 	QString data = _reader.readElementText();
 	const QChar *sp, *ep, *cp, *vp;
 	int c = 0;
-	qreal val[3];
-	bool res;
+	double val[3];
 
 
 	sp = data.constData();
@@ -222,8 +213,7 @@ bool KMLParser::polygonCoordinates(QVector<Coordinates> &points)
 			if (c > 1)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			c++;
@@ -232,8 +222,7 @@ bool KMLParser::polygonCoordinates(QVector<Coordinates> &points)
 			if (c < 1 || c > 2)
 				return false;
 
-			val[c] = QString(vp, cp - vp).toDouble(&res);
-			if (!res)
+			if (!XMLValue::toDouble(vp, cp - vp, val[c]))
 				return false;
 
 			points.append(Coordinates(val[0], val[1]));
@@ -346,7 +335,7 @@ void KMLParser::heartRate(SegmentData &segment)
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("value")) {
 			if (i < segment.size())
-				segment[i++].setHeartRate(number());
+				segment.setHeartRate(i++, number());
 			else {
 				_reader.raiseError(error);
 				return;
@@ -367,7 +356,7 @@ void KMLParser::cadence(SegmentData &segment)
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("value")) {
 			if (i < segment.size())
-				segment[i++].setCadence(number());
+				segment.setCadence(i++, number());
 			else {
 				_reader.raiseError(error);
 				return;
@@ -388,7 +377,7 @@ void KMLParser::speed(SegmentData &segment)
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("value")) {
 			if (i < segment.size())
-				segment[i++].setSpeed(number());
+				segment.setSpeed(i++, number());
 			else {
 				_reader.raiseError(error);
 				return;
@@ -409,7 +398,7 @@ void KMLParser::temperature(SegmentData &segment)
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("value")) {
 			if (i < segment.size())
-				segment[i++].setTemperature(number());
+				segment.setTemperature(i++, number());
 			else {
 				_reader.raiseError(error);
 				return;
@@ -430,7 +419,7 @@ void KMLParser::power(SegmentData &segment)
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("value")) {
 			if (i < segment.size())
-				segment[i++].setPower(number());
+				segment.setPower(i++, number());
 			else {
 				_reader.raiseError(error);
 				return;
@@ -486,19 +475,20 @@ void KMLParser::track(SegmentData &segment)
 
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("when")) {
-			segment.append(Trackpoint());
-			segment.last().setTimestamp(time());
+			Trackpoint t;
+			t.setTimestamp(time());
+			segment.append(t);
 			if (_reader.error())
 				return;
 		} else if (_reader.name() == QLatin1String("coord")) {
 			if (i == segment.size()) {
 				_reader.raiseError(error);
 				return;
-			} else if (!coord(segment[i])) {
+			} else if (!coord(segment, i)) {
 				_reader.raiseError("Invalid coordinates");
 				return;
 			}
-			if (segment.at(i).coordinates().isNull())
+			if (segment.coordinates(i).isNull())
 				empty = true;
 			i++;
 		} else if (_reader.name() == QLatin1String("ExtendedData"))
@@ -517,7 +507,7 @@ void KMLParser::track(SegmentData &segment)
 	if (empty) {
 		SegmentData filtered;
 		for (int i = 0; i < segment.size(); i++)
-			if (!segment.at(i).coordinates().isNull())
+			if (!segment.coordinates(i).isNull())
 				filtered.append(segment.at(i));
 		segment = filtered;
 	}
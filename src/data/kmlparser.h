@@ -54,7 +54,7 @@ private:
 	bool pointCoordinates(Waypoint &waypoint);
 	bool lineCoordinates(SegmentData &segment);
 	bool polygonCoordinates(QVector<Coordinates> &points);
-	bool coord(Trackpoint &trackpoint);
+	bool coord(SegmentData &segment, int i);
 	void extendedData(SegmentData &segment);
 	void schemaData(SegmentData &segment);
 	void heartRate(SegmentData &segment);
@@ -2,6 +2,7 @@
 #define LINK_H
 
 #include <QString>
+#include <QDataStream>
 
 class Link {
 public:
@@ -19,4 +20,20 @@ private:
 	QString _text;
 };
 
+inline QDataStream &operator<<(QDataStream &out, const Link &link)
+{
+	out << link.URL() << link.text();
+	return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, Link &link)
+{
+	QString url, text;
+
+	in >> url >> text;
+	link = Link(url, text);
+
+	return in;
+}
+
 #endif // LINK_H
@@ -1,8 +1,13 @@
 #include <cstring>
 #include <QTimeZone>
+#include <QThread>
+#include <QtConcurrent>
 #include "common/util.h"
 #include "nmeaparser.h"
 
+#define LINE_LIMIT     1023
+#define MIN_CHUNK_SIZE (1 << 20)
+#define MAX_CHUNK_SIZE (1 << 26)
 
 static bool validSentence(const char  *line, int len)
 {
@@ -228,8 +233,7 @@ bool NMEAParser::readEW(const char *data, int len, qreal &lon)
 	return true;
 }
 
-bool NMEAParser::readRMC(CTX &ctx, const char *line, int len,
-  SegmentData &segment)
+bool NMEAParser::readRMC(CTX &ctx, const char *line, int len)
 {
 	int col = 1;
 	const char *vp = line;
@@ -282,25 +286,32 @@ bool NMEAParser::readRMC(CTX &ctx, const char *line, int len,
 	}
 
 	if (!date.isNull()) {
-		if (ctx.date.isNull() && !ctx.time.isNull() && !segment.isEmpty())
-			segment.last().setTimestamp(QDateTime(date, ctx.time,
-			  QTimeZone::utc()));
+		if (ctx.date.isNull()) {
+			ctx.firstDate = date;
+			ctx.firstTime = ctx.time;
+			ctx.firstHasTime = ctx.hasTime;
+			ctx.firstHead = ctx.head.size();
+			ctx.firstTail = ctx.tail.size();
+		}
 		ctx.date = date;
 	}
 
 	Coordinates c(lon, lat);
 	if (valid && !ctx.GGA && c.isValid()) {
 		Trackpoint t(c);
-		if (!ctx.date.isNull() && !time.isNull())
-			t.setTimestamp(QDateTime(ctx.date, time, QTimeZone::utc()));
-		segment.append(t);
+		if (!time.isNull()) {
+			if (!ctx.date.isNull())
+				t.setTimestamp(QDateTime(ctx.date, time, QTimeZone::utc()));
+			else
+				ctx.undated.append(Undated(true, ctx.head.size(), time));
+		}
+		ctx.head.append(t);
 	}
 
 	return true;
 }
 
-bool NMEAParser::readGGA(CTX &ctx, const char *line, int len,
-  SegmentData &segment)
+bool NMEAParser::readGGA(CTX &ctx, const char *line, int len)
 {
 	int col = 1;
 	const char *vp = line;
@@ -312,6 +323,7 @@ bool NMEAParser::readGGA(CTX &ctx, const char *line, int len,
 				case 1:
 					if (!readTime(vp, lp - vp, ctx.time))
 						return false;
+					ctx.hasTime = true;
 					break;
 				case 2:
 					if (!readLat(vp, lp - vp, lat))
@@ -364,11 +376,16 @@ bool NMEAParser::readGGA(CTX &ctx, const char *line, int len,
 	Coordinates c(lon, lat);
 	if (c.isValid()) {
 		Trackpoint t(c);
-		if (!(ctx.time.isNull() || ctx.date.isNull()))
-			t.setTimestamp(QDateTime(ctx.date, ctx.time, QTimeZone::utc()));
+		if (!ctx.time.isNull()) {
+			if (!ctx.date.isNull())
+				t.setTimestamp(QDateTime(ctx.date, ctx.time,
+				  QTimeZone::utc()));
+			else
+				ctx.undated.append(Undated(false, ctx.tail.size(), ctx.time));
+		}
 		if (!std::isnan(ele))
 			t.setElevation(ele - gh);
-		segment.append(t);
+		ctx.tail.append(t);
 
 		ctx.GGA = true;
 	}
@@ -481,41 +498,31 @@ bool NMEAParser::readZDA(CTX &ctx, const char *line, int len)
 	return true;
 }
 
-bool NMEAParser::parse(QFile *file, QList<TrackData> &tracks,
-  QList<RouteData> &routes, QList<Area> &polygons,
-  QVector<Waypoint> &waypoints)
+bool NMEAParser::readChunk(CTX &ctx)
 {
-	Q_UNUSED(routes);
-	Q_UNUSED(polygons);
+	const char *end = ctx.data + ctx.size;
 	qint64 len;
-	char line[1024];
-	SegmentData segment;
-	CTX ctx;
-
 
 	_errorLine = 1;
-	_errorString.clear();
 
-	while (!file->atEnd()) {
-		len = file->readLine(line, sizeof(line));
+	for (const char *line = ctx.data; line < end; line += len) {
+		const char *nl = (const char*)memchr(line, '\n', end - line);
+		len = nl ? nl - line + 1 : end - line;
 
-		if (len < 0) {
-			_errorString = "I/O error";
-			return false;
-		} else if (len >= (qint64)sizeof(line) - 1) {
+		if (len >= LINE_LIMIT) {
 			_errorString = "Line limit exceeded";
 			return false;
 		}
 
 		if (validSentence(line, len)) {
 			if (!memcmp(line + 3, "RMC,", 4)) {
-				if (!readRMC(ctx, line + 7, len - 7, segment))
+				if (!readRMC(ctx, line + 7, len - 7))
 					return false;
 			} else if (!memcmp(line + 3, "GGA,", 4)) {
-				if (!readGGA(ctx, line + 7, len - 7, segment))
+				if (!readGGA(ctx, line + 7, len - 7))
 					return false;
 			} else if (!memcmp(line + 3, "WPL,", 4)) {
-				if (!readWPL(line + 7, len - 7, waypoints))
+				if (!readWPL(line + 7, len - 7, ctx.waypoints))
 					return false;
 			} else if (!memcmp(line + 3, "ZDA,", 4)) {
 				if (!readZDA(ctx, line + 7, len - 7))
@@ -526,15 +533,141 @@ bool NMEAParser::parse(QFile *file, QList<TrackData> &tracks,
 		_errorLine++;
 	}
 
-	if (!segment.size() && !waypoints.size()) {
+	ctx.lines = _errorLine - 1;
+
+	return true;
+}
+
+void NMEAParser::parseChunk(CTX &ctx)
+{
+	NMEAParser parser;
+
+	if (!parser.readChunk(ctx)) {
+		ctx.errorLine = parser._errorLine;
+		ctx.errorString = parser._errorString;
+	}
+}
+
+void NMEAParser::merge(CTX &ctx, CTX &chunk)
+{
+	/* The chunk RMC points are only used when there was no GGA fix so far */
+	bool head = !ctx.GGA;
+
+	if (!ctx.date.isNull()) {
+		for (int i = 0; i < chunk.undated.size(); i++) {
+			const Undated &u = chunk.undated.at(i);
+			QDateTime ts(ctx.date, u.time, QTimeZone::utc());
+
+			if (u.head)
+				chunk.head.setTimestamp(u.index, ts);
+			else
+				chunk.tail.setTimestamp(u.index, ts);
+		}
+	} else if (!chunk.firstDate.isNull()) {
+		/* The first date in the file also sets the timestamp of the last
+		   point preceding it */
+		QTime time(chunk.firstHasTime ? chunk.firstTime : ctx.time);
+		QDateTime ts(chunk.firstDate, time, QTimeZone::utc());
+
+		if (!time.isNull()) {
+			if (chunk.firstTail)
+				chunk.tail.setTimestamp(chunk.firstTail - 1, ts);
+			else if (head && chunk.firstHead)
+				chunk.head.setTimestamp(chunk.firstHead - 1, ts);
+			else if (!ctx.tail.isEmpty())
+				ctx.tail.setTimestamp(ctx.tail.size() - 1, ts);
+		}
+	}
+
+	if (head)
+		ctx.tail << chunk.head;
+	ctx.tail << chunk.tail;
+	ctx.waypoints << chunk.waypoints;
+
+	if (chunk.GGA)
+		ctx.GGA = true;
+	if (chunk.hasTime)
+		ctx.time = chunk.time;
+	if (!chunk.date.isNull())
+		ctx.date = chunk.date;
+
+	chunk = CTX();
+}
+
+bool NMEAParser::parse(QFile *file, QList<TrackData> &tracks,
+  QList<RouteData> &routes, QList<Area> &polygons,
+  QVector<Waypoint> &waypoints)
+{
+	Q_UNUSED(routes);
+	Q_UNUSED(polygons);
+	QByteArray ba;
+	qint64 size = file->size();
+	QList<CTX> chunks;
+	/* Merged chunks, the track points are in ctx.tail */
+	CTX ctx;
+
+
+	_errorLine = 1;
+	_errorString.clear();
+
+	const char *data = (const char*)file->map(0, size);
+	bool mapped = (data != 0);
+	if (!mapped) {
+		ba = file->readAll();
+		if (ba.size() != size) {
+			_errorString = "I/O error";
+			return false;
+		}
+		data = ba.constData();
+	}
+
+	/* Split the file into chunks at line boundaries */
+	qint64 chunkSize = qBound((qint64)MIN_CHUNK_SIZE,
+	  size / QThread::idealThreadCount(), (qint64)MAX_CHUNK_SIZE);
+	for (qint64 offset = 0; offset < size; ) {
+		qint64 next = qMin(offset + chunkSize, size);
+		const char *nl = (const char*)memchr(data + next, '\n', size - next);
+		next = nl ? nl - data + 1 : size;
+
+		CTX chunk;
+		chunk.data = data + offset;
+		chunk.size = next - offset;
+		chunks.append(chunk);
+
+		offset = next;
+	}
+
+	QtConcurrent::blockingMap(chunks, parseChunk);
+
+	for (int i = 0; i < chunks.size(); i++) {
+		CTX &chunk = chunks[i];
+
+		if (!chunk.errorString.isEmpty()) {
+			_errorLine += chunk.errorLine - 1;
+			_errorString = chunk.errorString;
+			break;
+		}
+
+		_errorLine += chunk.lines;
+		merge(ctx, chunk);
+	}
+
+	if (mapped)
+		file->unmap((uchar*)data);
+	if (!_errorString.isEmpty())
+		return false;
+
+	waypoints << ctx.waypoints;
+
+	if (!ctx.tail.size() && !waypoints.size()) {
 		_errorString = "No usable NMEA sentence found";
 		return false;
 	}
 
-	if (segment.size()) {
+	if (ctx.tail.size()) {
 		tracks.append(TrackData());
 		tracks.last().setFile(file->fileName());
-		tracks.last().append(segment);
+		tracks.last().append(ctx.tail);
 	}
 
 	return true;
@@ -16,14 +16,55 @@ public:
 	int errorLine() const {return _errorLine;}
 
 private:
+	struct Undated {
+		Undated() : head(false), index(0) {}
+		Undated(bool head, int index, const QTime &time)
+		  : head(head), index(index), time(time) {}
+
+		bool head;
+		int index;
+		QTime time;
+	};
+
+	/*
+	  The file is parsed in chunks in parallel. A chunk does not know the
+	  state left by the previous chunks (date, GGA time, GGA fix presence),
+	  so everything depending on it is kept aside and resolved when the
+	  chunks are merged in order.
+	*/
 	struct CTX {
-		CTX() : GGA(false) {}
+		CTX() : data(0), size(0), lines(0), errorLine(0), GGA(false),
+		  hasTime(false), firstHasTime(false), firstHead(0), firstTail(0) {}
+
+		const char *data;
+		qint64 size;
+		int lines;
+		int errorLine;
+		QString errorString;
+
+		/* RMC points preceding the first GGA fix in the chunk */
+		SegmentData head;
+		SegmentData tail;
+		QVector<Waypoint> waypoints;
+		/* Points preceding the first date in the chunk */
+		QVector<Undated> undated;
 
 		QDate date;
 		QTime time;
 		bool GGA;
+		bool hasTime;
+
+		/* State at the first RMC date in the chunk */
+		QDate firstDate;
+		QTime firstTime;
+		bool firstHasTime;
+		int firstHead, firstTail;
 	};
 
+	static void parseChunk(CTX &ctx);
+	static void merge(CTX &ctx, CTX &chunk);
+
+	bool readChunk(CTX &ctx);
 	bool readEW(const char *data, int len, qreal &lon);
 	bool readLon(const char *data, int len, qreal &lon);
 	bool readNS(const char *data, int len, qreal &lat);
@@ -33,8 +74,8 @@ private:
 	bool readAltitude(const char *data, int len, qreal &ele);
 	bool readGeoidHeight(const char *data, int len, qreal &gh);
 
-	bool readRMC(CTX &ctx, const char *line, int len, SegmentData &segment);
-	bool readGGA(CTX &ctx, const char *line, int len, SegmentData &segment);
+	bool readRMC(CTX &ctx, const char *line, int len);
+	bool readGGA(CTX &ctx, const char *line, int len);
 	bool readWPL(const char *line, int len, QVector<Waypoint> &waypoints);
 	bool readZDA(CTX &ctx, const char *line, int len);
 
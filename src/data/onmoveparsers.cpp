@@ -109,16 +109,14 @@ bool OMDParser::readF2(const char *chunk, const Header &hdr, Sequence &seq,
 	quint8 hr2 = chunk[16];
 
 	if (seq.idx[0] >= 0) {
-		Trackpoint &p0 = segment[seq.idx[0]];
 		if (hdr.hr)
-			p0.setHeartRate(hr1);
-		p0.setSpeed(speed1 / 360.0);
+			segment.setHeartRate(seq.idx[0], hr1);
+		segment.setSpeed(seq.idx[0], speed1 / 360.0);
 	}
 	if (seq.idx[1] >= 0) {
-		Trackpoint &p1 = segment[seq.idx[1]];
 		if (hdr.hr)
-			p1.setHeartRate(hr2);
-		p1.setSpeed(speed2 / 360.0);
+			segment.setHeartRate(seq.idx[1], hr2);
+		segment.setSpeed(seq.idx[1], speed2 / 360.0);
 	}
 
 	seq.idx[0] = -1;
@@ -0,0 +1,370 @@
+#include <climits>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include "common/programpaths.h"
+#include "common/util.h"
+#include "parsecache.h"
+
+#define MAGIC    0x47504443 /* "GPDC" */
+#define VERSION  2
+/* Small files are parsed faster than their cache entries are checked */
+#define MIN_SIZE (1 << 20)
+/* Disk space budget of all the cache entries */
+#define MAX_SIZE (1 << 30)
+
+static QString cacheFile(const QFileInfo &fi)
+{
+	QByteArray hash(QCryptographicHash::hash(fi.absoluteFilePath().toUtf8(),
+	  QCryptographicHash::Sha1));
+	return QDir(ProgramPaths::parseCacheDir()).filePath(QString(hash.toHex()));
+}
+
+/* Images extracted to the temporary directory do not outlive the program */
+static bool temporary(const QVector<Waypoint> &waypoints)
+{
+	for (int i = 0; i < waypoints.size(); i++) {
+		const QVector<QString> &images = waypoints.at(i).images();
+		for (int j = 0; j < images.size(); j++)
+			if (images.at(j).startsWith(Util::tempDir().path()))
+				return true;
+	}
+
+	return false;
+}
+
+/* The entries are ordered by their last use (loads touch the entries
+   modification time), the least recently used entries over the budget are
+   removed */
+static void prune(const QString &current)
+{
+	QDir dir(ProgramPaths::parseCacheDir());
+	QFileInfoList entries(dir.entryInfoList(QDir::Files, QDir::Time));
+	qint64 size = 0;
+
+	for (int i = 0; i < entries.size(); i++) {
+		const QFileInfo &fi = entries.at(i);
+
+		size += fi.size();
+		if (size > MAX_SIZE && fi.absoluteFilePath() != current)
+			QFile::remove(fi.absoluteFilePath());
+	}
+}
+
+static void writeHeader(QDataStream &stream, const QFileInfo &fi)
+{
+	stream << (quint32)MAGIC << (quint32)VERSION
+	  << (quint8)QSysInfo::ByteOrder << QString(APP_VERSION)
+	  << fi.absoluteFilePath() << (qint64)fi.size()
+	  << (qint64)fi.lastModified().toMSecsSinceEpoch();
+}
+
+static bool readHeader(QDataStream &stream, const QFileInfo &fi)
+{
+	quint32 magic, version;
+	quint8 byteOrder;
+	QString appVersion, path;
+	qint64 size, mtime;
+
+	stream >> magic >> version >> byteOrder >> appVersion >> path >> size
+	  >> mtime;
+
+	return (stream.status() == QDataStream::Ok && magic == MAGIC
+	  && version == VERSION && byteOrder == (quint8)QSysInfo::ByteOrder
+	  && appVersion == APP_VERSION && path == fi.absoluteFilePath()
+	  && size == fi.size()
+	  && mtime == fi.lastModified().toMSecsSinceEpoch());
+}
+
+static bool readCount(QDataStream &stream, qint32 &count)
+{
+	stream >> count;
+	return (stream.status() == QDataStream::Ok && count >= 0);
+}
+
+static void writeWaypoints(QDataStream &stream,
+  const QVector<Waypoint> &waypoints)
+{
+	stream << (qint32)waypoints.size();
+	for (int i = 0; i < waypoints.size(); i++)
+		stream << waypoints.at(i);
+}
+
+static bool readWaypoints(QDataStream &stream, QVector<Waypoint> &waypoints)
+{
+	qint32 count;
+
+	if (!readCount(stream, count))
+		return false;
+	for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok;
+	  i++) {
+		Waypoint w;
+		stream >> w;
+		waypoints.append(w);
+	}
+
+	return (stream.status() == QDataStream::Ok);
+}
+
+static void writeTrack(QDataStream &stream, const TrackData &track)
+{
+	stream << (qint32)track.size();
+	for (int i = 0; i < track.size(); i++)
+		stream << track.at(i);
+	stream << track.name() << track.description() << track.comment()
+	  << track.file() << track.links() << track.style();
+}
+
+static bool readTrack(QDataStream &stream, TrackData &track)
+{
+	QString name, desc, comment, file;
+	QVector<Link> links;
+	LineStyle style;
+	qint32 count;
+
+	if (!readCount(stream, count))
+		return false;
+	for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok;
+	  i++) {
+		SegmentData segment;
+		stream >> segment;
+		track.append(segment);
+	}
+
+	stream >> name >> desc >> comment >> file >> links >> style;
+
+	track.setName(name);
+	track.setDescription(desc);
+	track.setComment(comment);
+	track.setFile(file);
+	for (int i = 0; i < links.size(); i++)
+		track.addLink(links.at(i));
+	track.setStyle(style);
+
+	return (stream.status() == QDataStream::Ok);
+}
+
+static void writeRoute(QDataStream &stream, const RouteData &route)
+{
+	writeWaypoints(stream, route);
+	stream << route.name() << route.description() << route.comment()
+	  << route.file() << route.links() << route.style();
+}
+
+static bool readRoute(QDataStream &stream, RouteData &route)
+{
+	QString name, desc, comment, file;
+	QVector<Link> links;
+	LineStyle style;
+
+	if (!readWaypoints(stream, route))
+		return false;
+	stream >> name >> desc >> comment >> file >> links >> style;
+
+	route.setName(name);
+	route.setDescription(desc);
+	route.setComment(comment);
+	route.setFile(file);
+	for (int i = 0; i < links.size(); i++)
+		route.addLink(links.at(i));
+	route.setStyle(style);
+
+	return (stream.status() == QDataStream::Ok);
+}
+
+static void writeArea(QDataStream &stream, const Area &area)
+{
+	const QList<Polygon> &polygons = area.polygons();
+
+	stream << (qint32)polygons.size();
+	for (int i = 0; i < polygons.size(); i++) {
+		const Polygon &polygon = polygons.at(i);
+
+		stream << (qint32)polygon.size();
+		for (int j = 0; j < polygon.size(); j++) {
+			const QVector<Coordinates> &path = polygon.at(j);
+
+			stream << (qint32)path.size();
+			for (int k = 0; k < path.size(); k++)
+				stream << path.at(k).lon() << path.at(k).lat();
+		}
+	}
+	stream << area.name() << area.description() << area.style();
+}
+
+static bool readArea(QDataStream &stream, Area &area)
+{
+	QString name, desc;
+	PolygonStyle style;
+	qint32 polygons, paths, points;
+
+	if (!readCount(stream, polygons))
+		return false;
+	for (qint32 i = 0; i < polygons; i++) {
+		Polygon polygon;
+
+		if (!readCount(stream, paths))
+			return false;
+		for (qint32 j = 0; j < paths; j++) {
+			if (!readCount(stream, points))
+				return false;
+
+			QVector<Coordinates> path;
+			for (qint32 k = 0; k < points
+			  && stream.status() == QDataStream::Ok; k++) {
+				double lon, lat;
+				stream >> lon >> lat;
+				path.append(Coordinates(lon, lat));
+			}
+			polygon.append(path);
+		}
+		area.append(polygon);
+	}
+
+	stream >> name >> desc >> style;
+
+	area.setName(name);
+	area.setDescription(desc);
+	area.setStyle(style);
+
+	return (stream.status() == QDataStream::Ok);
+}
+
+static bool readData(QDataStream &stream, QList<TrackData> &tracks,
+  QList<RouteData> &routes, QList<Area> &areas,
+  QVector<Waypoint> &waypoints)
+{
+	qint32 count;
+
+	if (!readCount(stream, count))
+		return false;
+	for (qint32 i = 0; i < count; i++) {
+		TrackData track;
+		if (!readTrack(stream, track))
+			return false;
+		tracks.append(track);
+	}
+
+	if (!readCount(stream, count))
+		return false;
+	for (qint32 i = 0; i < count; i++) {
+		RouteData route;
+		if (!readRoute(stream, route))
+			return false;
+		routes.append(route);
+	}
+
+	if (!readCount(stream, count))
+		return false;
+	for (qint32 i = 0; i < count; i++) {
+		Area area;
+		if (!readArea(stream, area))
+			return false;
+		areas.append(area);
+	}
+
+	return readWaypoints(stream, waypoints);
+}
+
+bool ParseCache::load(const QString &path, QList<TrackData> &tracks,
+  QList<RouteData> &routes, QList<Area> &areas,
+  QVector<Waypoint> &waypoints)
+{
+	QFileInfo fi(path);
+	QList<TrackData> t;
+	QList<RouteData> r;
+	QList<Area> a;
+	QVector<Waypoint> w;
+
+	if (fi.size() < MIN_SIZE)
+		return false;
+
+	QFile file(cacheFile(fi));
+	if (!file.open(QIODevice::ReadOnly) || file.size() > INT_MAX)
+		return false;
+
+	QByteArray ba;
+	uchar *map = file.map(0, file.size());
+	if (map)
+		ba = QByteArray::fromRawData((const char*)map, (int)file.size());
+	else
+		ba = file.readAll();
+
+	QDataStream stream(ba);
+	stream.setVersion(QDataStream::Qt_5_6);
+	bool ret = readHeader(stream, fi) && readData(stream, t, r, a, w);
+
+	if (map)
+		file.unmap(map);
+	if (!ret)
+		return false;
+
+	file.setFileTime(QDateTime::currentDateTime(),
+	  QFileDevice::FileModificationTime);
+
+	tracks.append(t);
+	routes.append(r);
+	areas.append(a);
+	waypoints << w;
+
+	return true;
+}
+
+void ParseCache::save(const QString &path, const QList<TrackData> &tracks,
+  const QList<RouteData> &routes, const QList<Area> &areas,
+  const QVector<Waypoint> &waypoints)
+{
+	QFileInfo fi(path);
+
+	if (fi.size() < MIN_SIZE || temporary(waypoints))
+		return;
+	for (int i = 0; i < routes.size(); i++)
+		if (temporary(routes.at(i)))
+			return;
+
+	if (!QDir().mkpath(ProgramPaths::parseCacheDir())) {
+		qWarning("%s: %s", qUtf8Printable(ProgramPaths::parseCacheDir()),
+		  "Error creating cache directory");
+		return;
+	}
+
+	QSaveFile file(cacheFile(fi));
+	if (!file.open(QIODevice::WriteOnly)) {
+		qWarning("%s: %s", qUtf8Printable(file.fileName()),
+		  qUtf8Printable(file.errorString()));
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_6);
+	writeHeader(stream, fi);
+	stream << (qint32)tracks.size();
+	for (int i = 0; i < tracks.size(); i++)
+		writeTrack(stream, tracks.at(i));
+	stream << (qint32)routes.size();
+	for (int i = 0; i < routes.size(); i++)
+		writeRoute(stream, routes.at(i));
+	stream << (qint32)areas.size();
+	for (int i = 0; i < areas.size(); i++)
+		writeArea(stream, areas.at(i));
+	writeWaypoints(stream, waypoints);
+
+	if (stream.status() != QDataStream::Ok || !file.commit()) {
+		qWarning("%s: %s", qUtf8Printable(file.fileName()),
+		  qUtf8Printable(file.errorString()));
+		return;
+	}
+
+	prune(QFileInfo(file.fileName()).absoluteFilePath());
+}
+
+void ParseCache::clear()
+{
+	QDir(ProgramPaths::parseCacheDir()).removeRecursively();
+}
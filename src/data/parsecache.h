@@ -0,0 +1,29 @@
+#ifndef PARSECACHE_H
+#define PARSECACHE_H
+
+#include <QList>
+#include <QVector>
+#include "trackdata.h"
+#include "routedata.h"
+#include "area.h"
+#include "waypoint.h"
+
+/*
+  Disk cache of the parsed data files. The parser output is stored in a
+  binary form keyed by the file path, size, modification time and program
+  version and loaded from a memory-mapped cache file when the same file is
+  opened again. The least recently used entries are removed when the cache
+  grows over its size limit.
+*/
+namespace ParseCache
+{
+	bool load(const QString &path, QList<TrackData> &tracks,
+	  QList<RouteData> &routes, QList<Area> &areas,
+	  QVector<Waypoint> &waypoints);
+	void save(const QString &path, const QList<TrackData> &tracks,
+	  const QList<RouteData> &routes, const QList<Area> &areas,
+	  const QVector<Waypoint> &waypoints);
+	void clear();
+}
+
+#endif // PARSECACHE_H
@@ -1,5 +1,7 @@
 #include <QFile>
 #include <QDir>
+#include <QTemporaryFile>
+#include <algorithm>
 #include "common/rectc.h"
 #include "common/greatcircle.h"
 #include "common/wgs84.h"
@@ -8,6 +10,96 @@
 #include "poi.h"
 
 
+#define SIMPLIFY_TOLERANCE 0.1 /* path simplification tolerance (x radius) */
+#define GROUP_SEGMENTS     64  /* max path segments searched at once */
+#define GROUP_EXTENT       8   /* max size of the searched area (x radius) */
+#define WAYPOINT_CACHE     4096 /* waypoints */
+
+static double lonDiff(double from, double to)
+{
+	double d = to - from;
+
+	if (d > 180.0)
+		d -= 360.0;
+	else if (d < -180.0)
+		d += 360.0;
+
+	return d;
+}
+
+/* Distance (in meters) of p from the a-b segment in a local equirectangular
+   projection and the relative position of the segment's nearest point. The
+   segments are at most "radius" long, so the projection error is negligible
+   for the radius check. */
+static double segmentDistance(const Coordinates &p, const Coordinates &a,
+  const Coordinates &b, double &pos)
+{
+	double k = cos(deg2rad(a.lat()));
+	double bx = lonDiff(a.lon(), b.lon()) * k;
+	double by = b.lat() - a.lat();
+	double px = lonDiff(a.lon(), p.lon()) * k;
+	double py = p.lat() - a.lat();
+	double l2 = bx * bx + by * by;
+
+	pos = (l2 > 0) ? qBound(0.0, (px * bx + py * by) / l2, 1.0) : 0;
+
+	double dx = px - pos * bx;
+	double dy = py - pos * by;
+
+	return deg2rad(sqrt(dx * dx + dy * dy)) * WGS84_RADIUS;
+}
+
+/* Drops the points closer than the tolerance to the previous kept point (all
+   the dropped path parts are then within the tolerance from the simplified
+   path) and splits the remaining segments longer than the radius along
+   their great circles. */
+QVector<POI::Vertex> POI::simplify(const PathSegment &segment,
+  double radius)
+{
+	double tolerance = radius * SIMPLIFY_TOLERANCE;
+	QVector<Vertex> v;
+
+	if (segment.isEmpty())
+		return v;
+
+	v.append(Vertex(segment.first().coordinates(),
+	  segment.first().distance()));
+
+	for (int i = 1; i < segment.size(); i++) {
+		const PathPoint &p = segment.at(i);
+		Vertex last(v.last());
+		double d = last.c.distanceTo(p.coordinates());
+
+		if (d < tolerance && i < segment.size() - 1)
+			continue;
+
+		unsigned n = (unsigned)ceil(d / radius);
+		if (n > 1) {
+			GreatCircle gc(last.c, p.coordinates());
+			double ds = p.distance() - last.distance;
+			for (unsigned k = 1; k < n; k++)
+				v.append(Vertex(gc.pointAt((double)k/n),
+				  last.distance + ds * k / n));
+		}
+
+		v.append(Vertex(p.coordinates(), p.distance()));
+	}
+
+	if (v.size() == 1)
+		v.append(v.first());
+
+	return v;
+}
+
+/* The waypoints are stored in the sidecar file in the index order, reading
+   them in the same order makes the file access sequential */
+static QList<int> sorted(const QSet<int> &set)
+{
+	QList<int> list(set.values());
+	std::sort(list.begin(), list.end());
+	return list;
+}
+
 static bool cb(size_t data, void* context)
 {
 	QSet<int> *set = (QSet<int>*) context;
@@ -16,13 +108,13 @@ static bool cb(size_t data, void* context)
 	return true;
 }
 
-POI::File::File(int start, int end, const QVector<Waypoint> &data)
+POI::File::File(int start, int end, const QVector<Coordinates> &coordinates)
   : _enabled(true)
 {
 	qreal c[2];
 
 	for (int i = start; i <= end; i++) {
-		const Coordinates &p = data.at(i).coordinates();
+		const Coordinates &p = coordinates.at(i);
 
 		c[0] = p.lon();
 		c[1] = p.lat();
@@ -62,11 +154,14 @@ POI::POI(QObject *parent) : QObject(parent)
 {
 	_errorLine = 0;
 	_radius = 1000;
+	_file = new QTemporaryFile(this);
+	_cache = new QCache<int, Waypoint>(WAYPOINT_CACHE);
 }
 
 POI::~POI()
 {
 	qDeleteAll(_files);
+	delete _cache;
 }
 
 bool POI::loadFile(const QString &path)
@@ -79,10 +174,60 @@ bool POI::loadFile(const QString &path)
 		return false;
 	}
 
-	int start = _data.size();
-	_data.append(data.waypoints());
+	if (!_file->isOpen() && !_file->open()) {
+		_errorString = _file->errorString();
+		_errorLine = 0;
+		return false;
+	}
+
+	if (!_file->seek(_file->size())) {
+		_errorString = _file->errorString();
+		_errorLine = 0;
+		return false;
+	}
 
-	_files.insert(path, new File(start, _data.size() - 1, _data));
+	const QVector<Waypoint> &waypoints = data.waypoints();
+	qint64 startPos = _file->pos();
+	int start = _coordinates.size();
+	int icons = _icons.size();
+	QHash<qint64, qint32> table;
+	QDataStream stream(_file);
+
+	for (int i = 0; i < waypoints.size(); i++) {
+		Waypoint w(waypoints.at(i));
+		qint32 icon = -1;
+
+		/* The icons are shared by many waypoints of the file, so only their
+		   index into the icon table is stored with the waypoints */
+		const QPixmap &pm = w.style().icon();
+		if (!pm.isNull()) {
+			QHash<qint64, qint32>::const_iterator it(table.constFind(
+			  pm.cacheKey()));
+			if (it == table.constEnd()) {
+				icon = _icons.size();
+				table.insert(pm.cacheKey(), icon);
+				_icons.append(pm);
+			} else
+				icon = *it;
+			w.setStyle(PointStyle(w.style().color(), w.style().size()));
+		}
+
+		_offsets.append(_file->pos());
+		_coordinates.append(w.coordinates());
+		stream << w << icon;
+	}
+	if (stream.status() != QDataStream::Ok) {
+		_errorString = _file->errorString();
+		_errorLine = 0;
+		_file->resize(startPos);
+		_offsets.resize(start);
+		_coordinates.resize(start);
+		_icons.resize(icons);
+		return false;
+	}
+
+	_files.insert(path, new File(start, _coordinates.size() - 1,
+	  _coordinates));
 
 	emit pointsChanged();
 
@@ -116,46 +261,142 @@ TreeNode<QString> POI::loadDir(const QString &path)
 	return tree;
 }
 
+Waypoint POI::waypoint(int i) const
+{
+	Waypoint *cached = _cache->object(i);
+	Waypoint w;
+	qint32 icon;
+
+	if (cached)
+		return *cached;
+
+	if (!_file->seek(_offsets.at(i))) {
+		qWarning("%s: %s", qUtf8Printable(_file->fileName()),
+		  qUtf8Printable(_file->errorString()));
+		return Waypoint();
+	}
+
+	QDataStream stream(_file);
+	stream >> w >> icon;
+	if (stream.status() != QDataStream::Ok) {
+		qWarning("%s: %s", qUtf8Printable(_file->fileName()),
+		  "Error reading POI data");
+		return Waypoint();
+	}
+
+	if (icon >= 0 && icon < _icons.size())
+		w.setStyle(PointStyle(_icons.at(icon), w.style().color(),
+		  w.style().size()));
+
+	_cache->insert(i, new Waypoint(w));
+
+	return w;
+}
+
 void POI::search(const RectC &rect, QSet<int> &set) const
 {
 	for (ConstIterator it = _files.constBegin(); it != _files.constEnd(); ++it)
 		(*it)->search(rect, set);
 }
 
-QList<Waypoint> POI::points(const Path &path) const
+void POI::corridor(const QVector<Vertex> &v, int start, int end,
+  QHash<int, double> &hits) const
 {
-	QList<Waypoint> ret;
+	double minLon = v.at(start).c.lon(), maxLon = minLon;
+	double minLat = v.at(start).c.lat(), maxLat = minLat;
 	QSet<int> set;
-	QSet<int>::const_iterator it;
 
+	for (int i = start + 1; i <= end; i++) {
+		const Coordinates &c = v.at(i).c;
+		minLon = qMin(minLon, c.lon());
+		maxLon = qMax(maxLon, c.lon());
+		minLat = qMin(minLat, c.lat());
+		maxLat = qMax(maxLat, c.lat());
+	}
 
-	for (int i = 0; i < path.count(); i++) {
-		const PathSegment &segment = path.at(i);
-
-		for (int j = 1; j < segment.size(); j++) {
-			double ds = segment.at(j).distance() - segment.at(j-1).distance();
-			unsigned n = (unsigned)ceil(ds / _radius);
-
-			if (n > 1) {
-				GreatCircle gc(segment.at(j-1).coordinates(),
-				  segment.at(j).coordinates());
-				for (unsigned k = 0; k < n; k++) {
-					RectC br(gc.pointAt((double)k/n), _radius);
-					search(br, set);
-				}
-			} else {
-				RectC br(segment.at(j-1).coordinates(), _radius);
-				search(br, set);
+	/* The simplified path may be up to the simplification tolerance away
+	   from the original path */
+	double radius = _radius * (1.0 + SIMPLIFY_TOLERANCE);
+	double dLat = rad2deg(radius / WGS84_RADIUS);
+	double dLon = dLat / qMax(cos(deg2rad(qMax(qAbs(minLat), qAbs(maxLat))
+	  + dLat)), 0.01);
+	search(RectC(Coordinates(qMax(minLon - dLon, -180.0), qMin(maxLat + dLat,
+	  90.0)), Coordinates(qMin(maxLon + dLon, 180.0), qMax(minLat - dLat,
+	  -90.0))), set);
+
+	for (QSet<int>::const_iterator it = set.constBegin(); it != set.constEnd();
+	  ++it) {
+		if (hits.contains(*it))
+			continue;
+
+		const Coordinates &p = _coordinates.at(*it);
+		double min = INFINITY, at = 0;
+
+		for (int i = start; i < end; i++) {
+			double pos;
+			double dist = segmentDistance(p, v.at(i).c, v.at(i+1).c, pos);
+			if (dist < min) {
+				min = dist;
+				at = v.at(i).distance + pos * (v.at(i+1).distance
+				  - v.at(i).distance);
 			}
 		}
+
+		if (min <= radius)
+			hits.insert(*it, at);
 	}
+}
 
-	RectC br(path.last().last().coordinates(), _radius);
-	search(br, set);
+QList<Waypoint> POI::points(const Path &path) const
+{
+	QList<Waypoint> ret;
+	QHash<int, double> hits;
 
+	/* Instead of searching the indexes for every path point, the simplified
+	   path is split into groups of segments and every index is searched
+	   only once for each group's envelope. */
+	for (int i = 0; i < path.count(); i++) {
+		QVector<Vertex> v(simplify(path.at(i), _radius));
+
+		for (int start = 0; start < v.size() - 1; ) {
+			double minLon = v.at(start).c.lon(), maxLon = minLon;
+			double minLat = v.at(start).c.lat(), maxLat = minLat;
+			int end;
+
+			for (end = start + 1; end < v.size(); end++) {
+				const Coordinates &c = v.at(end).c;
+				minLon = qMin(minLon, c.lon());
+				maxLon = qMax(maxLon, c.lon());
+				minLat = qMin(minLat, c.lat());
+				maxLat = qMax(maxLat, c.lat());
+
+				double w = deg2rad(maxLon - minLon) * WGS84_RADIUS
+				  * cos(deg2rad(minLat));
+				double h = deg2rad(maxLat - minLat) * WGS84_RADIUS;
+				if (end - start == GROUP_SEGMENTS || w > GROUP_EXTENT * _radius
+				  || h > GROUP_EXTENT * _radius)
+					break;
+			}
 
-	for (it = set.constBegin(); it != set.constEnd(); ++it)
-		ret.append(_data.at(*it));
+			end = qMin(end, v.size() - 1);
+			corridor(v, start, end, hits);
+			start = end;
+		}
+	}
+
+	QVector<QPair<double, int> > order;
+	order.reserve(hits.size());
+	for (QHash<int, double>::const_iterator it = hits.constBegin();
+	  it != hits.constEnd(); ++it)
+		order.append(QPair<double, int>(it.value(), it.key()));
+	std::sort(order.begin(), order.end());
+
+	ret.reserve(order.size());
+	for (int i = 0; i < order.size(); i++) {
+		Waypoint w(waypoint(order.at(i).second));
+		if (w.coordinates().isValid())
+			ret.append(w);
+	}
 
 	return ret;
 }
@@ -164,13 +405,16 @@ QList<Waypoint> POI::points(const Waypoint &point) const
 {
 	QList<Waypoint> ret;
 	QSet<int> set;
-	QSet<int>::const_iterator it;
 
 	RectC br(point.coordinates(), _radius);
 	search(br, set);
 
-	for (it = set.constBegin(); it != set.constEnd(); ++it)
-		ret.append(_data.at(*it));
+	QList<int> ids(sorted(set));
+	for (int i = 0; i < ids.size(); i++) {
+		Waypoint w(waypoint(ids.at(i)));
+		if (w.coordinates().isValid())
+			ret.append(w);
+	}
 
 	return ret;
 }
@@ -179,14 +423,17 @@ QList<Waypoint> POI::points(const RectC &rect) const
 {
 	QList<Waypoint> ret;
 	QSet<int> set;
-	QSet<int>::const_iterator it;
 
 	double offset = rad2deg(_radius / WGS84_RADIUS);
 	RectC br(rect.adjusted(-offset, offset, offset, -offset));
 	search(br, set);
 
-	for (it = set.constBegin(); it != set.constEnd(); ++it)
-		ret.append(_data.at(*it));
+	QList<int> ids(sorted(set));
+	for (int i = 0; i < ids.size(); i++) {
+		Waypoint w(waypoint(ids.at(i)));
+		if (w.coordinates().isValid())
+			ret.append(w);
+	}
 
 	return ret;
 }
@@ -5,11 +5,13 @@
 #include <QPointF>
 #include <QString>
 #include <QStringList>
+#include <QCache>
 #include "common/rtree.h"
 #include "common/treenode.h"
 #include "waypoint.h"
+#include "path.h"
 
-class Path;
+class QTemporaryFile;
 class RectC;
 
 class POI : public QObject
@@ -42,7 +44,7 @@ private:
 	typedef RTree<size_t, qreal, 2> POITree;
 	class File {
 	public:
-		File(int start, int end, const QVector<Waypoint> &data);
+		File(int start, int end, const QVector<Coordinates> &coordinates);
 
 		void search(const RectC &rect, QSet<int> &set) const;
 		void enable(bool enable) {_enabled = enable;}
@@ -51,12 +53,36 @@ private:
 		bool _enabled;
 		POITree _tree;
 	};
+	struct Vertex {
+		Vertex() : distance(0) {}
+		Vertex(const Coordinates &c, double distance)
+		  : c(c), distance(distance) {}
+
+		Coordinates c;
+		double distance;
+	};
+
 	typedef QHash<QString, File*>::const_iterator ConstIterator;
 	typedef QHash<QString, File*>::iterator Iterator;
 
+	/* Returns an invalid waypoint on sidecar file read errors */
+	Waypoint waypoint(int i) const;
 	void search(const RectC &rect, QSet<int> &set) const;
-
-	QVector<Waypoint> _data;
+	void corridor(const QVector<Vertex> &v, int start, int end,
+	  QHash<int, double> &hits) const;
+
+	static QVector<Vertex> simplify(const PathSegment &segment,
+	  double radius);
+
+	/* Only the coordinates (used for indexing) are kept in memory, the full
+	   waypoints are stored in a temporary file and loaded on demand for the
+	   points that are actually found. The waypoint icons are kept in the icon
+	   table. The recently loaded waypoints are cached. */
+	QVector<Coordinates> _coordinates;
+	QVector<qint64> _offsets;
+	QVector<QPixmap> _icons;
+	QTemporaryFile *_file;
+	QCache<int, Waypoint> *_cache;
 	QHash<QString, File*> _files;
 
 	unsigned _radius;
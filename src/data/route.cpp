@@ -54,12 +54,15 @@ Graph Route::demElevation(Map *map) const
 	Graph graph;
 	QDateTime date;
 	GraphSegment gs(date);
+	QVector<Coordinates> c(_data.size());
 
-	for (int i = 0; i < _data.size(); i++) {
-		qreal dem = map->elevation(_data.at(i).coordinates());
-		if (!std::isnan(dem))
-			gs.append(GraphPoint(_distance.at(i), NAN, dem));
-	}
+	for (int i = 0; i < _data.size(); i++)
+		c[i] = _data.at(i).coordinates();
+	QVector<double> dem(map->elevations(c));
+
+	for (int i = 0; i < _data.size(); i++)
+		if (!std::isnan(dem.at(i)))
+			gs.append(GraphPoint(_distance.at(i), NAN, dem.at(i)));
 
 	if (gs.size() >= 2)
 		graph.append(gs);
@@ -0,0 +1,204 @@
+#include <climits>
+#include <limits>
+#include "segmentdata.h"
+
+const qint64 SegmentData::NO_TIME = std::numeric_limits<qint64>::min();
+
+template <class T>
+static void allocate(QVector<T> &column, int size, int capacity, const T &null)
+{
+	column.reserve(capacity);
+	column.fill(null, size);
+}
+
+template <class T>
+static void merge(QVector<T> &dst, int dstSize, const QVector<T> &src,
+  int srcSize, const T &null)
+{
+	if (src.isEmpty()) {
+		if (!dst.isEmpty())
+			dst.insert(dst.end(), srcSize, null);
+	} else {
+		if (dst.isEmpty())
+			allocate(dst, dstSize, dstSize + srcSize, null);
+		dst << src;
+	}
+}
+
+static qint64 msecs(const QDateTime &timestamp)
+{
+	return timestamp.isValid()
+	  ? timestamp.toMSecsSinceEpoch() : SegmentData::NO_TIME;
+}
+
+void SegmentData::reserve(int size)
+{
+	_coordinates.reserve(size);
+	if (!_time.isEmpty())
+		_time.reserve(size);
+	for (int i = 0; i < Channels; i++)
+		if (!_channels[i].isEmpty())
+			_channels[i].reserve(size);
+}
+
+void SegmentData::append(const Trackpoint &trackpoint)
+{
+	int size = _coordinates.size();
+	qint64 t = msecs(trackpoint.timestamp());
+
+	if (!_time.isEmpty())
+		_time.append(t);
+	else if (t != NO_TIME) {
+		allocate(_time, size, _coordinates.capacity(), NO_TIME);
+		_time.append(t);
+	}
+
+	for (int i = 0; i < Channels; i++) {
+		QVector<qreal> &column = _channels[i];
+		qreal val = value(trackpoint, (Channel)i);
+
+		if (!column.isEmpty())
+			column.append(val);
+		else if (!std::isnan(val)) {
+			allocate(column, size, _coordinates.capacity(), (qreal)NAN);
+			column.append(val);
+		}
+	}
+
+	_coordinates.append(trackpoint.coordinates());
+}
+
+SegmentData &SegmentData::operator<<(const SegmentData &other)
+{
+	int size = _coordinates.size();
+
+	merge(_time, size, other._time, other.size(), NO_TIME);
+	for (int i = 0; i < Channels; i++)
+		merge(_channels[i], size, other._channels[i], other.size(),
+		  (qreal)NAN);
+	_coordinates << other._coordinates;
+
+	return *this;
+}
+
+qreal SegmentData::value(const Trackpoint &trackpoint, Channel channel)
+{
+	switch (channel) {
+		case Elevation:
+			return trackpoint.elevation();
+		case Speed:
+			return trackpoint.speed();
+		case HeartRate:
+			return trackpoint.heartRate();
+		case Temperature:
+			return trackpoint.temperature();
+		case Cadence:
+			return trackpoint.cadence();
+		case Power:
+			return trackpoint.power();
+		default:
+			return trackpoint.ratio();
+	}
+}
+
+Trackpoint SegmentData::at(int i) const
+{
+	Trackpoint t(_coordinates.at(i));
+
+	if (hasTimestamp(i))
+		t.setTimestamp(timestamp(i));
+	t.setElevation(elevation(i));
+	t.setSpeed(speed(i));
+	t.setHeartRate(heartRate(i));
+	t.setTemperature(temperature(i));
+	t.setCadence(cadence(i));
+	t.setPower(power(i));
+	t.setRatio(ratio(i));
+
+	return t;
+}
+
+QDateTime SegmentData::timestamp(int i) const
+{
+	qint64 t = time(i);
+	return (t == NO_TIME) ? QDateTime() : QDateTime::fromMSecsSinceEpoch(t,
+	  Qt::UTC);
+}
+
+void SegmentData::setTimestamp(int i, const QDateTime &timestamp)
+{
+	qint64 t = msecs(timestamp);
+
+	if (_time.isEmpty()) {
+		if (t == NO_TIME)
+			return;
+		allocate(_time, _coordinates.size(), _coordinates.capacity(),
+		  NO_TIME);
+	}
+
+	_time[i] = t;
+}
+
+void SegmentData::setValue(Channel channel, int i, qreal value)
+{
+	QVector<qreal> &column = _channels[channel];
+
+	if (column.isEmpty()) {
+		if (std::isnan(value))
+			return;
+		allocate(column, _coordinates.size(), _coordinates.capacity(),
+		  (qreal)NAN);
+	}
+
+	column[i] = value;
+}
+
+/* The columns are stored as raw memory blocks (in the host byte order) so
+   that they can be loaded without any per-point processing */
+template <class T>
+static void writeColumn(QDataStream &stream, const QVector<T> &column)
+{
+	stream << (qint32)column.size();
+	stream.writeRawData((const char*)column.constData(),
+	  column.size() * sizeof(T));
+}
+
+template <class T>
+static bool readColumn(QDataStream &stream, QVector<T> &column, int size)
+{
+	qint32 cs;
+
+	stream >> cs;
+	if (stream.status() != QDataStream::Ok || cs < 0
+	  || (size >= 0 && cs && cs != size) || cs > INT_MAX / (int)sizeof(T))
+		return false;
+
+	column.resize(cs);
+	int len = cs * sizeof(T);
+	return (stream.readRawData((char*)column.data(), len) == len);
+}
+
+QDataStream &operator<<(QDataStream &stream, const SegmentData &segment)
+{
+	writeColumn(stream, segment._coordinates);
+	writeColumn(stream, segment._time);
+	for (int i = 0; i < SegmentData::Channels; i++)
+		writeColumn(stream, segment._channels[i]);
+
+	return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, SegmentData &segment)
+{
+	bool ok = readColumn(stream, segment._coordinates, -1)
+	  && readColumn(stream, segment._time, segment.size());
+	for (int i = 0; ok && i < SegmentData::Channels; i++)
+		ok = readColumn(stream, segment._channels[i], segment.size());
+
+	if (!ok) {
+		segment = SegmentData();
+		stream.setStatus(QDataStream::ReadCorruptData);
+	}
+
+	return stream;
+}
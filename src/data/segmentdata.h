@@ -0,0 +1,96 @@
+#ifndef SEGMENTDATA_H
+#define SEGMENTDATA_H
+
+#include <QVector>
+#include <QDateTime>
+#include <QDataStream>
+#include <cmath>
+#include "common/coordinates.h"
+#include "trackpoint.h"
+
+/*
+  Track segment data stored by columns - every trackpoint attribute has its
+  own contiguous array. The optional attributes (timestamps, elevation,
+  speed, ...) are allocated once the first point having the attribute is
+  added, so attributes missing in the whole segment take no memory. Missing
+  values of allocated attributes are marked with NaN (NO_TIME for the
+  timestamps). Timestamps are stored as UTC milliseconds since epoch.
+*/
+class SegmentData
+{
+public:
+	static const qint64 NO_TIME;
+
+	SegmentData() {}
+
+	int size() const {return _coordinates.size();}
+	int count() const {return _coordinates.size();}
+	bool isEmpty() const {return _coordinates.isEmpty();}
+	void reserve(int size);
+
+	void append(const Trackpoint &trackpoint);
+	SegmentData &operator<<(const SegmentData &other);
+
+	Trackpoint at(int i) const;
+	Trackpoint first() const {return at(0);}
+	Trackpoint last() const {return at(_coordinates.size() - 1);}
+
+	const QVector<Coordinates> &coordinates() const {return _coordinates;}
+	const Coordinates &coordinates(int i) const {return _coordinates.at(i);}
+	qint64 time(int i) const
+	  {return _time.isEmpty() ? NO_TIME : _time.at(i);}
+	QDateTime timestamp(int i) const;
+	qreal elevation(int i) const {return value(Elevation, i);}
+	qreal speed(int i) const {return value(Speed, i);}
+	qreal heartRate(int i) const {return value(HeartRate, i);}
+	qreal temperature(int i) const {return value(Temperature, i);}
+	qreal cadence(int i) const {return value(Cadence, i);}
+	qreal power(int i) const {return value(Power, i);}
+	qreal ratio(int i) const {return value(Ratio, i);}
+
+	bool hasTimestamp(int i) const {return (time(i) != NO_TIME);}
+	bool hasElevation(int i) const {return !std::isnan(elevation(i));}
+	bool hasSpeed(int i) const {return !std::isnan(speed(i));}
+	bool hasHeartRate(int i) const {return !std::isnan(heartRate(i));}
+	bool hasTemperature(int i) const {return !std::isnan(temperature(i));}
+	bool hasCadence(int i) const {return !std::isnan(cadence(i));}
+	bool hasPower(int i) const {return !std::isnan(power(i));}
+	bool hasRatio(int i) const {return !std::isnan(ratio(i));}
+
+	void setCoordinates(int i, const Coordinates &coordinates)
+	  {_coordinates[i] = coordinates;}
+	void setTimestamp(int i, const QDateTime &timestamp);
+	void setElevation(int i, qreal elevation)
+	  {setValue(Elevation, i, elevation);}
+	void setSpeed(int i, qreal speed) {setValue(Speed, i, speed);}
+	void setHeartRate(int i, qreal heartRate)
+	  {setValue(HeartRate, i, heartRate);}
+	void setTemperature(int i, qreal temperature)
+	  {setValue(Temperature, i, temperature);}
+	void setCadence(int i, qreal cadence) {setValue(Cadence, i, cadence);}
+	void setPower(int i, qreal power) {setValue(Power, i, power);}
+	void setRatio(int i, qreal ratio) {setValue(Ratio, i, ratio);}
+
+private:
+	enum Channel {Elevation, Speed, HeartRate, Temperature, Cadence, Power,
+	  Ratio, Channels};
+
+	qreal value(Channel channel, int i) const
+	  {return _channels[channel].isEmpty() ? NAN : _channels[channel].at(i);}
+	void setValue(Channel channel, int i, qreal value);
+
+	static qreal value(const Trackpoint &trackpoint, Channel channel);
+
+	friend QDataStream &operator<<(QDataStream &stream,
+	  const SegmentData &segment);
+	friend QDataStream &operator>>(QDataStream &stream, SegmentData &segment);
+
+	QVector<Coordinates> _coordinates;
+	QVector<qint64> _time;
+	QVector<qreal> _channels[Channels];
+};
+
+QDataStream &operator<<(QDataStream &stream, const SegmentData &segment);
+QDataStream &operator>>(QDataStream &stream, SegmentData &segment);
+
+#endif // SEGMENTDATA_H
@@ -4,6 +4,7 @@
 #include <QPen>
 #include <QBrush>
 #include <QPixmap>
+#include <QDataStream>
 
 class PointStyle {
 public:
@@ -59,4 +60,58 @@ private:
 	Qt::PenStyle _style;
 };
 
+inline QDataStream &operator<<(QDataStream &out, const PointStyle &style)
+{
+	out << style.icon() << style.color() << static_cast<qint32>(style.size());
+	return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, PointStyle &style)
+{
+	QPixmap icon;
+	QColor color;
+	qint32 size;
+
+	in >> icon >> color >> size;
+	style = PointStyle(icon, color, size);
+
+	return in;
+}
+
+inline QDataStream &operator<<(QDataStream &out, const PolygonStyle &style)
+{
+	out << style.fill() << style.stroke() << static_cast<double>(style.width());
+	return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, PolygonStyle &style)
+{
+	QColor fill, stroke;
+	double width;
+
+	in >> fill >> stroke >> width;
+	style = PolygonStyle(fill, stroke, width);
+
+	return in;
+}
+
+inline QDataStream &operator<<(QDataStream &out, const LineStyle &style)
+{
+	out << style.color() << static_cast<double>(style.width())
+	  << static_cast<qint32>(style.style());
+	return out;
+}
+
+inline QDataStream &operator>>(QDataStream &in, LineStyle &style)
+{
+	QColor color;
+	double width;
+	qint32 penStyle;
+
+	in >> color >> width >> penStyle;
+	style = LineStyle(color, width, static_cast<Qt::PenStyle>(penStyle));
+
+	return in;
+}
+
 #endif // STYLE_H
@@ -1,3 +1,4 @@
+#include "xmlvalue.h"
 #include "tcxparser.h"
 
 
@@ -10,9 +11,8 @@ void TCXParser::warning(const char *text) const
 
 qreal TCXParser::number()
 {
-	bool res;
-	qreal ret = _reader.readElementText().toDouble(&res);
-	if (!res)
+	double ret = NAN;
+	if (!XMLValue::number(_reader, ret))
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
 
@@ -21,9 +21,8 @@ qreal TCXParser::number()
 
 QDateTime TCXParser::time()
 {
-	QDateTime d = QDateTime::fromString(_reader.readElementText(),
-	  Qt::ISODate);
-	if (!d.isValid())
+	QDateTime d;
+	if (!XMLValue::dateTime(_reader, d))
 		_reader.raiseError(QString("Invalid %1").arg(
 		  _reader.name().toString()));
 
@@ -33,19 +32,18 @@ QDateTime TCXParser::time()
 Coordinates TCXParser::position()
 {
 	Coordinates pos;
-	qreal val;
-	bool res;
+	double val;
 
 	while (_reader.readNextStartElement()) {
 		if (_reader.name() == QLatin1String("LatitudeDegrees")) {
-			val = _reader.readElementText().toDouble(&res);
-			if (!res || (val < -90.0 || val > 90.0))
+			if (!XMLValue::number(_reader, val)
+			  || (val < -90.0 || val > 90.0))
 				_reader.raiseError("Invalid LatitudeDegrees");
 			else
 				pos.setLat(val);
 		} else if (_reader.name() == QLatin1String("LongitudeDegrees")) {
-			val = _reader.readElementText().toDouble(&res);
-			if (!res || (val < -180.0 || val > 180.0))
+			if (!XMLValue::number(_reader, val)
+			  || (val < -180.0 || val > 180.0))
 				_reader.raiseError("Invalid LongitudeDegrees");
 			else
 				pos.setLon(val);
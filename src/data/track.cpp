@@ -49,9 +49,9 @@ static qreal MAD(QVector<qreal> &v, qreal m)
    the normal distribution thus a higher comparsion value than the usual 3.5 is
    required.
 */
-static QSet<int> eliminate(const QVector<qreal> &v)
+static QBitArray eliminate(const QVector<qreal> &v)
 {
-	QSet<int> rm;
+	QBitArray rm(v.size());
 
 	QVector<qreal> w(v);
 	qreal m = median(w);
@@ -59,7 +59,7 @@ static QSet<int> eliminate(const QVector<qreal> &v)
 
 	for (int i = 0; i < v.size(); i++)
 		if (qAbs((0.6745 * (v.at(i) - m)) / M) > 5.0)
-			rm.insert(i);
+			rm.setBit(i);
 
 	return rm;
 }
@@ -132,25 +132,26 @@ Track::Track(const TrackData &data) : _pause(0)
 
 		Segment &seg = _segments.last();
 
-		seg.start = sd.first().timestamp();
+		seg.start = sd.timestamp(0);
 		seg.distance.append(lastDistance(i));
-		seg.time.append(sd.first().hasTimestamp() ? lastTime(i) : NAN);
-		seg.speed.append(sd.first().hasTimestamp() ? 0 : NAN);
-		acceleration.append(sd.first().hasTimestamp() ? 0 : NAN);
+		seg.time.append(sd.hasTimestamp(0) ? lastTime(i) : NAN);
+		seg.speed.append(sd.hasTimestamp(0) ? 0 : NAN);
+		acceleration.append(sd.hasTimestamp(0) ? 0 : NAN);
+		seg.stop = QBitArray(sd.size());
+		seg.outliers = QBitArray(sd.size());
 		bool hasTime = !std::isnan(seg.time.first());
 
 		for (int j = 1; j < sd.size(); j++) {
-			ds = sd.at(j).coordinates().distanceTo(sd.at(j-1).coordinates());
+			ds = sd.coordinates(j).distanceTo(sd.coordinates(j-1));
 			seg.distance.append(seg.distance.last() + ds);
 
-			if (hasTime && sd.at(j).timestamp().isValid()) {
-				if (sd.at(j).timestamp() > sd.at(j-1).timestamp())
-					dt = sd.at(j-1).timestamp().msecsTo(
-					  sd.at(j).timestamp()) / 1000.0;
+			if (hasTime && sd.hasTimestamp(j)) {
+				if (sd.time(j) > sd.time(j-1))
+					dt = (sd.time(j) - sd.time(j-1)) / 1000.0;
 				else {
 					qWarning("%s: %s: time skew detected",
 					  qUtf8Printable(_data.name()),
-					  qUtf8Printable(sd.at(j).timestamp().toString(Qt::ISODate)));
+					  qUtf8Printable(sd.timestamp(j).toString(Qt::ISODate)));
 					dt = 0;
 				}
 			} else {
@@ -204,8 +205,7 @@ Track::Track(const TrackData &data) : _pause(0)
 				if (ss >= 0 && seg.time.at(j) > seg.time.at(ss) + pauseInterval) {
 					int l = qMax(ss, la);
 					_pause += seg.time.at(j) - seg.time.at(l);
-					for (int k = l; k <= j; k++)
-						seg.stop.insert(k);
+					seg.stop.fill(true, l, j + 1);
 					la = j;
 				}
 			}
@@ -219,27 +219,24 @@ Track::Track(const TrackData &data) : _pause(0)
 		seg.outliers = eliminate(acceleration);
 
 		// stop-points can not be outliers
-		QSet<int>::const_iterator it;
-		for (it = seg.stop.constBegin(); it != seg.stop.constEnd(); ++it)
-			seg.outliers.remove(*it);
+		seg.outliers &= ~seg.stop;
 
 		// recompute distances (and dependand data) without outliers
 		int last = 0;
 		for (int j = 0; j < sd.size(); j++) {
-			if (seg.outliers.contains(j))
+			if (seg.outliers.testBit(j))
 				last++;
 			else
 				break;
 		}
 		for (int j = last + 1; j < sd.size(); j++) {
-			if (seg.outliers.contains(j))
+			if (seg.outliers.testBit(j))
 				continue;
 			if (discardStopPoint(seg, j)) {
 				seg.distance[j] = seg.distance.at(last);
 				seg.speed[j] = 0;
 			} else {
-				ds = sd.at(j).coordinates().distanceTo(
-				  sd.at(last).coordinates());
+				ds = sd.coordinates(j).distanceTo(sd.coordinates(last));
 				seg.distance[j] = seg.distance.at(last) + ds;
 
 				dt = seg.time.at(j) - seg.time.at(last);
@@ -262,10 +259,10 @@ Graph Track::gpsElevation() const
 		GraphSegment gs(seg.start);
 
 		for (int j = 0; j < sd.size(); j++) {
-			if (!sd.at(j).hasElevation() || seg.outliers.contains(j))
+			if (!sd.hasElevation(j) || seg.outliers.testBit(j))
 				continue;
 			gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j),
-			  sd.at(j).elevation()));
+			  sd.elevation(j)));
 		}
 
 		if (gs.size() >= 2)
@@ -288,12 +285,13 @@ Graph Track::demElevation(Map *map) const
 			continue;
 		const Segment &seg = _segments.at(i);
 		GraphSegment gs(seg.start);
+		QVector<double> dem(map->elevations(sd.coordinates()));
 
 		for (int j = 0; j < sd.size(); j++) {
-			qreal dem = map->elevation(sd.at(j).coordinates());
-			if (std::isnan(dem) || seg.outliers.contains(j))
+			if (std::isnan(dem.at(j)) || seg.outliers.testBit(j))
 				continue;
-			gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j), dem));
+			gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j),
+			  dem.at(j)));
 		}
 
 		if (gs.size() >= 2)
@@ -335,10 +333,10 @@ Graph Track::computedSpeed() const
 		qreal v;
 
 		for (int j = 0; j < sd.size(); j++) {
-			if (seg.stop.contains(j) && !std::isnan(seg.speed.at(j))) {
+			if (seg.stop.testBit(j) && !std::isnan(seg.speed.at(j))) {
 				v = 0;
 				stop.append(gs.size());
-			} else if (!std::isnan(seg.speed.at(j)) && !seg.outliers.contains(j))
+			} else if (!std::isnan(seg.speed.at(j)) && !seg.outliers.testBit(j))
 				v = seg.speed.at(j);
 			else
 				continue;
@@ -375,11 +373,11 @@ Graph Track::reportedSpeed() const
 		qreal v;
 
 		for (int j = 0; j < sd.size(); j++) {
-			if (seg.stop.contains(j) && sd.at(j).hasSpeed()) {
+			if (seg.stop.testBit(j) && sd.hasSpeed(j)) {
 				v = 0;
 				stop.append(gs.size());
-			} else if (sd.at(j).hasSpeed() && !seg.outliers.contains(j))
-				v = sd.at(j).speed();
+			} else if (sd.hasSpeed(j) && !seg.outliers.testBit(j))
+				v = sd.speed(j);
 			else
 				continue;
 
@@ -428,9 +426,9 @@ Graph Track::heartRate() const
 		GraphSegment gs(seg.start);
 
 		for (int j = 0; j < sd.size(); j++)
-			if (sd.at(j).hasHeartRate() && !seg.outliers.contains(j))
+			if (sd.hasHeartRate(j) && !seg.outliers.testBit(j))
 				gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j),
-				  sd.at(j).heartRate()));
+				  sd.heartRate(j)));
 
 		if (gs.size() >= 2)
 			ret.append(filter(gs, _heartRateWindow));
@@ -454,9 +452,9 @@ Graph Track::temperature() const
 		GraphSegment gs(seg.start);
 
 		for (int j = 0; j < sd.count(); j++) {
-			if (sd.at(j).hasTemperature() && !seg.outliers.contains(j))
+			if (sd.hasTemperature(j) && !seg.outliers.testBit(j))
 				gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j),
-				  sd.at(j).temperature()));
+				  sd.temperature(j)));
 		}
 
 		if (gs.size() >= 2)
@@ -481,9 +479,9 @@ Graph Track::ratio() const
 		GraphSegment gs(seg.start);
 
 		for (int j = 0; j < sd.size(); j++)
-			if (sd.at(j).hasRatio() && !seg.outliers.contains(j))
+			if (sd.hasRatio(j) && !seg.outliers.testBit(j))
 				gs.append(GraphPoint(seg.distance.at(j), seg.time.at(j),
-				  sd.at(j).ratio()));
+				  sd.ratio(j)));
 
 		if (gs.size() >= 2)
 			ret.append(gs);
@@ -509,11 +507,11 @@ Graph Track::cadence() const
 		qreal c;
 
 		for (int j = 0; j < sd.size(); j++) {
-			if (sd.at(j).hasCadence() && seg.stop.contains(j)) {
+			if (sd.hasCadence(j) && seg.stop.testBit(j)) {
 				c = 0;
 				stop.append(gs.size());
-			} else if (sd.at(j).hasCadence() && !seg.outliers.contains(j))
-				c = sd.at(j).cadence();
+			} else if (sd.hasCadence(j) && !seg.outliers.testBit(j))
+				c = sd.cadence(j);
 			else
 				continue;
 
@@ -550,11 +548,11 @@ Graph Track::power() const
 		GraphSegment gs(seg.start);
 
 		for (int j = 0; j < sd.size(); j++) {
-			if (sd.at(j).hasPower() && seg.stop.contains(j)) {
+			if (sd.hasPower(j) && seg.stop.testBit(j)) {
 				p = 0;
 				stop.append(gs.size());
-			} else if (sd.at(j).hasPower() && !seg.outliers.contains(j))
-				p = sd.at(j).power();
+			} else if (sd.hasPower(j) && !seg.outliers.testBit(j))
+				p = sd.power(j);
 			else
 				continue;
 
@@ -582,7 +580,7 @@ qreal Track::distance() const
 		const Segment &seg = _segments.at(i);
 
 		for (int j = seg.distance.size() - 1; j >= 0; j--)
-			if (!seg.outliers.contains(j))
+			if (!seg.outliers.testBit(j))
 				return seg.distance.at(j);
 	}
 
@@ -595,7 +593,7 @@ qreal Track::time() const
 		const Segment &seg = _segments.at(i);
 
 		for (int j = seg.time.size() - 1; j >= 0; j--)
-			if (!seg.outliers.contains(j))
+			if (!seg.outliers.testBit(j))
 				return seg.time.at(j);
 	}
 
@@ -610,7 +608,7 @@ qreal Track::movingTime() const
 QDateTime Track::date() const
 {
 	return (_data.size() && _data.first().size())
-	  ? _data.first().first().timestamp() : QDateTime();
+	  ? _data.first().timestamp(0) : QDateTime();
 }
 
 Path Track::path() const
@@ -626,8 +624,8 @@ Path Track::path() const
 		PathSegment &ps = ret.last();
 
 		for (int j = 0; j < sd.size(); j++)
-			if (!seg.outliers.contains(j) && !discardStopPoint(seg, j))
-				ps.append(PathPoint(sd.at(j).coordinates(),
+			if (!seg.outliers.testBit(j) && !discardStopPoint(seg, j))
+				ps.append(PathPoint(sd.coordinates(j),
 				  seg.distance.at(j)));
 	}
 
@@ -638,8 +636,8 @@ Path Track::path() const
 
 bool Track::discardStopPoint(const Segment &seg, int i) const
 {
-	return (seg.stop.contains(i) && seg.stop.contains(i-1)
-	  && seg.stop.contains(i+1) && i > 0 && i < seg.distance.size() - 1);
+	return (i > 0 && i < seg.distance.size() - 1 && seg.stop.testBit(i)
+	  && seg.stop.testBit(i-1) && seg.stop.testBit(i+1));
 }
 
 bool Track::isValid() const
@@ -2,7 +2,7 @@
 #define TRACK_H
 
 #include <QVector>
-#include <QSet>
+#include <QBitArray>
 #include <QDateTime>
 #include <QDir>
 #include "trackdata.h"
@@ -63,8 +63,8 @@ private:
 		QVector<qreal> distance;
 		QVector<qreal> time;
 		QVector<qreal> speed;
-		QSet<int> outliers;
-		QSet<int> stop;
+		QBitArray outliers;
+		QBitArray stop;
 	};
 
 	qreal lastDistance(int seg);
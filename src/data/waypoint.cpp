@@ -50,3 +50,27 @@ const QPixmap *Waypoint::symbolIcon(const QString &symbol)
 	QHash<QString, QPixmap>::const_iterator it(_symbolIcons.find(symbol));
 	return (it == _symbolIcons.constEnd()) ? 0 : &*it;
 }
+
+QDataStream &operator<<(QDataStream &out, const Waypoint &waypoint)
+{
+	out << waypoint._coordinates.lon() << waypoint._coordinates.lat()
+	  << waypoint._name << waypoint._description << waypoint._comment
+	  << waypoint._address << waypoint._phone << waypoint._symbol
+	  << waypoint._images << waypoint._links << waypoint._timestamp
+	  << static_cast<double>(waypoint._elevation) << waypoint._style;
+	return out;
+}
+
+QDataStream &operator>>(QDataStream &in, Waypoint &waypoint)
+{
+	double lon, lat, elevation;
+
+	in >> lon >> lat >> waypoint._name >> waypoint._description
+	  >> waypoint._comment >> waypoint._address >> waypoint._phone
+	  >> waypoint._symbol >> waypoint._images >> waypoint._links
+	  >> waypoint._timestamp >> elevation >> waypoint._style;
+	waypoint._coordinates = Coordinates(lon, lat);
+	waypoint._elevation = elevation;
+
+	return in;
+}
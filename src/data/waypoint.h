@@ -7,6 +7,7 @@
 #include <QVector>
 #include <QPixmap>
 #include <QDebug>
+#include <QDataStream>
 #include "common/hash.h"
 #include "common/coordinates.h"
 #include "link.h"
@@ -79,11 +80,17 @@ private:
 	qreal _elevation;
 	PointStyle _style;
 
+	friend QDataStream &operator<<(QDataStream &out, const Waypoint &waypoint);
+	friend QDataStream &operator>>(QDataStream &in, Waypoint &waypoint);
+
 	static bool _useDEM;
 	static bool _show2ndElevation;
 	static QHash<QString, QPixmap> _symbolIcons;
 };
 
+QDataStream &operator<<(QDataStream &out, const Waypoint &waypoint);
+QDataStream &operator>>(QDataStream &in, Waypoint &waypoint);
+
 inline HASH_T qHash(const Waypoint &key)
 {
 	return ::qHash(key.name());
@@ -0,0 +1,224 @@
+#include <QXmlStreamReader>
+#include <QVarLengthArray>
+#include <QTimeZone>
+#include "xmlvalue.h"
+
+#define MAX_DIGITS 19
+#define MAX_MANTISSA (Q_UINT64_C(1)<<53)
+
+static const double powers[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+	1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline int digit(const QChar *cp)
+{
+	unsigned d = cp->unicode() - '0';
+	return (d < 10) ? (int)d : -1;
+}
+
+static bool digits(const QChar *str, int len, int &val)
+{
+	val = 0;
+
+	for (int i = 0; i < len; i++) {
+		int d = digit(str + i);
+		if (d < 0)
+			return false;
+		val = val * 10 + d;
+	}
+
+	return true;
+}
+
+static bool slowDouble(const QChar *str, int len, double &val)
+{
+	bool ok;
+	val = QString(str, len).toDouble(&ok);
+	return ok;
+}
+
+static bool slowDateTime(const QChar *str, int len, QDateTime &val)
+{
+	val = QDateTime::fromString(QString(str, len), Qt::ISODate);
+	return val.isValid();
+}
+
+bool XMLValue::toDouble(const QChar *str, int len, double &val)
+{
+	const QChar *sp = str, *ep = str + len, *cp;
+	quint64 mantissa = 0;
+	int significant = 0, exp = 0, count = 0, d;
+	bool neg = false;
+
+	while (sp < ep && sp->isSpace())
+		sp++;
+	while (ep > sp && (ep - 1)->isSpace())
+		ep--;
+
+	cp = sp;
+	if (cp < ep && (*cp == '-' || *cp == '+'))
+		neg = (*cp++ == '-');
+
+	for (; cp < ep && (d = digit(cp)) >= 0; cp++, count++) {
+		if (significant == MAX_DIGITS)
+			return slowDouble(str, len, val);
+		mantissa = mantissa * 10 + d;
+		if (mantissa)
+			significant++;
+	}
+	if (cp < ep && *cp == '.') {
+		for (cp++; cp < ep && (d = digit(cp)) >= 0; cp++, count++) {
+			if (significant == MAX_DIGITS)
+				return slowDouble(str, len, val);
+			mantissa = mantissa * 10 + d;
+			if (mantissa)
+				significant++;
+			exp--;
+		}
+	}
+	if (!count)
+		return slowDouble(str, len, val);
+
+	if (cp < ep && (*cp == 'e' || *cp == 'E')) {
+		int e = 0, en = 0;
+		bool eneg = false;
+
+		if (++cp < ep && (*cp == '-' || *cp == '+'))
+			eneg = (*cp++ == '-');
+		for (; cp < ep && (d = digit(cp)) >= 0; cp++, en++) {
+			if (e > 1000)
+				return slowDouble(str, len, val);
+			e = e * 10 + d;
+		}
+		if (!en)
+			return slowDouble(str, len, val);
+		exp += eneg ? -e : e;
+	}
+
+	if (cp != ep || mantissa > MAX_MANTISSA || exp < -22 || exp > 22)
+		return slowDouble(str, len, val);
+
+	/* Both the mantissa and the power of ten are exact doubles, so a single
+	   multiplication/division gives the correctly rounded result. */
+	val = (exp < 0) ? mantissa / powers[-exp] : mantissa * powers[exp];
+	if (neg)
+		val = -val;
+
+	return true;
+}
+
+bool XMLValue::toDateTime(const QChar *str, int len, QDateTime &val)
+{
+	const QChar *sp = str, *ep = str + len;
+	int y, M, d, h, m, s, ms = 0, offset = 0;
+	bool utc = false, local = true;
+
+	/* YYYY-MM-DDTHH:MM:SS */
+	if (len < 19 || !digits(sp, 4, y) || sp[4] != '-' || !digits(sp + 5, 2, M)
+	  || sp[7] != '-' || !digits(sp + 8, 2, d) || sp[10] != 'T'
+	  || !digits(sp + 11, 2, h) || sp[13] != ':' || !digits(sp + 14, 2, m)
+	  || sp[16] != ':' || !digits(sp + 17, 2, s))
+		return slowDateTime(str, len, val);
+	sp += 19;
+
+	/* fraction of second */
+	if (sp < ep && (*sp == '.' || *sp == ',')) {
+		double frac = 0, div = 1;
+		int dd;
+
+		for (sp++; sp < ep && (dd = digit(sp)) >= 0; sp++) {
+			if (div < 1e9) {
+				frac = frac * 10 + dd;
+				div *= 10;
+			}
+		}
+		if (div == 1)
+			return slowDateTime(str, len, val);
+		ms = qMin(qRound((frac / div) * 1000.0), 999);
+	}
+
+	/* Z or +-HH[[:]MM] */
+	if (sp < ep) {
+		if (*sp == 'Z' && sp + 1 == ep) {
+			utc = true;
+			local = false;
+		} else if (*sp == '+' || *sp == '-') {
+			int oh, om = 0;
+			int sign = (*sp == '-') ? -1 : 1;
+			int rem = ep - sp - 1;
+			bool ok = (rem == 2 || rem == 4 || rem == 5)
+			  && digits(sp + 1, 2, oh);
+
+			if (ok && rem == 4)
+				ok = digits(sp + 3, 2, om);
+			else if (ok && rem == 5)
+				ok = (sp[3] == ':' && digits(sp + 4, 2, om));
+			if (!ok)
+				return slowDateTime(str, len, val);
+
+			offset = sign * (oh * 3600 + om * 60);
+			local = false;
+		} else
+			return slowDateTime(str, len, val);
+	}
+
+	QDate date(y, M, d);
+	QTime time(h, m, s, ms);
+	if (!date.isValid() || !time.isValid())
+		return slowDateTime(str, len, val);
+
+	if (local)
+		val = QDateTime(date, time);
+	else if (utc)
+		val = QDateTime(date, time, Qt::UTC);
+	else
+		val = QDateTime(date, time, QTimeZone(offset));
+
+	return val.isValid();
+}
+
+template <class T>
+static bool elementValue(QXmlStreamReader &reader, T &val,
+  bool (*convert)(const QChar *, int, T &), bool *empty)
+{
+	QVarLengthArray<QChar, 64> text;
+	int chunks = 0;
+
+	if (empty)
+		*empty = false;
+
+	/* The element text is collected on the stack (it may be split into
+	   multiple chunks by comments or processing instructions) and converted
+	   without creating any temporary string. */
+	while (true) {
+		switch (reader.readNext()) {
+			case QXmlStreamReader::Characters:
+				text.append(reader.text().data(), reader.text().size());
+				chunks++;
+				break;
+			case QXmlStreamReader::Comment:
+			case QXmlStreamReader::ProcessingInstruction:
+				break;
+			case QXmlStreamReader::EndElement:
+				if (empty)
+					*empty = !chunks;
+				return chunks && convert(text.constData(), text.size(), val);
+			case QXmlStreamReader::Invalid:
+				return false;
+			default:
+				reader.raiseError("Expected character data.");
+				return false;
+		}
+	}
+}
+
+bool XMLValue::number(QXmlStreamReader &reader, double &val, bool *empty)
+{
+	return elementValue<double>(reader, val, toDouble, empty);
+}
+
+bool XMLValue::dateTime(QXmlStreamReader &reader, QDateTime &val)
+{
+	return elementValue<QDateTime>(reader, val, toDateTime, 0);
+}
@@ -0,0 +1,30 @@
+#ifndef XMLVALUE_H
+#define XMLVALUE_H
+
+#include <QDateTime>
+
+class QXmlStreamReader;
+
+/*
+  Locale independent conversions of the XML numbers and ISO 8601 timestamps
+  that work directly on the reader buffer without creating any temporary
+  strings. Only the common value formats are decoded "by hand", everything
+  else is passed to the Qt conversion functions so the results match
+  QString::toDouble() and QDateTime::fromString(..., Qt::ISODate).
+*/
+namespace XMLValue
+{
+	bool toDouble(const QChar *str, int len, double &val);
+	bool toDateTime(const QChar *str, int len, QDateTime &val);
+
+	template <class T>
+	bool toDouble(const T &str, double &val)
+	  {return toDouble(str.data(), str.size(), val);}
+
+	/* Element text conversions. The reader must be positioned on the
+	   element start and is left on its end like with readElementText(). */
+	bool number(QXmlStreamReader &reader, double &val, bool *empty = 0);
+	bool dateTime(QXmlStreamReader &reader, QDateTime &val);
+}
+
+#endif // XMLVALUE_H
@@ -1,7 +1,15 @@
+#include <QFileInfo>
 #include "atlasdata.h"
 
 using namespace ENC;
 
+/* The size of the parsed data is roughly proportional to the S-57 cell
+   (ISO 8211) file size */
+static qint64 cost(const QString &path)
+{
+	return sizeof(MapData) + 2 * QFileInfo(path).size();
+}
+
 bool AtlasData::pointCb(MapEntry *map, void *context)
 {
 	PointCTX *ctx = (PointCTX*)context;
@@ -17,7 +25,7 @@ bool AtlasData::pointCb(MapEntry *map, void *context)
 		data->points(ctx->rect, ctx->points);
 
 		ctx->cacheLock.lock();
-		ctx->cache.insert(map->path, data);
+		ctx->cache.insert(map->path, data, cost(map->path));
 	} else
 		cached->points(ctx->rect, ctx->points);
 
@@ -42,7 +50,7 @@ bool AtlasData::polyCb(MapEntry *map, void *context)
 		data->polys(ctx->rect, ctx->polygons, ctx->lines);
 
 		ctx->cacheLock.lock();
-		ctx->cache.insert(map->path, data);
+		ctx->cache.insert(map->path, data, cost(map->path));
 	} else
 		cached->polys(ctx->rect, ctx->polygons, ctx->lines);
 
@@ -1,14 +1,14 @@
 #ifndef ENC_ATLASDATA_H
 #define ENC_ATLASDATA_H
 
-#include <QCache>
 #include <QMutex>
 #include "common/rtree.h"
+#include "common/memorycache.h"
 #include "mapdata_enc.h"
 
 namespace ENC {
 
-typedef QCache<QString, MapData> MapCache;
+typedef MemoryCache<QString, MapData> MapCache;
 
 class AtlasData : public Data
 {
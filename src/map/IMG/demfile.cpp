@@ -145,6 +145,22 @@ int DEMFile::level(const Zoom &zoom) const
 	return _levels.size() - 1;
 }
 
+int DEMFile::level(double resolution) const
+{
+	int best = -1, finest = 0;
+
+	for (int i = 0; i < _levels.size(); i++) {
+		double xr = _levels.at(i).xr;
+
+		if (xr < _levels.at(finest).xr)
+			finest = i;
+		if (xr <= resolution && (best < 0 || xr > _levels.at(best).xr))
+			best = i;
+	}
+
+	return (best < 0) ? finest : best;
+}
+
 MapData::Elevation *DEMFile::elevations(Handle &hdl, int level,
   const DEMTile *tile) const
 {
@@ -167,17 +183,16 @@ MapData::Elevation *DEMFile::elevations(Handle &hdl, int level,
 	Matrix<qint16> m(tile->h(), tile->w());
 	JLS jls(tile->diff(), l.factor);
 	if (jls.decode(this, hdl, m)) {
-		for (int i = 0; i < m.size(); i++) {
-			if (m.at(i) >= lim)
-				m.at(i) = -32768;
-			else {
-				m.at(i) += tile->base();
-				if (m.at(i) < l.minHeight)
-					m.at(i) = l.minHeight;
-				if (m.at(i) > l.maxHeight)
-					m.at(i) = l.maxHeight;
-				m.at(i) = meters(m.at(i));
-			}
+		qint16 *dp = m.row(0);
+		qint16 *ep = dp + m.size();
+		qint16 base = tile->base();
+
+		for (; dp < ep; dp++) {
+			if (*dp >= lim)
+				*dp = -32768;
+			else
+				*dp = meters(qBound(l.minHeight, (qint16)(*dp + base),
+				  l.maxHeight));
 		}
 
 		ele->m = m;
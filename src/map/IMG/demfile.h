@@ -20,6 +20,9 @@ public:
 	  const DEMTile *tile) const;
 
 	int level(const Zoom &zoom) const;
+	/* The coarsest level with samples not larger than the resolution (in
+	   degrees) */
+	int level(double resolution) const;
 	QList<const DEMTile *> tiles(const RectC &rect, int level) const;
 
 private:
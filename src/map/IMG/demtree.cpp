@@ -1,8 +1,11 @@
+#include <QtConcurrent>
 #include "demtree.h"
 
 using namespace IMG;
 
 #define DELTA 1e-9 /* ensure col+1/row+1 is in the next tile */
+#define RECT_DELTA 1e-3
+#define CHUNK_SIZE 0.05 /* max chunk width/height in degrees */
 
 static double interpolate(double dx, double dy, double p0, double p1, double p2,
   double p3)
@@ -121,3 +124,59 @@ MatrixD DEMTree::elevation(const MatrixC &m) const
 
 	return ret;
 }
+
+bool DEMTree::Chunk::add(int i)
+{
+	const Coordinates &c = _c[i];
+
+	if (_points.isEmpty())
+		_rect = RectC(c, c);
+	else {
+		RectC r(_rect.united(c));
+		if (r.width() > CHUNK_SIZE || r.height() > CHUNK_SIZE)
+			return false;
+		_rect = r;
+	}
+
+	_points.append(i);
+
+	return true;
+}
+
+void DEMTree::Chunk::process()
+{
+	QList<MapData::Elevation> tiles;
+
+	_data->elevations(0, _rect.adjusted(0, 0, RECT_DELTA, -RECT_DELTA),
+	  _data->zooms().max(), &tiles);
+	DEMTree tree(tiles);
+
+	for (int i = 0; i < _points.size(); i++) {
+		int idx = _points.at(i);
+		_ele[idx] = tree.elevation(_c[idx]);
+	}
+}
+
+void DEMTree::elevations(MapData *data, const QVector<Coordinates> &c,
+  QVector<double> &ele)
+{
+	QList<Chunk> chunks;
+	double *ep = ele.data();
+
+	/* Split the (unresolved) points into chunks of nearby points sharing
+	   a single DEM tree. For paths, consecutive points are nearby points. */
+	chunks.append(Chunk(data, c.constData(), ep));
+	for (int i = 0; i < c.size(); i++) {
+		if (!std::isnan(ep[i]) || !data->bounds().contains(c.at(i)))
+			continue;
+		if (!chunks.last().add(i)) {
+			chunks.append(Chunk(data, c.constData(), ep));
+			chunks.last().add(i);
+		}
+	}
+	if (chunks.last().isEmpty())
+		chunks.removeLast();
+
+	QFuture<void> future = QtConcurrent::map(chunks, &Chunk::process);
+	future.waitForFinished();
+}
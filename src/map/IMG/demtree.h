@@ -14,9 +14,29 @@ public:
 	double elevation(const Coordinates &c) const;
 	MatrixD elevation(const MatrixC &m) const;
 
+	static void elevations(MapData *data, const QVector<Coordinates> &c,
+	  QVector<double> &ele);
+
 private:
 	typedef RTree<const MapData::Elevation*, double, 2> Tree;
 
+	class Chunk {
+	public:
+		Chunk(MapData *data, const Coordinates *c, double *ele)
+		  : _data(data), _c(c), _ele(ele) {}
+
+		bool add(int i);
+		bool isEmpty() const {return _points.isEmpty();}
+		void process();
+
+	private:
+		MapData *_data;
+		const Coordinates *_c;
+		double *_ele;
+		QVector<int> _points;
+		RectC _rect;
+	};
+
 	struct ElevationCTX {
 		ElevationCTX(const Tree &tree, const Coordinates &c, double &ele)
 		  : tree(tree), c(c), ele(ele) {}
@@ -1,5 +1,6 @@
 #include <QXmlStreamReader>
 #include <QDir>
+#include <QtConcurrent>
 #include "vectortile_img.h"
 #include "gmapdata.h"
 
@@ -78,8 +79,9 @@ bool GMAPData::readXML(const QString &path, QString &dataDir, QString &typFile)
 	return true;
 }
 
-bool GMAPData::loadTile(const QDir &dir)
+VectorTile *GMAPData::loadTile(const QString &path)
 {
+	QDir dir(path);
 	VectorTile *tile = new VectorTile();
 
 	QFileInfoList ml = dir.entryInfoList(QDir::Files);
@@ -91,7 +93,7 @@ bool GMAPData::loadTile(const QDir &dir)
 				qWarning("%s: Invalid map tile structure",
 				  qUtf8Printable(dir.path()));
 				delete tile;
-				return false;
+				return 0;
 			}
 		}
 	}
@@ -99,20 +101,10 @@ bool GMAPData::loadTile(const QDir &dir)
 	if (!tile->init()) {
 		qWarning("%s: Invalid map tile", qUtf8Printable(dir.path()));
 		delete tile;
-		return false;
+		return 0;
 	}
 
-	double min[2], max[2];
-	min[0] = tile->bounds().left();
-	min[1] = tile->bounds().bottom();
-	max[0] = tile->bounds().right();
-	max[1] = tile->bounds().top();
-	_tileTree.Insert(min, max, tile);
-
-	_bounds |= tile->bounds();
-	_hasDEM |= tile->hasDem();
-
-	return true;
+	return tile;
 }
 
 GMAPData::GMAPData(const QString &fileName, PolyCache &polyCache,
@@ -131,11 +123,34 @@ GMAPData::GMAPData(const QString &fileName, PolyCache &polyCache,
 	}
 	QDir dataDir(baseDir.filePath(dataDirPath));
 	QFileInfoList ml = dataDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+	QStringList dirs;
 
 	for (int i = 0; i < ml.size(); i++) {
 		const QFileInfo &fi = ml.at(i);
 		if (fi.isDir())
-			loadTile(QDir(fi.absoluteFilePath()));
+			dirs.append(fi.absoluteFilePath());
+	}
+
+	/* The tiles headers are independent and GMAPs may have thousands of
+	   tiles, so they are read in parallel */
+	QList<VectorTile*> tiles(QtConcurrent::blockingMapped<QList<VectorTile*> >(
+	  dirs, &GMAPData::loadTile));
+
+	for (int i = 0; i < tiles.size(); i++) {
+		VectorTile *tile = tiles.at(i);
+		double min[2], max[2];
+
+		if (!tile)
+			continue;
+
+		min[0] = tile->bounds().left();
+		min[1] = tile->bounds().bottom();
+		max[0] = tile->bounds().right();
+		max[1] = tile->bounds().top();
+		_tileTree.Insert(min, max, tile);
+
+		_bounds |= tile->bounds();
+		_hasDEM |= tile->hasDem();
 	}
 
 	if (baseDir.exists(typFilePath))
@@ -146,5 +161,5 @@ GMAPData::GMAPData(const QString &fileName, PolyCache &polyCache,
 	else
 		_valid = true;
 
-	computeZooms();
+	_zoomLevels = computeZooms();
 }
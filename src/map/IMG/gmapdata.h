@@ -4,7 +4,6 @@
 #include "mapdata_img.h"
 
 class QXmlStreamReader;
-class QDir;
 
 namespace IMG {
 
@@ -20,7 +19,7 @@ private:
 	void mapProduct(QXmlStreamReader &reader, QString &dataDir,
 	  QString &typFile);
 	void subProduct(QXmlStreamReader &reader, QString &dataDir);
-	bool loadTile(const QDir &dir);
+	static VectorTile *loadTile(const QString &path);
 };
 
 }
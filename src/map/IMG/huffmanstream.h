@@ -20,7 +20,7 @@ public:
 
 protected:
 	quint32 _symbolDataSize;
-	quint32 _symbolData;
+	quint64 _symbolData;
 
 private:
 	bool fetchData();
@@ -33,12 +33,13 @@ template <class BitStream>
 bool HuffmanStream<BitStream>::fetchData()
 {
 	quint32 next;
-	quint32 nextSize = qMin((quint64)(32 - _symbolDataSize), _bs.bitsAvailable());
+	quint32 nextSize = qMin((quint64)qMin(64U - _symbolDataSize, 32U),
+	  _bs.bitsAvailable());
 
 	if (!_bs.read(nextSize, next))
 		return false;
 
-	_symbolData = (nextSize < 32) ? (_symbolData << nextSize) | next : next;
+	_symbolData = (_symbolData << nextSize) | next;
 	_symbolDataSize += nextSize;
 
 	return true;
@@ -51,7 +52,7 @@ bool HuffmanStream<BitStream>::read(quint32 bits, quint32 &val)
 		if (!fetchData() || _symbolDataSize < bits)
 			return false;
 
-	val = (_symbolData << (32 - _symbolDataSize)) >> (32 - bits);
+	val = (quint32)((_symbolData << (64 - _symbolDataSize)) >> (64 - bits));
 	_symbolDataSize -= bits;
 
 	return true;
@@ -66,7 +67,8 @@ bool HuffmanStream<BitStream>::readSymbol(quint32 &symbol)
 		if (!fetchData() || !_symbolDataSize)
 			return false;
 
-	symbol = _table.symbol(_symbolData << (32 - _symbolDataSize), size);
+	symbol = _table.symbol((quint32)((_symbolData << (64 - _symbolDataSize))
+	  >> 32), size);
 	if (size > _symbolDataSize)
 		return false;
 
@@ -4,6 +4,8 @@
 using namespace Garmin;
 using namespace IMG;
 
+#define LOOKUP_BITS 9
+
 static inline quint32 readVUint32(const quint8 *buffer, quint32 bytes)
 {
 	quint32 val = 0;
@@ -33,10 +35,34 @@ bool HuffmanTable::load(const RGNFile *rgn, SubFile::Handle &rgnHdl)
 	_aclTable = _bsrchTable + _bsrchEntryBytes * _bsrchEntries;
 	_huffmanTable = _aclTable + (_aclEntryBytes << _aclBits);
 
-	return (_symBits > 0 && _symBits <= 32 && _symbolBits <= 32);
+	if (!(_symBits > 0 && _symBits <= 32 && _symbolBits <= 32))
+		return false;
+
+	buildLookup();
+
+	return true;
+}
+
+void HuffmanTable::buildLookup()
+{
+	quint8 size;
+
+	/* The codes are prefix codes, so all the data starting with a code not
+	   longer than the lookup bits decode to the same symbol as the
+	   zero-padded lookup index. */
+	_lookupBits = qMin((quint8)LOOKUP_BITS, _symBits);
+	_lookup.resize(1U<<_lookupBits);
+
+	for (quint32 i = 0; i < (quint32)_lookup.size(); i++) {
+		quint32 sym = decode(i << (32 - _lookupBits), size);
+		if (size && size <= _lookupBits) {
+			_lookup[i].symbol = sym;
+			_lookup[i].size = size;
+		}
+	}
 }
 
-quint32 HuffmanTable::symbol(quint32 data, quint8 &size) const
+quint32 HuffmanTable::decode(quint32 data, quint8 &size) const
 {
 	quint32 lo, hi;
 	const quint8 *tp;
@@ -51,7 +77,7 @@ quint32 HuffmanTable::symbol(quint32 data, quint8 &size) const
 
 		if (*tp & 1) {
 			size = *tp >> 1;
-			return readVUint32(tp + 1, _symbolBytes);;
+			return readVUint32(tp + 1, _symbolBytes);
 		}
 
 		lo = *tp >> 1;
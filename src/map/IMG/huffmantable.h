@@ -1,6 +1,7 @@
 #ifndef IMG_HUFFMANTABLE_H
 #define IMG_HUFFMANTABLE_H
 
+#include <QVector>
 #include "huffmanbuffer.h"
 
 namespace IMG {
@@ -13,14 +14,37 @@ public:
 
 	bool load(const RGNFile *rgn, SubFile::Handle &rgnHdl);
 
-	quint32 symbol(quint32 data, quint8 &size) const;
+	quint32 symbol(quint32 data, quint8 &size) const
+	{
+		const Entry &e = _lookup.constData()[data >> (32 - _lookupBits)];
+		if (e.size) {
+			size = e.size;
+			return e.symbol;
+		} else
+			return decode(data, size);
+	}
 	quint8 id() const {return _buffer.id();}
 
 	quint8 symBits() const {return _symBits;}
 	quint8 symbolBits() const {return _symbolBits;}
 
 private:
+	/* Lookup table of the symbols decoded from the first _lookupBits bits
+	   of the data. Entries with zero size are symbols with longer codes
+	   that have to be decoded using the Garmin tables. */
+	struct Entry {
+		Entry() : symbol(0), size(0) {}
+
+		quint32 symbol;
+		quint8 size;
+	};
+
+	quint32 decode(quint32 data, quint8 &size) const;
+	void buildLookup();
+
 	HuffmanBuffer _buffer;
+	QVector<Entry> _lookup;
+	quint8 _lookupBits;
 	const quint8 *_aclTable, *_bsrchTable, *_huffmanTable;
 	quint8 _aclBits, _aclEntryBytes, _symBits, _symBytes, _indexBytes,
 	  _bsrchEntryBytes, _bsrchEntries, _symbolBits, _symbolBytes;
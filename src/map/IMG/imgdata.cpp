@@ -139,7 +139,8 @@ bool IMGData::readFAT(QFile *file, TileMap &tileMap)
 	return true;
 }
 
-bool IMGData::createTileTree(QFile *file, const TileMap &tileMap)
+bool IMGData::createTileTree(QFile *file, const TileMap &tileMap,
+  RectC &bounds, bool &hasDEM)
 {
 	for (TileMap::const_iterator it = tileMap.constBegin();
 	  it != tileMap.constEnd(); ++it) {
@@ -159,8 +160,8 @@ bool IMGData::createTileTree(QFile *file, const TileMap &tileMap)
 		max[1] = tile->bounds().top();
 		_tileTree.Insert(min, max, tile);
 
-		_bounds |= tile->bounds();
-		_hasDEM |= tile->hasDem();
+		bounds |= tile->bounds();
+		hasDEM |= tile->hasDem();
 	}
 
 	return (_tileTree.Count() > 0);
@@ -171,29 +172,59 @@ IMGData::IMGData(const QString &fileName, PolyCache &polyCache,
   QMutex &demLock)
   : MapData(fileName, polyCache, pointCache, demCache, lock, demLock)
 {
-	QFile file(fileName);
+	_valid = load();
+}
+
+IMGData::IMGData(const QString &fileName, const RectC &bounds,
+  const Range &zooms, bool hasDEM, PolyCache &polyCache,
+  PointCache &pointCache, ElevationCache &demCache, QMutex &lock,
+  QMutex &demLock)
+  : MapData(fileName, polyCache, pointCache, demCache, lock, demLock)
+{
+	_bounds = bounds;
+	_zoomLevels = zooms;
+	_hasDEM = hasDEM;
+
+	_loaded.storeRelease(0);
+	_valid = true;
+}
+
+bool IMGData::load()
+{
+	QFile file(_fileName);
 	TileMap tileMap;
+	RectC bounds;
+	bool hasDEM = false;
 
 	if (!file.open(QFile::ReadOnly)) {
 		_errorString = file.errorString();
-		return;
+		return false;
 	}
 
 	if (!readIMGHeader(&file))
-		return;
+		return false;
 	if (!readFAT(&file, tileMap)) {
 		_errorString = "Error reading FAT data";
 		qDeleteAll(tileMap);
-		return;
+		return false;
 	}
-	if (!createTileTree(&file, tileMap)) {
+	if (!createTileTree(&file, tileMap, bounds, hasDEM)) {
 		_errorString = "No usable map tile found";
-		return;
+		return false;
 	}
 
-	computeZooms();
+	Range zooms(computeZooms());
 
-	_valid = true;
+	/* The render threads read the bounds and zooms of the maps loaded on
+	   the first data access without any lock, so they keep the tile index
+	   values */
+	if (_loaded.loadAcquire()) {
+		_bounds = bounds;
+		_zoomLevels = zooms;
+		_hasDEM = hasDEM;
+	}
+
+	return true;
 }
 
 qint64 IMGData::read(QFile *file, char *data, qint64 maxSize) const
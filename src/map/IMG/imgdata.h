@@ -13,10 +13,18 @@ public:
 	IMGData(const QString &fileName, PolyCache &polyCache,
 	  PointCache &pointCache, ElevationCache &demCache, QMutex &lock,
 	  QMutex &demLock);
+	/* Creates an unloaded map with the bounds, zooms and DEM info known from
+	   a tile index, the IMG file is parsed on the first data access. */
+	IMGData(const QString &fileName, const RectC &bounds, const Range &zooms,
+	  bool hasDEM, PolyCache &polyCache, PointCache &pointCache,
+	  ElevationCache &demCache, QMutex &lock, QMutex &demLock);
 
 	unsigned blockBits() const {return _blockBits;}
 	bool readBlock(QFile *file, int blockNum, char *data) const;
 
+protected:
+	bool load();
+
 private:
 	typedef QMap<QByteArray, VectorTile*> TileMap;
 
@@ -25,7 +33,8 @@ private:
 	bool readSubFileBlocks(QFile *file, quint64 offset, SubFile *subFile);
 	bool readFAT(QFile *file, TileMap &tileMap);
 	bool readIMGHeader(QFile *file);
-	bool createTileTree(QFile *file, const TileMap &tileMap);
+	bool createTileTree(QFile *file, const TileMap &tileMap, RectC &bounds,
+	  bool &hasDEM);
 
 	quint8 _key;
 	unsigned _blockBits;
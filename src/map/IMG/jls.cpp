@@ -1,5 +1,6 @@
 #include <cmath>
 #include <QtMath>
+#include <QtAlgorithms>
 #include "jls.h"
 
 using namespace IMG;
@@ -20,6 +21,19 @@ static const quint8 J[] = {
 	4,  4,  5,  5,  6,  6,  7,  7,  8,  9, 10, 11, 12, 13, 14, 15
 };
 
+static inline int bitLength(quint32 x)
+{
+	return 32 - qCountLeadingZeroBits(x);
+}
+
+/* The smallest k for which n << k >= a. The estimate from the bit lengths is
+   at most one less than k, so no loop over k is needed. */
+static inline quint8 golombK(quint32 a, quint32 n)
+{
+	int k = qMax(0, bitLength(a) - bitLength(n));
+	return k + ((n << k) < a);
+}
+
 JLS::JLS(quint16 maxval, quint16 near)
 {
 	_maxval = maxval;
@@ -140,26 +154,16 @@ bool JLS::readLine(BitStream &bs, Context &ctx) const
 
 	do {
 		if (abs(Rb - Ra) > _near) {
-			int Px = Ra + Rb - Rc;
-			if (Px < 0)
-				Px = 0;
-			else if (Px > _maxval)
-				Px = _maxval;
-
-			for (k = 0; ctx.n[1] << k < ctx.a[1]; k++)
-				;
+			int Px = qBound(0, Ra + Rb - Rc, (int)_maxval);
 
+			k = golombK(ctx.a[1], ctx.n[1]);
 			if (!decodeError(bs, _limit, k, MErrval))
 				return false;
 
-			int mes, meh;
-			if (MErrval & 1) {
-				meh = (MErrval + 1) >> 1;
-				mes = -meh;
-			} else {
-				meh = MErrval >> 1;
-				mes = meh;
-			}
+			/* Odd mapped errors are negative */
+			int sign = -(int)(MErrval & 1);
+			int meh = (MErrval + 1) >> 1;
+			int mes = (meh ^ sign) - sign;
 			if ((_near == 0) && (k == 0) && (ctx.b[1] * 2 <= -ctx.n[1])) {
 				meh = mes + 1;
 				mes = -mes - 1;
@@ -176,10 +180,7 @@ bool JLS::readLine(BitStream &bs, Context &ctx) const
 			else if (Rx > _maxval + _near)
 				Rx -= (_near * 2 + 1) * _range;
 
-			if (Rx < 0)
-				Rx = 0;
-			if (Rx > _maxval)
-				Rx = _maxval;
+			Rx = qBound(0, Rx, (int)_maxval);
 
 			ctx.a[1] = ctx.a[1] + meh;
 			ctx.b[1] = ctx.b[1] + mes;
@@ -211,12 +212,13 @@ bool JLS::readLine(BitStream &bs, Context &ctx) const
 				return false;
 
 			if (samples != 0) {
-				for (int i = 0; i < samples; i++) {
-					if (col > ctx.w)
-						return false;
-					ctx.current[col] = Ra;
-					col++;
-				}
+				if (col + samples - 1 > ctx.w)
+					return false;
+				quint16 *cp = ctx.current + col;
+				quint16 *ep = cp + samples;
+				while (cp < ep)
+					*cp++ = Ra;
+				col += samples;
 
 				if (col > ctx.w)
 					break;
@@ -234,9 +236,7 @@ bool JLS::readLine(BitStream &bs, Context &ctx) const
 				TEMP += ctx.n[rctx + 2] >> 1;
 			ictx = rctx | 2;
 
-			for (k = 0; ctx.n[rctx + 2] << k < TEMP; k++)
-				;
-
+			k = golombK(TEMP, ctx.n[rctx + 2]);
 			if (!decodeError(bs, _limit - ctx.lrk, k, MErrval))
 				return false;
 
@@ -271,10 +271,7 @@ bool JLS::readLine(BitStream &bs, Context &ctx) const
 			else if (Rx > _maxval + _near)
 				Rx -= (_near * 2 + 1) * _range;
 
-			if (Rx < 0)
-				Rx = 0;
-			if (Rx > _maxval)
-				Rx = _maxval;
+			Rx = qBound(0, Rx, (int)_maxval);
 
 			ctx.a[ictx] = ctx.a[ictx] + (evh - rctx);
 			if (ctx.n[ictx] == 0x40) {
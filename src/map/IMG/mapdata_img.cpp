@@ -6,9 +6,6 @@
 
 using namespace IMG;
 
-#define SUBDIV_CACHE_SIZE 2048 // ~32MB for both caches together
-#define DEM_CACHE_SIZE    1024 // ~32MB
-
 bool MapData::polyCb(VectorTile *tile, void *context)
 {
 	PolyCTX *ctx = (PolyCTX*)context;
@@ -28,21 +25,18 @@ bool MapData::pointCb(VectorTile *tile, void *context)
 bool MapData::elevationCb(VectorTile *tile, void *context)
 {
 	ElevationCTX *ctx = (ElevationCTX*)context;
-	tile->elevations(ctx->file, ctx->rect, ctx->zoom, ctx->elevations,
-	  ctx->cache, ctx->lock);
+	tile->elevations(ctx->file, ctx->rect, ctx->zoom, ctx->resolution,
+	  ctx->elevations, ctx->cache, ctx->lock);
 	return true;
 }
 
 MapData::MapData(const QString &fileName, PolyCache &polyCache,
   PointCache &pointCache, ElevationCache &demCache, QMutex &lock,
   QMutex &demLock)
-  : _fileName(fileName), _typ(0), _hasDEM(false), _valid(false),
+  : _fileName(fileName), _typ(0), _hasDEM(false), _valid(false), _loaded(1),
   _polyCache(polyCache), _pointCache(pointCache), _demCache(demCache),
   _lock(lock), _demLock(demLock)
 {
-	_polyCache.setMaxCost(SUBDIV_CACHE_SIZE);
-	_pointCache.setMaxCost(SUBDIV_CACHE_SIZE);
-	_demCache.setMaxCost(DEM_CACHE_SIZE);
 }
 
 MapData::~MapData()
@@ -57,6 +51,9 @@ MapData::~MapData()
 void MapData::polys(QFile *file, const RectC &rect, int bits,
   QList<Poly> *polygons, QList<Poly> *lines)
 {
+	if (!loadData())
+		return;
+
 	PolyCTX ctx(file, rect, zoom(bits), polygons, lines, &_polyCache, &_lock);
 	double min[2], max[2];
 
@@ -71,6 +68,9 @@ void MapData::polys(QFile *file, const RectC &rect, int bits,
 void MapData::points(QFile *file, const RectC &rect, int bits,
   QList<Point> *points)
 {
+	if (!loadData())
+		return;
+
 	PointCTX ctx(file, rect, zoom(bits), points, &_pointCache, &_lock);
 	double min[2], max[2];
 
@@ -83,9 +83,13 @@ void MapData::points(QFile *file, const RectC &rect, int bits,
 }
 
 void MapData::elevations(QFile *file, const RectC &rect, int bits,
-  QList<Elevation> *elevations)
+  QList<Elevation> *elevations, double resolution)
 {
-	ElevationCTX ctx(file, rect, zoom(bits), elevations, &_demCache, &_demLock);
+	if (!loadData())
+		return;
+
+	ElevationCTX ctx(file, rect, zoom(bits), resolution, elevations,
+	  &_demCache, &_demLock);
 	double min[2], max[2];
 
 	min[0] = rect.left();
@@ -96,18 +100,39 @@ void MapData::elevations(QFile *file, const RectC &rect, int bits,
 	_tileTree.Search(min, max, elevationCb, &ctx);
 }
 
+bool MapData::loadData()
+{
+	if (!_loaded.loadAcquire()) {
+		_loadLock.lock();
+		if (!_loaded.loadAcquire()) {
+			if (!load())
+				qWarning("%s: %s", qUtf8Printable(_fileName),
+				  qUtf8Printable(_errorString));
+			_loaded.storeRelease(1);
+		}
+		_loadLock.unlock();
+	}
+
+	return !_zooms.isEmpty();
+}
+
 void MapData::clear()
 {
 	TileTree::Iterator it;
 	for (_tileTree.GetFirst(it); !_tileTree.IsNull(it); _tileTree.GetNext(it))
 		_tileTree.GetAt(it)->clear();
 
+	_lock.lock();
 	_polyCache.clear();
 	_pointCache.clear();
+	_lock.unlock();
+
+	_demLock.lock();
 	_demCache.clear();
+	_demLock.unlock();
 }
 
-void MapData::computeZooms()
+Range MapData::computeZooms()
 {
 	TileTree::Iterator it;
 	QSet<Zoom> zooms;
@@ -119,7 +144,7 @@ void MapData::computeZooms()
 	}
 
 	if (zooms.isEmpty())
-		return;
+		return Range();
 
 	_zooms = zooms.values();
 	std::sort(_zooms.begin(), _zooms.end());
@@ -131,7 +156,7 @@ void MapData::computeZooms()
 			break;
 		}
 	}
-	_zoomLevels = Range(baseMap ? _zooms.first().bits()
+	return Range(baseMap ? _zooms.first().bits()
 	  : qMax(0, _zooms.first().bits() - 2), 28);
 }
 
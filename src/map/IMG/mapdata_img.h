@@ -3,13 +3,15 @@
 
 #include <QList>
 #include <QPointF>
-#include <QCache>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QFile>
 #include <QDebug>
 #include "common/rectc.h"
 #include "common/rtree.h"
 #include "common/range.h"
+#include "common/memorycache.h"
+#include "common/compactpath.h"
 #include "map/matrix.h"
 #include "label.h"
 #include "raster.h"
@@ -76,14 +78,19 @@ public:
 		double yr;
 	};
 
+	/* Cached subdivision polygons/lines. The points are stored separately
+	   in the compact form (the Poly::points vectors are empty) and expanded
+	   only when copied to the rendering lists. */
 	struct Polys {
 		QList<Poly> polygons;
 		QList<Poly> lines;
+		QVector<CompactPath> polygonPoints;
+		QVector<CompactPath> linePoints;
 	};
 
-	typedef QCache<const SubDiv*, Polys> PolyCache;
-	typedef QCache<const SubDiv*, QList<Point> > PointCache;
-	typedef QCache<const DEMTile*, Elevation> ElevationCache;
+	typedef MemoryCache<const SubDiv*, Polys> PolyCache;
+	typedef MemoryCache<const SubDiv*, QList<Point> > PointCache;
+	typedef MemoryCache<const DEMTile*, Elevation> ElevationCache;
 
 	MapData(const QString &fileName, PolyCache &polyCache,
 	  PointCache &pointCache, ElevationCache &demCache, QMutex &lock,
@@ -97,8 +104,10 @@ public:
 	void polys(QFile *file, const RectC &rect, int bits, QList<Poly> *polygons,
 	  QList<Poly> *lines);
 	void points(QFile *file, const RectC &rect, int bits, QList<Point> *points);
+	/* The resolution (in degrees) selects the DEM level, with zero resolution
+	   the level is derived from the zoom bits. */
 	void elevations(QFile *file, const RectC &rect, int bits,
-	  QList<Elevation> *elevations);
+	  QList<Elevation> *elevations, double resolution = 0);
 	void clear();
 
 	bool hasDEM() const {return _hasDEM;}
@@ -111,7 +120,10 @@ public:
 protected:
 	typedef RTree<VectorTile*, double, 2> TileTree;
 
-	void computeZooms();
+	/* Loads the map tiles of maps created "unloaded" from a tile index (see
+	   IMGData). Called at most once, on the first data access. */
+	virtual bool load() {return true;}
+	Range computeZooms();
 
 	QString _fileName;
 	QString _name;
@@ -125,6 +137,8 @@ protected:
 	bool _valid;
 	QString _errorString;
 
+	QAtomicInt _loaded;
+
 private:
 	struct PolyCTX
 	{
@@ -161,18 +175,21 @@ private:
 	struct ElevationCTX
 	{
 		ElevationCTX(QFile *file, const RectC &rect, const Zoom &zoom,
-		  QList<Elevation> *elevations, ElevationCache *cache, QMutex *lock)
-		  : file(file), rect(rect), zoom(zoom), elevations(elevations),
-		  cache(cache), lock(lock) {}
+		  double resolution, QList<Elevation> *elevations,
+		  ElevationCache *cache, QMutex *lock)
+		  : file(file), rect(rect), zoom(zoom), resolution(resolution),
+		  elevations(elevations), cache(cache), lock(lock) {}
 
 		QFile *file;
 		const RectC &rect;
 		const Zoom &zoom;
+		double resolution;
 		QList<Elevation> *elevations;
 		ElevationCache *cache;
 		QMutex *lock;
 	};
 
+	bool loadData();
 	const Zoom &zoom(int bits) const;
 
 	static bool polyCb(VectorTile *tile, void *context);
@@ -183,6 +200,7 @@ private:
 	PointCache &_pointCache;
 	ElevationCache &_demCache;
 	QMutex &_lock, &_demLock;
+	QMutex _loadLock;
 
 	friend class VectorTile;
 };
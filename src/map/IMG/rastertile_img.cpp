@@ -19,6 +19,7 @@ using namespace IMG;
 #define ICON_PADDING 2
 #define RANGE_FACTOR 4
 #define MAJOR_RANGE  10
+#define SHIELD_EXTENT 96
 #define ROAD  0
 #define WATER 1
 
@@ -448,7 +449,7 @@ void RasterTile::processShields(const QList<MapData::Poly> &lines,
 		  it != shields.constEnd(); ++it) {
 			const QPolygonF &p = it.value();
 			QRectF rect(p.boundingRect() & _rect);
-			if (AREA(rect) < AREA(QRect(0, 0, _rect.width()/4, _rect.width()/4)))
+			if (AREA(rect) < AREA(QRect(0, 0, SHIELD_EXTENT, SHIELD_EXTENT)))
 				continue;
 
 			QMap<qreal, int> map;
@@ -608,6 +609,7 @@ void RasterTile::fetchData(QList<MapData::Poly> &polygons,
 
 	RectC demRectC;
 	MatrixC demLL;
+	double demRes = 0;
 	QList<MapData::Elevation> tiles;
 	if (_hillShading && _zoom >= 17 && _zoom <= 24 && hasDEM()) {
 		int extend = HillShading::blur() + 1;
@@ -630,6 +632,9 @@ void RasterTile::fetchData(QList<MapData::Poly> &polygons,
 		double factor = 6 - (_zoom - 24) * 1.7;
 		demRectC = rect.adjusted(0, 0, rect.width() / factor, -rect.height()
 		  / factor);
+		/* Use the coarsest DEM level that still has at least one sample
+		   per pixel */
+		demRes = qMin(rect.width() / demLL.w(), rect.height() / demLL.h());
 	}
 
 	for (int i = 0; i < _data.size(); i++) {
@@ -651,7 +656,7 @@ void RasterTile::fetchData(QList<MapData::Poly> &polygons,
 			data->points(file, pointRectC, _zoom, &points);
 
 		if (!demRectC.isNull())
-			data->elevations(file, demRectC, _zoom, &tiles);
+			data->elevations(file, demRectC, _zoom, &tiles, demRes);
 
 		delete file;
 	}
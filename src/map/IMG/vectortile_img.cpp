@@ -1,7 +1,50 @@
+#include "common/garmin.h"
 #include "vectortile_img.h"
 
+using namespace Garmin;
 using namespace IMG;
 
+/* Garmin 32 bit units per degree, the precision of all the IMG coordinates */
+#define GARMIN_SCALE ((double)(1U<<31) / 180.0)
+
+static qint64 cost(const QList<MapData::Poly> &list,
+  const QVector<CompactPath> &points)
+{
+	qint64 size = list.size() * sizeof(MapData::Poly)
+	  + points.size() * sizeof(CompactPath);
+
+	for (int i = 0; i < list.size(); i++)
+		size += points.at(i).cost()
+		  + list.at(i).label.text().size() * sizeof(QChar);
+
+	return size;
+}
+
+static qint64 cost(const MapData::Polys *polys)
+{
+	return sizeof(MapData::Polys) + cost(polys->polygons, polys->polygonPoints)
+	  + cost(polys->lines, polys->linePoints);
+}
+
+static qint64 cost(const QList<MapData::Point> *list)
+{
+	qint64 size = sizeof(QList<MapData::Point>)
+	  + list->size() * sizeof(MapData::Point);
+
+	for (int i = 0; i < list->size(); i++) {
+		const MapData::Point &point = list->at(i);
+		size += point.label.text().size() * sizeof(QChar)
+		  + point.lights.size() * sizeof(Light);
+	}
+
+	return size;
+}
+
+static qint64 cost(const MapData::Elevation *el)
+{
+	return sizeof(MapData::Elevation) + el->m.size() * sizeof(qint16);
+}
+
 static void copyPolys(const RectC &rect, const QList<MapData::Poly> *src,
   QList<MapData::Poly> *dst)
 {
@@ -10,6 +53,30 @@ static void copyPolys(const RectC &rect, const QList<MapData::Poly> *src,
 			dst->append(src->at(i));
 }
 
+static void copyPolys(const RectC &rect, const QPointF &origin,
+  const QList<MapData::Poly> *src, const QVector<CompactPath> *points,
+  QList<MapData::Poly> *dst)
+{
+	for (int i = 0; i < src->size(); i++) {
+		if (rect.intersects(src->at(i).boundingRect)) {
+			dst->append(src->at(i));
+			dst->last().points = points->at(i).points(origin, GARMIN_SCALE);
+		}
+	}
+}
+
+static void compact(const QPointF &origin, QList<MapData::Poly> *polys,
+  QVector<CompactPath> *points)
+{
+	points->reserve(polys->size());
+
+	for (int i = 0; i < polys->size(); i++) {
+		MapData::Poly &poly = (*polys)[i];
+		points->append(CompactPath(poly.points, origin, GARMIN_SCALE));
+		poly.points = QVector<QPointF>();
+	}
+}
+
 static void copyPoints(const RectC &rect, const QList<MapData::Point> *src,
   QList<MapData::Point> *dst)
 {
@@ -196,12 +263,19 @@ void VectorTile::polys(QFile *file, const RectC &rect, const Zoom &zoom,
 			if (lines)
 				copyPolys(rect, &polys->lines, lines);
 
+			QPointF origin(toWGS24(subdiv->lon()), toWGS24(subdiv->lat()));
+			compact(origin, &polys->polygons, &polys->polygonPoints);
+			compact(origin, &polys->lines, &polys->linePoints);
+
 			cacheLock->lock();
-			cache->insert(subdiv, polys);
+			cache->insert(subdiv, polys, cost(polys));
 		} else {
-			copyPolys(rect, &polys->polygons, polygons);
+			QPointF origin(toWGS24(subdiv->lon()), toWGS24(subdiv->lat()));
+			copyPolys(rect, origin, &polys->polygons, &polys->polygonPoints,
+			  polygons);
 			if (lines)
-				copyPolys(rect, &polys->lines, lines);
+				copyPolys(rect, origin, &polys->lines, &polys->linePoints,
+				  lines);
 		}
 	}
 
@@ -268,7 +342,7 @@ void VectorTile::points(QFile *file, const RectC &rect, const Zoom &zoom,
 			copyPoints(rect, pl, points);
 
 			cacheLock->lock();
-			cache->insert(subdiv, pl);
+			cache->insert(subdiv, pl, cost(pl));
 		} else
 			copyPoints(rect, pl, points);
 	}
@@ -280,8 +354,8 @@ void VectorTile::points(QFile *file, const RectC &rect, const Zoom &zoom,
 }
 
 void VectorTile::elevations(QFile *file, const RectC &rect, const Zoom &zoom,
-  QList<MapData::Elevation> *elevations, MapData::ElevationCache *cache,
-  QMutex *cacheLock)
+  double resolution, QList<MapData::Elevation> *elevations,
+  MapData::ElevationCache *cache, QMutex *cacheLock)
 {
 	SubFile::Handle *hdl = 0;
 
@@ -302,12 +376,18 @@ void VectorTile::elevations(QFile *file, const RectC &rect, const Zoom &zoom,
 		}
 	}
 
-	// Shift the DEM level to get better data then what the map defines for
-	// the given zoom (we prefer rendering quality rather than speed). For
-	// maps with a single level this has no effect.
-	int level = qMax(0, _dem->level(zoom) - 1);
+	// Without a required resolution, shift the DEM level to get better data
+	// then what the map defines for the given zoom (we prefer rendering
+	// quality rather than speed). For maps with a single level this has no
+	// effect.
+	int level = (resolution > 0) ? _dem->level(resolution)
+	  : qMax(0, _dem->level(zoom) - 1);
 	QList<const DEMTile*> tiles(_dem->tiles(rect, level));
 
+	// The DEM structure is immutable once loaded, so the (expensive) tiles
+	// decoding can run in parallel.
+	_demLock.unlock();
+
 	cacheLock->lock();
 
 	for (int i = 0; i < tiles.size(); i++) {
@@ -325,7 +405,10 @@ void VectorTile::elevations(QFile *file, const RectC &rect, const Zoom &zoom,
 				elevations->append(*el);
 
 			cacheLock->lock();
-			cache->insert(tile, el);
+			if (cache->contains(tile))
+				delete el;
+			else
+				cache->insert(tile, el, cost(el));
 		} else {
 			if (!el->m.isNull())
 				elevations->append(*el);
@@ -333,7 +416,6 @@ void VectorTile::elevations(QFile *file, const RectC &rect, const Zoom &zoom,
 	}
 
 	cacheLock->unlock();
-	_demLock.unlock();
 
 	delete hdl;
 }
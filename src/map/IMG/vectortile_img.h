@@ -37,8 +37,8 @@ public:
 	  QList<MapData::Point> *points, MapData::PointCache *cache,
 	  QMutex *cacheLock);
 	void elevations(QFile *file, const RectC &rect, const Zoom &zoom,
-	  QList<MapData::Elevation> *elevations, MapData::ElevationCache *cache,
-	  QMutex *cacheLock);
+	  double resolution, QList<MapData::Elevation> *elevations,
+	  MapData::ElevationCache *cache, QMutex *cacheLock);
 
 	static bool isTileFile(SubFile::Type type)
 	{
@@ -0,0 +1,41 @@
+#include "maplist.h"
+#include "catalogmap.h"
+
+CatalogMap::CatalogMap(const QString &path, const Projection &proj,
+  const QString &parser, const QString &name, const RectC &bounds,
+  QObject *parent) : Map(path, parent), _proj(proj), _parser(parser),
+  _name(name), _bounds(bounds), _map(0)
+{
+}
+
+CatalogMap::~CatalogMap()
+{
+	delete _map;
+}
+
+Map *CatalogMap::map()
+{
+	if (!_map) {
+		_map = MapList::createMap(path(), _proj, _parser);
+		if (!_map->isValid())
+			qWarning("%s: %s", qUtf8Printable(path()),
+			  qUtf8Printable(_map->errorString()));
+
+		connect(_map, &Map::tilesLoaded, this, &Map::tilesLoaded);
+		connect(_map, &Map::mapLoaded, this, &Map::mapLoaded);
+	}
+
+	return _map;
+}
+
+void CatalogMap::load(const Projection &in, const Projection &out,
+  qreal deviceRatio, bool hidpi, bool hillShading, int style, int layer)
+{
+	map()->load(in, out, deviceRatio, hidpi, hillShading, style, layer);
+}
+
+void CatalogMap::unload()
+{
+	if (_map)
+		_map->unload();
+}
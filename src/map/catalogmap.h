@@ -0,0 +1,73 @@
+#ifndef CATALOGMAP_H
+#define CATALOGMAP_H
+
+#include "projection.h"
+#include "map.h"
+
+/*
+  Placeholder for a map loaded from the map catalog. The name and bounds are
+  taken from the catalog and the real map object is created on first use,
+  all the other calls are forwarded to it. The const functions only provide
+  valid data once the map has been loaded.
+*/
+class CatalogMap : public Map
+{
+	Q_OBJECT
+
+public:
+	CatalogMap(const QString &path, const Projection &proj,
+	  const QString &parser, const QString &name, const RectC &bounds,
+	  QObject *parent = 0);
+	~CatalogMap();
+
+	QString name() const {return _name;}
+
+	bool isValid() const {return _map ? _map->isValid() : true;}
+	bool isReady() const {return _map ? _map->isReady() : true;}
+	QString errorString() const
+	  {return _map ? _map->errorString() : QString();}
+
+	void load(const Projection &in, const Projection &out, qreal deviceRatio,
+	  bool hidpi, bool hillShading, int style, int layer);
+	void unload();
+
+	RectC llBounds() {return _map ? _map->llBounds() : _bounds;}
+	QRectF bounds() {return map()->bounds();}
+	qreal resolution(const QRectF &rect) {return map()->resolution(rect);}
+
+	int zoom() const {return _map ? _map->zoom() : 0;}
+	void setZoom(int zoom) {map()->setZoom(zoom);}
+	int zoomFit(const QSize &size, const RectC &rect)
+	  {return map()->zoomFit(size, rect);}
+	int zoomIn() {return map()->zoomIn();}
+	int zoomOut() {return map()->zoomOut();}
+
+	QPointF ll2xy(const Coordinates &c) {return map()->ll2xy(c);}
+	Coordinates xy2ll(const QPointF &p) {return map()->xy2ll(p);}
+
+	void draw(QPainter *painter, const QRectF &rect, Flags flags)
+	  {map()->draw(painter, rect, flags);}
+
+	double elevation(const Coordinates &c) {return map()->elevation(c);}
+	QVector<double> elevations(const QVector<Coordinates> &c)
+	  {return map()->elevations(c);}
+
+	QStringList layers(const QString &lang, int &defaultLayer) const
+	  {return _map ? _map->layers(lang, defaultLayer) : QStringList();}
+	QStringList styles(int &defaultStyle) const
+	  {return _map ? _map->styles(defaultStyle) : QStringList();}
+	bool hillShading() const {return _map ? _map->hillShading() : false;}
+
+	void clearCache() {map()->clearCache();}
+
+private:
+	Map *map();
+
+	Projection _proj;
+	QString _parser;
+	QString _name;
+	RectC _bounds;
+	Map *_map;
+};
+
+#endif // CATALOGMAP_H
@@ -1,4 +1,6 @@
 #include <QFile>
+#include <QDataStream>
+#include <QtConcurrent>
 #include <QPainter>
 #include <QPixmapCache>
 #include "common/wgs84.h"
@@ -8,6 +10,8 @@
 #include "rectd.h"
 #include "pcs.h"
 #include "imgjob.h"
+#include "tilefallback.h"
+#include "metatile.h"
 #include "coros4map.h"
 
 using namespace IMG;
@@ -15,45 +19,131 @@ using namespace IMG;
 #define EPSILON    1e-6
 #define TILE_SIZE  384
 #define DELTA      1e-3
+#define FALLBACK_LEVELS 3
 
-void Coros4Map::loadDir(const QString &path, MapTree &tree)
+#define INDEX_MAGIC   0x43344958 /* "C4IX" */
+#define INDEX_VERSION 1
+
+Coros4Map::Tile::Tile(const QFileInfo &fi, Layer layer, Coros4Map *map)
+  : map(map), path(fi.absoluteFilePath()), layer(layer), size(fi.size()),
+  time(fi.lastModified().toMSecsSinceEpoch()), hasDEM(false), valid(false),
+  indexed(false), data(0)
+{
+}
+
+void Coros4Map::Tile::load()
+{
+	if (indexed) {
+		if (valid)
+			data = new IMGData(path, bounds, zooms, hasDEM, map->_polyCache,
+			  map->_pointCache, map->_demCache, map->_lock, map->_demLock);
+	} else {
+		data = new IMGData(path, map->_polyCache, map->_pointCache,
+		  map->_demCache, map->_lock, map->_demLock);
+		valid = data->isValid();
+
+		if (valid) {
+			bounds = data->bounds();
+			zooms = data->zooms();
+			hasDEM = data->hasDEM();
+		} else {
+			qWarning("%s: %s", qUtf8Printable(data->fileName()),
+			  qUtf8Printable(data->errorString()));
+			delete data;
+			data = 0;
+		}
+	}
+}
+
+void Coros4Map::loadDir(const QString &path, Layer layer, QList<Tile> &tiles)
 {
 	QDir md(path);
 	md.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
 	QFileInfoList ml = md.entryInfoList();
-	double min[2], max[2];
 
 	for (int i = 0; i < ml.size(); i++) {
 		const QFileInfo &fi = ml.at(i);
 
 		if (fi.isDir())
-			loadDir(fi.absoluteFilePath(), tree);
-		else {
-			IMGData *data = new IMGData(fi.absoluteFilePath(), _polyCache,
-			  _pointCache, _demCache, _lock, _demLock);
-			if (data->isValid()) {
-				min[0] = data->bounds().left();
-				min[1] = data->bounds().bottom();
-				max[0] = data->bounds().right();
-				max[1] = data->bounds().top();
-
-				tree.Insert(min, max, data);
-
-				_dataBounds |= data->bounds();
-				_zooms |= data->zooms();
-				_hasDEM |= data->hasDEM();
-			} else {
-				qWarning("%s: %s", qUtf8Printable(data->fileName()),
-				  qUtf8Printable(data->errorString()));
-				delete data;
-			}
-		}
+			loadDir(fi.absoluteFilePath(), layer, tiles);
+		else
+			tiles.append(Tile(fi, layer, this));
+	}
+}
+
+QHash<QString, Coros4Map::Tile> Coros4Map::loadIndex(const QString &path,
+  const QDir &dir) const
+{
+	QHash<QString, Tile> index;
+	QFile file(path);
+	quint32 magic, version, count;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return index;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream >> magic >> version >> count;
+	if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC
+	  || version != INDEX_VERSION)
+		return index;
+
+	for (quint32 i = 0; i < count; i++) {
+		QString name;
+		Tile t;
+		double left, top, right, bottom;
+		qint32 min, max;
+		quint8 layer, hasDEM, valid;
+
+		stream >> name >> layer >> t.size >> t.time >> valid >> hasDEM >> left
+		  >> top >> right >> bottom >> min >> max;
+		if (stream.status() != QDataStream::Ok)
+			return QHash<QString, Tile>();
+
+		t.path = dir.absoluteFilePath(name);
+		t.layer = (Layer)layer;
+		t.valid = valid;
+		t.hasDEM = hasDEM;
+		t.bounds = RectC(Coordinates(left, top), Coordinates(right, bottom));
+		t.zooms = Range(min, max);
+
+		index.insert(t.path, t);
 	}
+
+	return index;
+}
+
+void Coros4Map::saveIndex(const QString &path, const QDir &dir,
+  const QList<Tile> &tiles) const
+{
+	QFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << (quint32)INDEX_MAGIC << (quint32)INDEX_VERSION
+	  << (quint32)tiles.size();
+
+	for (int i = 0; i < tiles.size(); i++) {
+		const Tile &t = tiles.at(i);
+
+		stream << dir.relativeFilePath(t.path) << (quint8)t.layer << t.size
+		  << t.time << (quint8)t.valid << (quint8)t.hasDEM << t.bounds.left()
+		  << t.bounds.top() << t.bounds.right() << t.bounds.bottom()
+		  << (qint32)t.zooms.min() << (qint32)t.zooms.max();
+	}
+
+	if (stream.status() != QDataStream::Ok)
+		file.remove();
 }
 
 Coros4Map::Coros4Map(const QString &fileName, QObject *parent)
   : Map(fileName, parent), _projection(PCS::pcs(3857)), _tileRatio(1.0),
-  _layer(All), _style(0), _hasDEM(false), _hillShading(false), _valid(false)
+  _layer(All), _style(0), _polyCache("IMG polygons", &_lock),
+  _pointCache("IMG points", &_lock), _demCache("IMG DEM", &_demLock),
+  _hasDEM(false), _hillShading(false), _valid(false)
 {
 	QFileInfo fi(fileName);
 	QDir dir(fi.absolutePath());
@@ -66,8 +156,58 @@ Coros4Map::Coros4Map(const QString &fileName, QObject *parent)
 
 	QDir osmDir(mapDir.filePath("OSM"));
 	QDir cmDir(mapDir.filePath("CM"));
-	loadDir(osmDir.absolutePath(), _osm);
-	loadDir(cmDir.absolutePath(), _cm);
+	QList<Tile> tiles;
+	loadDir(osmDir.absolutePath(), Landscape, tiles);
+	loadDir(cmDir.absolutePath(), Topo, tiles);
+
+	/* The tile index keeps the bounds, zooms and DEM info of the tiles so the
+	   tiles do not have to be parsed until they are really used. Tiles
+	   missing in the index are probed in parallel. */
+	QString indexFile(fileName + ".idx");
+	QHash<QString, Tile> index(loadIndex(indexFile, mapDir));
+	bool changed = (index.size() != tiles.size());
+	for (int i = 0; i < tiles.size(); i++) {
+		Tile &t = tiles[i];
+		QHash<QString, Tile>::const_iterator it(index.constFind(t.path));
+
+		if (it != index.constEnd() && it->layer == t.layer
+		  && it->size == t.size && it->time == t.time) {
+			t.bounds = it->bounds;
+			t.zooms = it->zooms;
+			t.hasDEM = it->hasDEM;
+			t.valid = it->valid;
+			t.indexed = true;
+		} else
+			changed = true;
+	}
+
+	QFuture<void> future = QtConcurrent::map(tiles, &Tile::load);
+	future.waitForFinished();
+
+	for (int i = 0; i < tiles.size(); i++) {
+		const Tile &t = tiles.at(i);
+		double min[2], max[2];
+
+		if (!t.data)
+			continue;
+
+		min[0] = t.bounds.left();
+		min[1] = t.bounds.bottom();
+		max[0] = t.bounds.right();
+		max[1] = t.bounds.top();
+
+		if (t.layer == Landscape)
+			_osm.Insert(min, max, t.data);
+		else
+			_cm.Insert(min, max, t.data);
+
+		_dataBounds |= t.bounds;
+		_zooms |= t.zooms;
+		_hasDEM |= t.hasDEM;
+	}
+
+	if (changed)
+		saveIndex(indexFile, mapDir, tiles);
 
 	if (!(_dataBounds.isValid() && _zooms.isValid())) {
 		_errorString = "No usable map tile found";
@@ -217,13 +357,15 @@ void Coros4Map::updateTransform()
 		_bounds.adjust(0.5, 0, -0.5, 0);
 }
 
-bool Coros4Map::isRunning(const QString &key) const
+bool Coros4Map::isRunning(const QString &prefix, const QPoint &xy) const
 {
 	for (int i = 0; i < _jobs.size(); i++) {
 		const QList<RasterTile> &tiles = _jobs.at(i)->tiles();
-		for (int j = 0; j < tiles.size(); j++)
-			if (tiles.at(j).key() == key)
+		for (int j = 0; j < tiles.size(); j++) {
+			const RasterTile &mt = tiles.at(j);
+			if (mt.xy() == xy && mt.key() == prefix)
 				return true;
+		}
 	}
 
 	return false;
@@ -250,7 +392,7 @@ void Coros4Map::jobFinished(IMGJob *job)
 	for (int i = 0; i < tiles.size(); i++) {
 		const RasterTile &mt = tiles.at(i);
 		if (!mt.pixmap().isNull())
-			QPixmapCache::insert(mt.key(), mt.pixmap());
+			MetaTile::cache(mt.key(), mt.xy(), TILE_SIZE, mt.pixmap());
 	}
 
 	removeJob(job);
@@ -271,6 +413,18 @@ static bool cb(MapData *data, void *context)
 	return true;
 }
 
+TileFallback Coros4Map::fallback() const
+{
+	TileFallback fb(TILE_SIZE);
+
+	for (int z = _zoom - 1; z >= qMax(_zooms.min(), _zoom - FALLBACK_LEVELS); z--)
+		fb.addLevel(path() + "-" + QString::number(z) + "_", z);
+	if (_zoom < _zooms.max())
+		fb.addLevel(path() + "-" + QString::number(_zoom + 1) + "_", _zoom + 1);
+
+	return fb;
+}
+
 void Coros4Map::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	double min[2], max[2];
@@ -279,24 +433,36 @@ void Coros4Map::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	QSizeF s(rect.right() - tl.x(), rect.bottom() - tl.y());
 	int width = ceil(s.width() / TILE_SIZE);
 	int height = ceil(s.height() / TILE_SIZE);
+	TileFallback fb((flags & Map::Block) ? TileFallback() : fallback());
 
+	QString prefix(path() + "-" + QString::number(_zoom) + "_");
 	QList<RasterTile> tiles;
+	QList<QPoint> metaTiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPixmap pm;
 			QPoint ttl(tl.x() + i * TILE_SIZE, tl.y() + j * TILE_SIZE);
-			QString key(path() + "-" + QString::number(_zoom)
-			  + "_" + QString::number(ttl.x()) + "_" + QString::number(ttl.y()));
-
-			if (isRunning(key))
+			QRectF tr(ttl, QSizeF(TILE_SIZE, TILE_SIZE));
+			QPoint txy(ttl.x() / TILE_SIZE, ttl.y() / TILE_SIZE);
+			QRect mtr((flags & Map::Block)
+			  ? QRect(ttl, QSize(TILE_SIZE, TILE_SIZE))
+			  : MetaTile::rect(ttl, TILE_SIZE));
+
+			if (isRunning(prefix, mtr.topLeft())) {
+				fb.draw(painter, tr, _zoom, txy);
 				continue;
+			}
 
-			if (QPixmapCache::find(key, &pm))
+			if (QPixmapCache::find(prefix + QString::number(ttl.x()) + "_"
+			  + QString::number(ttl.y()), &pm))
 				painter->drawPixmap(ttl, pm);
+			else if (metaTiles.contains(mtr.topLeft()))
+				fb.draw(painter, tr, _zoom, txy);
 			else {
-				RectD rectD(_transform.img2proj(ttl), _transform.img2proj(
-				  QPoint(ttl.x() + TILE_SIZE, ttl.y() + TILE_SIZE)));
+				RectD rectD(_transform.img2proj(mtr.topLeft()),
+				  _transform.img2proj(mtr.topLeft() + QPoint(mtr.width(),
+				  mtr.height())));
 				RectC rectC(rectD.toRectC(_projection, 20));
 				QList<MapData*> data;
 
@@ -310,10 +476,13 @@ void Coros4Map::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				if (_layer & Topo)
 					_cm.Search(min, max, cb, &data);
 
-				if (!data.isEmpty())
+				if (!data.isEmpty()) {
+					fb.draw(painter, tr, _zoom, txy);
+					metaTiles.append(mtr.topLeft());
 					tiles.append(RasterTile(&_projection, _transform, data,
-					  _style, _zoom, QRect(ttl, QSize(TILE_SIZE, TILE_SIZE)),
-					  _tileRatio, key, _hillShading, false, true));
+					  _style, _zoom, mtr, _tileRatio, prefix, _hillShading,
+					  false, true));
+				}
 			}
 		}
 	}
@@ -327,7 +496,7 @@ void Coros4Map::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				const RasterTile &mt = tiles.at(i);
 				const QPixmap &pm = mt.pixmap();
 				painter->drawPixmap(mt.xy(), pm);
-				QPixmapCache::insert(mt.key(), pm);
+				MetaTile::cache(mt.key(), mt.xy(), TILE_SIZE, pm);
 			}
 		} else
 			runJob(new IMGJob(tiles));
@@ -374,6 +543,46 @@ double Coros4Map::elevation(const Coordinates &c)
 	return Map::elevation(c);
 }
 
+QVector<double> Coros4Map::elevations(const QVector<Coordinates> &c)
+{
+	double min[2], max[2];
+	QList<MapData*> maps;
+	QVector<double> ele(c.size(), NAN);
+	RectC rect;
+
+	for (int i = 0; i < c.size(); i++)
+		rect = rect.united(c.at(i));
+	if (rect.isNull())
+		return ele;
+
+	min[0] = rect.left();
+	min[1] = rect.bottom();
+	max[0] = rect.right();
+	max[1] = rect.top();
+
+	_osm.Search(min, max, ecb, &maps);
+	_cm.Search(min, max, ecb, &maps);
+
+	for (int i = 0; i < maps.size(); i++)
+		DEMTree::elevations(maps.at(i), c, ele);
+
+	QVector<Coordinates> missing;
+	QVector<int> idx;
+	for (int i = 0; i < c.size(); i++) {
+		if (std::isnan(ele.at(i))) {
+			missing.append(c.at(i));
+			idx.append(i);
+		}
+	}
+	if (!missing.isEmpty()) {
+		QVector<double> dem(Map::elevations(missing));
+		for (int i = 0; i < idx.size(); i++)
+			ele[idx.at(i)] = dem.at(i);
+	}
+
+	return ele;
+}
+
 QStringList Coros4Map::styles(int &defaultStyle) const
 {
 	QStringList list;
@@ -1,12 +1,15 @@
 #ifndef COROS4MAP_H
 #define COROS4MAP_H
 
+#include <QFileInfo>
 #include "IMG/mapdata_img.h"
 #include "map.h"
 #include "projection.h"
 #include "transform.h"
 
+class QDir;
 class IMGJob;
+class TileFallback;
 namespace IMG {class Style;}
 
 class Coros4Map : public Map
@@ -38,6 +41,7 @@ public:
 	void unload();
 
 	double elevation(const Coordinates &c);
+	QVector<double> elevations(const QVector<Coordinates> &c);
 
 	QStringList styles(int &defaultStyle) const;
 	QStringList layers(const QString &lang, int &defaultLayer) const;
@@ -64,16 +68,37 @@ private:
 		StyleList();
 	};
 
+	struct Tile {
+		Tile() : map(0), layer(All), size(0), time(0), hasDEM(false),
+		  valid(false), indexed(false), data(0) {}
+		Tile(const QFileInfo &fi, Layer layer, Coros4Map *map);
+
+		void load();
+
+		Coros4Map *map;
+		QString path;
+		Layer layer;
+		qint64 size, time;
+		RectC bounds;
+		Range zooms;
+		bool hasDEM, valid, indexed;
+		IMG::MapData *data;
+	};
+
 	typedef RTree<IMG::MapData*, double, 2> MapTree;
 
 	Transform transform(int zoom) const;
 	void updateTransform();
-	bool isRunning(const QString &key) const;
+	bool isRunning(const QString &prefix, const QPoint &xy) const;
 	void runJob(IMGJob *job);
 	void removeJob(IMGJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback() const;
 
-	void loadDir(const QString &path, MapTree &tree);
+	void loadDir(const QString &path, Layer layer, QList<Tile> &tiles);
+	QHash<QString, Tile> loadIndex(const QString &path, const QDir &dir) const;
+	void saveIndex(const QString &path, const QDir &dir,
+	  const QList<Tile> &tiles) const;
 
 	static StyleList &styles();
 
@@ -87,10 +112,10 @@ private:
 	qreal _tileRatio;
 	Layer _layer;
 	IMG::Style *_style;
+	QMutex _lock, _demLock;
 	IMG::MapData::PolyCache _polyCache;
 	IMG::MapData::PointCache _pointCache;
 	IMG::MapData::ElevationCache _demCache;
-	QMutex _lock, _demLock;
 	QString _typ;
 	bool _hasDEM, _hillShading;
 
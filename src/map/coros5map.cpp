@@ -1,6 +1,7 @@
 #include <QPixmapCache>
 #include <QPainter>
 #include <QImageReader>
+#include <QtConcurrent>
 #include "osm.h"
 #include "coros5map.h"
 
@@ -48,32 +49,53 @@ Coros5Map::MapTile::MapTile(const QString &path) : path(path)
 	tt = hdr.tt;
 }
 
-void Coros5Map::loadDir(const QString &path, MapTree &tree, Range &zooms)
+Coros5Map::MapTile *Coros5Map::mapTile(const QString &path)
+{
+	return new MapTile(path);
+}
+
+void Coros5Map::listDir(const QString &path, QStringList &files)
 {
 	QDir md(path);
 	md.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
 	QFileInfoList ml = md.entryInfoList();
-	double min[2], max[2];
 
 	for (int i = 0; i < ml.size(); i++) {
 		const QFileInfo &fi = ml.at(i);
 
 		if (fi.isDir())
-			loadDir(fi.absoluteFilePath(), tree, zooms);
-		else {
-			MapTile *map = new MapTile(fi.absoluteFilePath());
-			if (map->isValid()) {
-				min[0] = map->bounds.left();
-				min[1] = map->bounds.bottom();
-				max[0] = map->bounds.right();
-				max[1] = map->bounds.top();
-
-				tree.Insert(min, max, map);
-				_bounds |= map->bounds;
-				zooms |= map->zooms;
-			} else
-				delete map;
-		}
+			listDir(fi.absoluteFilePath(), files);
+		else
+			files.append(fi.absoluteFilePath());
+	}
+}
+
+void Coros5Map::loadDir(const QString &path, MapTree &tree, Range &zooms)
+{
+	QStringList files;
+	double min[2], max[2];
+
+	listDir(path, files);
+
+	/* Only the PMTiles headers are read, but full packages have thousands of
+	   tiles so the files are opened in parallel. */
+	QList<MapTile*> maps(QtConcurrent::blockingMapped<QList<MapTile*> >(
+	  files, &Coros5Map::mapTile));
+
+	for (int i = 0; i < maps.size(); i++) {
+		MapTile *map = maps.at(i);
+
+		if (map->isValid()) {
+			min[0] = map->bounds.left();
+			min[1] = map->bounds.bottom();
+			max[0] = map->bounds.right();
+			max[1] = map->bounds.top();
+
+			tree.Insert(min, max, map);
+			_bounds |= map->bounds;
+			zooms |= map->zooms;
+		} else
+			delete map;
 	}
 }
 
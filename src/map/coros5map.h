@@ -101,6 +101,8 @@ private:
 	void cancelJobs(bool wait);
 
 	void loadDir(const QString &path, MapTree &tree, Range &zooms);
+	static void listDir(const QString &path, QStringList &files);
+	static MapTile *mapTile(const QString &path);
 	const MVT::Style *defaultStyle() const;
 
 	static bool cb(MapTile *data, void *context);
@@ -80,14 +80,7 @@ QString DEM::Tile::fileName() const
 
 QMutex DEM::_lock;
 QString DEM::_dir;
-DEM::TileCache DEM::_data;
-
-void DEM::setCacheSize(int size)
-{
-	_lock.lock();
-	_data.setMaxCost(size);
-	_lock.unlock();
-}
+DEM::TileCache DEM::_data("DEM", &DEM::_lock);
 
 void DEM::setDir(const QString &path)
 {
@@ -139,20 +132,21 @@ DEM::Entry *DEM::loadTile(const Tile &tile)
 	}
 }
 
-double DEM::elevationLockFree(const Coordinates &c)
+DEM::Entry *DEM::entry(const Tile &tile)
 {
-	Tile tile(floor(c.lon()), floor(c.lat()));
 	Entry *e = _data.object(tile);
-	double ele;
 
 	if (!e) {
 		e = loadTile(tile);
-		ele = height(c, e);
-		_data.insert(tile, e, e->data().size() / 1024);
-	} else
-		ele = height(c, e);
+		_data.insert(tile, e, sizeof(Entry) + e->data().size());
+	}
 
-	return ele;
+	return e;
+}
+
+double DEM::elevationLockFree(const Coordinates &c)
+{
+	return height(c, entry(Tile(floor(c.lon()), floor(c.lat()))));
 }
 
 double DEM::elevation(const Coordinates &c)
@@ -182,6 +176,34 @@ MatrixD DEM::elevation(const MatrixC &m)
 	return ret;
 }
 
+QVector<double> DEM::elevation(const QVector<Coordinates> &c)
+{
+	if (_dir.isEmpty())
+		return QVector<double>(c.size(), NAN);
+
+	QVector<double> ret(c.size());
+	Tile tile(0, 0);
+	const Entry *e = 0;
+
+	/* Path points are mostly ordered, so the tile of the previous point is
+	   reused without a cache lookup. The entry stays valid as it is the most
+	   recently used entry of the cache that can not be evicted. */
+	_lock.lock();
+	for (int i = 0; i < c.size(); i++) {
+		const Coordinates &p = c.at(i);
+		Tile t(floor(p.lon()), floor(p.lat()));
+
+		if (!e || !(t == tile)) {
+			tile = t;
+			e = entry(tile);
+		}
+		ret[i] = height(p, e);
+	}
+	_lock.unlock();
+
+	return ret;
+}
+
 bool DEM::elevation(const RectC &rect)
 {
 	if (_dir.isEmpty())
@@ -2,10 +2,10 @@
 #define DEM_H
 
 #include <QString>
-#include <QCache>
 #include <QByteArray>
 #include <QMutex>
 #include "common/hash.h"
+#include "common/memorycache.h"
 #include "data/area.h"
 #include "matrix.h"
 
@@ -32,12 +32,12 @@ public:
 		int _lon, _lat;
 	};
 
-	static void setCacheSize(int size);
 	static void setDir(const QString &path);
 	static void clearCache();
 
 	static double elevation(const Coordinates &c);
 	static MatrixD elevation(const MatrixC &m);
+	static QVector<double> elevation(const QVector<Coordinates> &c);
 	static bool elevation(const RectC &rect);
 
 	static QList<Area> tiles();
@@ -56,10 +56,11 @@ private:
 		QByteArray _data;
 	};
 
-	typedef QCache<DEM::Tile, Entry> TileCache;
+	typedef MemoryCache<DEM::Tile, Entry> TileCache;
 
 	static double height(const Coordinates &c, const Entry *e);
 	static Entry *loadTile(const Tile &tile);
+	static Entry *entry(const Tile &tile);
 	static double elevationLockFree(const Coordinates &c);
 
 	static QString _dir;
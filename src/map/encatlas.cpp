@@ -5,6 +5,7 @@
 #include "rectd.h"
 #include "pcs.h"
 #include "encjob.h"
+#include "metatile.h"
 #include "encatlas.h"
 
 using namespace ENC;
@@ -115,7 +116,7 @@ void ENCAtlas::addMap(const QDir &dir, const QByteArray &file,
 
 ENCAtlas::ENCAtlas(const QString &fileName, QObject *parent)
   : Map(fileName, parent), _projection(PCS::pcs(3857)),  _tileRatio(1.0),
-  _style(0), _zoom(0), _valid(false)
+  _style(0), _cache("ENC", &_cacheLock), _zoom(0), _valid(false)
 {
 	QDir dir(QFileInfo(fileName).absoluteDir());
 	ISO8211 ddf(fileName);
@@ -147,8 +148,6 @@ ENCAtlas::ENCAtlas(const QString &fileName, QObject *parent)
 	_zoom = zooms(_usage).min();
 	updateTransform();
 
-	_cache.setMaxCost(16);
-
 	_valid = true;
 }
 
@@ -180,7 +179,9 @@ void ENCAtlas::unload()
 {
 	cancelJobs(true);
 
+	_cacheLock.lock();
 	_cache.clear();
+	_cacheLock.unlock();
 
 	delete _style;
 	_style = 0;
@@ -321,7 +322,7 @@ void ENCAtlas::jobFinished(ENCJob *job)
 	for (int i = 0; i < tiles.size(); i++) {
 		const ENC::RasterTile &mt = tiles.at(i);
 		if (!mt.pixmap().isNull())
-			QPixmapCache::insert(key(mt.zoom(), mt.xy()), mt.pixmap());
+			MetaTile::cache(prefix(mt.zoom()), mt.xy(), TILE_SIZE, mt.pixmap());
 	}
 
 	removeJob(job);
@@ -335,10 +336,15 @@ void ENCAtlas::cancelJobs(bool wait)
 		_jobs.at(i)->cancel(wait);
 }
 
+QString ENCAtlas::prefix(int zoom) const
+{
+	return path() + "-" + QString::number(zoom) + "_";
+}
+
 QString ENCAtlas::key(int zoom, const QPoint &xy) const
 {
-	return path() + "-" + QString::number(zoom) + "_"
-	  + QString::number(xy.x()) + "_" + QString::number(xy.y());
+	return prefix(zoom) + QString::number(xy.x()) + "_"
+	  + QString::number(xy.y());
 }
 
 QList<Data*> ENCAtlas::levels() const
@@ -364,20 +370,25 @@ void ENCAtlas::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	int height = ceil(s.height() / TILE_SIZE);
 
 	QList<RasterTile> tiles;
+	QList<QPoint> metaTiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPoint ttl(tl.x() + i * TILE_SIZE, tl.y() + j * TILE_SIZE);
-			if (isRunning(_zoom, ttl))
+			QRect mtr((flags & Map::Block)
+			  ? QRect(ttl, QSize(TILE_SIZE, TILE_SIZE))
+			  : MetaTile::rect(ttl, TILE_SIZE));
+			if (isRunning(_zoom, mtr.topLeft()))
 				continue;
 
 			QPixmap pm;
 			if (QPixmapCache::find(key(_zoom, ttl), &pm))
 				painter->drawPixmap(ttl, pm);
-			else
+			else if (!metaTiles.contains(mtr.topLeft())) {
+				metaTiles.append(mtr.topLeft());
 				tiles.append(RasterTile(_projection, _transform, _style,
-				  data, _zoom, zr, QRect(ttl, QSize(TILE_SIZE, TILE_SIZE)),
-				  _tileRatio));
+				  data, _zoom, zr, mtr, _tileRatio));
+			}
 		}
 	}
 
@@ -390,7 +401,7 @@ void ENCAtlas::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				const RasterTile &mt = tiles.at(i);
 				const QPixmap &pm = mt.pixmap();
 				painter->drawPixmap(mt.xy(), pm);
-				QPixmapCache::insert(key(mt.zoom(), mt.xy()), pm);
+				MetaTile::cache(prefix(mt.zoom()), mt.xy(), TILE_SIZE, pm);
 			}
 		} else
 			runJob(new ENCJob(tiles));
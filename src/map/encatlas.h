@@ -72,6 +72,7 @@ private:
 	void runJob(ENCJob *job);
 	void removeJob(ENCJob *job);
 	void cancelJobs(bool wait);
+	QString prefix(int zoom) const;
 	QString key(int zoom, const QPoint &xy) const;
 	void addMap(const QDir &dir, const QByteArray &file, const RectC &bounds);
 	QList<ENC::Data*> levels() const;
@@ -89,8 +90,8 @@ private:
 	qreal _tileRatio;
 	QMap<IntendedUsage, ENC::AtlasData*> _data;
 	ENC::Style *_style;
-	ENC::MapCache _cache;
 	QMutex _cacheLock;
+	ENC::MapCache _cache;
 	IntendedUsage _usage;
 	int _zoom;
 
@@ -7,6 +7,7 @@
 #include "rectd.h"
 #include "pcs.h"
 #include "encjob.h"
+#include "metatile.h"
 #include "encmap.h"
 
 
@@ -312,7 +313,7 @@ void ENCMap::jobFinished(ENCJob *job)
 	for (int i = 0; i < tiles.size(); i++) {
 		const ENC::RasterTile &mt = tiles.at(i);
 		if (!mt.pixmap().isNull())
-			QPixmapCache::insert(key(mt.zoom(), mt.xy()), mt.pixmap());
+			MetaTile::cache(prefix(mt.zoom()), mt.xy(), TILE_SIZE, mt.pixmap());
 	}
 
 	removeJob(job);
@@ -326,15 +327,19 @@ void ENCMap::cancelJobs(bool wait)
 		_jobs.at(i)->cancel(wait);
 }
 
+QString ENCMap::prefix(int zoom) const
+{
+	return path() + "-" + QString::number(zoom) + "_";
+}
+
 QString ENCMap::key(int zoom, const QPoint &xy) const
 {
-	return path() + "-" + QString::number(zoom) + "_"
-	  + QString::number(xy.x()) + "_" + QString::number(xy.y());
+	return prefix(zoom) + QString::number(xy.x()) + "_"
+	  + QString::number(xy.y());
 }
 
 void ENCMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
-	Q_UNUSED(flags);
 	QPointF tl(floor(rect.left() / TILE_SIZE) * TILE_SIZE,
 	  floor(rect.top() / TILE_SIZE) * TILE_SIZE);
 	QSizeF s(rect.right() - tl.x(), rect.bottom() - tl.y());
@@ -342,20 +347,25 @@ void ENCMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	int height = ceil(s.height() / TILE_SIZE);
 
 	QList<RasterTile> tiles;
+	QList<QPoint> metaTiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPoint ttl(tl.x() + i * TILE_SIZE, tl.y() + j * TILE_SIZE);
-			if (isRunning(_zoom, ttl))
+			QRect mtr((flags & Map::Block)
+			  ? QRect(ttl, QSize(TILE_SIZE, TILE_SIZE))
+			  : MetaTile::rect(ttl, TILE_SIZE));
+			if (isRunning(_zoom, mtr.topLeft()))
 				continue;
 
 			QPixmap pm;
 			if (QPixmapCache::find(key(_zoom, ttl), &pm))
 				painter->drawPixmap(ttl, pm);
-			else
+			else if (!metaTiles.contains(mtr.topLeft())) {
+				metaTiles.append(mtr.topLeft());
 				tiles.append(RasterTile(_projection, _transform, _style, _data,
-				  _zoom, _zooms, QRect(ttl, QSize(TILE_SIZE, TILE_SIZE)),
-				  _tileRatio));
+				  _zoom, _zooms, mtr, _tileRatio));
+			}
 		}
 	}
 
@@ -368,7 +378,7 @@ void ENCMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				const RasterTile &mt = tiles.at(i);
 				const QPixmap &pm = mt.pixmap();
 				painter->drawPixmap(mt.xy(), pm);
-				QPixmapCache::insert(key(mt.zoom(), mt.xy()), pm);
+				MetaTile::cache(prefix(mt.zoom()), mt.xy(), TILE_SIZE, pm);
 			}
 		} else
 			runJob(new ENCJob(tiles));
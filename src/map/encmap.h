@@ -92,6 +92,7 @@ private:
 	void runJob(ENCJob *job);
 	void removeJob(ENCJob *job);
 	void cancelJobs(bool wait);
+	QString prefix(int zoom) const;
 	QString key(int zoom, const QPoint &xy) const;
 
 	static bool bounds(const ENC::ISO8211::Record &record, Rect &rect);
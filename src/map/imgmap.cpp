@@ -10,6 +10,8 @@
 #include "pcs.h"
 #include "rectd.h"
 #include "imgjob.h"
+#include "tilefallback.h"
+#include "metatile.h"
 #include "imgmap.h"
 
 using namespace IMG;
@@ -17,6 +19,7 @@ using namespace IMG;
 #define EPSILON    1e-6
 #define TILE_SIZE  384
 #define DELTA      1e-3
+#define FALLBACK_LEVELS 3
 
 static RectC limitBounds(const RectC &bounds, const Projection &proj)
 {
@@ -57,8 +60,10 @@ QList<MapData*> IMGMap::overlays(const QString &fileName)
 }
 
 IMGMap::IMGMap(const QString &fileName, bool GMAP, QObject *parent)
-  : Map(fileName, parent), _projection(PCS::pcs(3857)), _tileRatio(1.0),
-  _layer(All), _hillShading(false), _valid(false)
+  : Map(fileName, parent), _polyCache("IMG polygons", &_lock),
+  _pointCache("IMG points", &_lock), _demCache("IMG DEM", &_demLock),
+  _projection(PCS::pcs(3857)), _tileRatio(1.0), _layer(All),
+  _hillShading(false), _valid(false)
 {
 	if (GMAP)
 		_data.append(new GMAPData(fileName, _polyCache, _pointCache, _demCache,
@@ -213,13 +218,15 @@ void IMGMap::updateTransform()
 		_bounds.adjust(0.5, 0, -0.5, 0);
 }
 
-bool IMGMap::isRunning(const QString &key) const
+bool IMGMap::isRunning(const QString &prefix, const QPoint &xy) const
 {
 	for (int i = 0; i < _jobs.size(); i++) {
 		const QList<IMG::RasterTile> &tiles = _jobs.at(i)->tiles();
-		for (int j = 0; j < tiles.size(); j++)
-			if (tiles.at(j).key() == key)
+		for (int j = 0; j < tiles.size(); j++) {
+			const IMG::RasterTile &mt = tiles.at(j);
+			if (mt.xy() == xy && mt.key() == prefix)
 				return true;
+		}
 	}
 
 	return false;
@@ -246,7 +253,7 @@ void IMGMap::jobFinished(IMGJob *job)
 	for (int i = 0; i < tiles.size(); i++) {
 		const IMG::RasterTile &mt = tiles.at(i);
 		if (!mt.pixmap().isNull())
-			QPixmapCache::insert(mt.key(), mt.pixmap());
+			MetaTile::cache(mt.key(), mt.xy(), TILE_SIZE, mt.pixmap());
 	}
 
 	removeJob(job);
@@ -260,6 +267,20 @@ void IMGMap::cancelJobs(bool wait)
 		_jobs.at(i)->cancel(wait);
 }
 
+TileFallback IMGMap::fallback(const IMG::MapData *data) const
+{
+	const Range &zooms = data->zooms();
+	TileFallback fb(TILE_SIZE);
+
+	for (int z = _zoom - 1; z >= qMax(zooms.min(), _zoom - FALLBACK_LEVELS); z--)
+		fb.addLevel(data->fileName() + "-" + QString::number(z) + "_", z);
+	if (_zoom < zooms.max())
+		fb.addLevel(data->fileName() + "-" + QString::number(_zoom + 1) + "_",
+		  _zoom + 1);
+
+	return fb;
+}
+
 void IMGMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	QPoint tl(qFloor(rect.left() / TILE_SIZE)
@@ -271,25 +292,39 @@ void IMGMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	QList<RasterTile> tiles;
 
 	for (int n = 0; n < _data.size(); n++) {
+		TileFallback fb((flags & Map::Block)
+		  ? TileFallback() : fallback(_data.at(n)));
+		QString prefix(_data.at(n)->fileName() + "-" + QString::number(_zoom)
+		  + "_");
+		QList<QPoint> metaTiles;
+
 		for (int i = 0; i < width; i++) {
 			for (int j = 0; j < height; j++) {
 				QPoint ttl(tl.x() + i * TILE_SIZE, tl.y() + j * TILE_SIZE);
-				QString key(_data.at(n)->fileName()
-				  + "-" + QString::number(_zoom)
-				  + "_" + QString::number(ttl.x())
-				  + "_" + QString::number(ttl.y()));
-
-				if (isRunning(key))
+				QRectF tr(ttl, QSizeF(TILE_SIZE, TILE_SIZE));
+				QPoint txy(ttl.x() / TILE_SIZE, ttl.y() / TILE_SIZE);
+				QRect mtr((flags & Map::Block)
+				  ? QRect(ttl, QSize(TILE_SIZE, TILE_SIZE))
+				  : MetaTile::rect(ttl, TILE_SIZE));
+
+				if (isRunning(prefix, mtr.topLeft())) {
+					fb.draw(painter, tr, _zoom, txy);
 					continue;
+				}
 
 				QPixmap pm;
-				if (QPixmapCache::find(key, &pm))
+				if (QPixmapCache::find(prefix + QString::number(ttl.x()) + "_"
+				  + QString::number(ttl.y()), &pm))
 					painter->drawPixmap(ttl, pm);
 				else {
-					tiles.append(RasterTile(&_projection, _transform,
-					  _data.at(n), _styles.at(n), _zoom,
-					  QRect(ttl, QSize(TILE_SIZE, TILE_SIZE)), _tileRatio, key,
-					  _hillShading, _layer & Raster, _layer & Vector));
+					fb.draw(painter, tr, _zoom, txy);
+					if (!metaTiles.contains(mtr.topLeft())) {
+						metaTiles.append(mtr.topLeft());
+						tiles.append(RasterTile(&_projection, _transform,
+						  _data.at(n), _styles.at(n), _zoom, mtr, _tileRatio,
+						  prefix, _hillShading, _layer & Raster,
+						  _layer & Vector));
+					}
 				}
 			}
 		}
@@ -304,7 +339,7 @@ void IMGMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				const RasterTile &mt = tiles.at(i);
 				const QPixmap &pm = mt.pixmap();
 				painter->drawPixmap(mt.xy(), pm);
-				QPixmapCache::insert(mt.key(), pm);
+				MetaTile::cache(mt.key(), mt.xy(), TILE_SIZE, pm);
 			}
 		} else
 			runJob(new IMGJob(tiles));
@@ -327,6 +362,18 @@ double IMGMap::elevation(const Coordinates &c)
 		return Map::elevation(c);
 }
 
+QVector<double> IMGMap::elevations(const QVector<Coordinates> &c)
+{
+	MapData *d = _data.first();
+
+	if (d->hasDEM()) {
+		QVector<double> ele(c.size(), NAN);
+		DEMTree::elevations(d, c, ele);
+		return ele;
+	} else
+		return Map::elevations(c);
+}
+
 QStringList IMGMap::styles(int &defaultStyle) const
 {
 	QStringList list;
@@ -7,6 +7,7 @@
 #include "transform.h"
 
 class IMGJob;
+class TileFallback;
 namespace IMG {class Style;}
 
 class IMGMap : public Map
@@ -40,6 +41,7 @@ public:
 	void unload();
 
 	double elevation(const Coordinates &c);
+	QVector<double> elevations(const QVector<Coordinates> &c);
 
 	QStringList styles(int &defaultStyle) const;
 	QStringList layers(const QString &lang, int &defaultLayer) const;
@@ -71,10 +73,11 @@ private:
 
 	Transform transform(int zoom) const;
 	void updateTransform();
-	bool isRunning(const QString &key) const;
+	bool isRunning(const QString &prefix, const QPoint &xy) const;
 	void runJob(IMGJob *job);
 	void removeJob(IMGJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback(const IMG::MapData *data) const;
 
 	QList<IMG::MapData*> overlays(const QString &fileName);
 	IMG::Style *createStyle(IMG::MapData *data, const QString *typFile);
@@ -83,10 +86,10 @@ private:
 
 	QList<IMG::MapData*> _data;
 	QList<IMG::Style*> _styles;
+	QMutex _lock, _demLock;
 	IMG::MapData::PolyCache _polyCache;
 	IMG::MapData::PointCache _pointCache;
 	IMG::MapData::ElevationCache _demCache;
-	QMutex _lock, _demLock;
 	int _zoom;
 	Projection _projection;
 	Transform _transform;
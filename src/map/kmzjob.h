@@ -0,0 +1,43 @@
+#ifndef KMZJOB_H
+#define KMZJOB_H
+
+#include <QtConcurrent>
+#include "kmzpyramid.h"
+
+class KMZJob : public QObject
+{
+	Q_OBJECT
+
+public:
+	KMZJob(const QList<KMZPyramid> &pyramids) : _pyramids(pyramids) {}
+
+	void run()
+	{
+		connect(&_watcher, &QFutureWatcher<void>::finished, this,
+		  &KMZJob::handleFinished);
+		_future = QtConcurrent::map(_pyramids, &KMZPyramid::load);
+		_watcher.setFuture(_future);
+	}
+	void cancel(bool wait)
+	{
+		_future.cancel();
+		if (wait)
+			_future.waitForFinished();
+	}
+	void wait() {_future.waitForFinished();}
+	bool isCanceled() const {return _future.isCanceled();}
+	const QList<KMZPyramid> &pyramids() const {return _pyramids;}
+
+signals:
+	void finished(KMZJob *job);
+
+private slots:
+	void handleFinished() {emit finished(this);}
+
+private:
+	QFutureWatcher<void> _watcher;
+	QFuture<void> _future;
+	QList<KMZPyramid> _pyramids;
+};
+
+#endif // KMZJOB_H
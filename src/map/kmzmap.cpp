@@ -11,13 +11,19 @@
 	effort The Qt Company is willing to make about anything desktop related...
 */
 
+#include <cmath>
 #include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
 #include <QXmlStreamReader>
 #include <QBuffer>
 #include <QImageReader>
 #include <QPainter>
 #include <QPixmapCache>
 #include <private/qzipreader_p.h>
+#include "common/programpaths.h"
+#include "kmzjob.h"
 #include "kmzmap.h"
 
 
@@ -26,6 +32,8 @@
 #define TL(m) ((m).bbox().topLeft())
 #define BR(m) ((m).bbox().bottomRight())
 
+bool KMZMap::_diskCache = false;
+
 bool KMZMap::resCmp(const Tile &m1, const Tile &m2)
 {
 	return m1.resolution() > m2.resolution();
@@ -274,7 +282,7 @@ void KMZMap::kml(QXmlStreamReader &reader, QList<Overlay> &overlays)
 
 
 KMZMap::KMZMap(const QString &fileName, QObject *parent)
-  : Map(fileName, parent), _zoom(0), _mapIndex(-1), _zip(0), _mapRatio(1.0),
+  : Map(fileName, parent), _zoom(0), _mapIndex(-1), _mapRatio(1.0),
   _valid(false)
 {
 	QZipReader zip(fileName, QIODevice::ReadOnly);
@@ -299,12 +307,21 @@ KMZMap::KMZMap(const QString &fileName, QObject *parent)
 	computeLLBounds();
 	computeZooms();
 
+	/* The disk cache is bound to the file content (size & timestamp) */
+	QFileInfo fi(fileName);
+	QByteArray id(fi.absoluteFilePath().toUtf8() + "@"
+	  + QByteArray::number(fi.size()) + "@"
+	  + QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+	_cacheDir = QDir(ProgramPaths::tilesDir()).filePath("KMZ/"
+	  + QCryptographicHash::hash(id, QCryptographicHash::Sha1).toHex());
+
 	_valid = true;
 }
 
 KMZMap::~KMZMap()
 {
-	delete _zip;
+	cancelJobs(true);
+	qDeleteAll(_jobs);
 }
 
 QRectF KMZMap::bounds()
@@ -414,15 +431,13 @@ Coordinates KMZMap::xy2ll(const QPointF &p)
 
 void KMZMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
-	Q_UNUSED(flags);
-
 	QRectF er = rect.adjusted(-_adjust * _mapRatio, -_adjust * _mapRatio,
 	  _adjust * _mapRatio, _adjust * _mapRatio);
 
 	for (int i = _zooms.at(_zoom).first; i <= _zooms.at(_zoom).last; i++) {
 		QRectF ir = er.intersected(_bounds.at(i).xy);
-		if (!ir.isNull())
-			draw(painter, ir, i);
+		if (!ir.isNull() && !_errors.contains(i))
+			draw(painter, ir, i, flags);
 	}
 }
 
@@ -442,42 +457,267 @@ void KMZMap::load(const Projection &in, const Projection &out,
 
 	computeBounds();
 
-	Q_ASSERT(!_zip);
-	_zip = new QZipReader(path(), QIODevice::ReadOnly);
+	if (_diskCache && !_cacheDir.isEmpty() && !QDir().mkpath(_cacheDir)) {
+		qWarning("%s: %s", qUtf8Printable(_cacheDir),
+		  "Error creating tiles cache directory");
+		_cacheDir.clear();
+	}
 }
 
 void KMZMap::unload()
 {
+	cancelJobs(true);
+
 	_bounds = QVector<Bounds>();
+}
+
+void KMZMap::clearCache()
+{
+	cancelJobs(true);
+
+	if (!_cacheDir.isEmpty()) {
+		QDir dir(_cacheDir);
+		QStringList list(dir.entryList(QDir::Files));
+		for (int i = 0; i < list.size(); i++)
+			dir.remove(list.at(i));
+	}
+
+	_errors.clear();
+	QPixmapCache::clear();
+}
+
+QString KMZMap::key(int mapIndex, int level, const QPoint &xy) const
+{
+	return path() + "/" + _tiles.at(mapIndex).path() + "-"
+	  + QString::number(level) + "_" + QString::number(xy.x()) + "_"
+	  + QString::number(xy.y());
+}
+
+bool KMZMap::isRunning(int mapIndex) const
+{
+	for (int i = 0; i < _jobs.size(); i++) {
+		const QList<KMZPyramid> &pyramids = _jobs.at(i)->pyramids();
+		for (int j = 0; j < pyramids.size(); j++)
+			if (pyramids.at(j).index() == mapIndex)
+				return true;
+	}
+
+	return false;
+}
+
+void KMZMap::runJob(KMZJob *job)
+{
+	_jobs.append(job);
+
+	connect(job, &KMZJob::finished, this, &KMZMap::jobFinished);
+	job->run();
+}
+
+void KMZMap::removeJob(KMZJob *job)
+{
+	_jobs.removeOne(job);
+	job->deleteLater();
+}
+
+void KMZMap::jobFinished(KMZJob *job)
+{
+	const QList<KMZPyramid> &pyramids = job->pyramids();
+
+	/* Pyramids of cancelled jobs may not have been loaded at all */
+	if (job->isCanceled()) {
+		removeJob(job);
+		return;
+	}
+
+	for (int i = 0; i < pyramids.size(); i++)
+		cacheTiles(pyramids.at(i));
+
+	removeJob(job);
+
+	emit tilesLoaded();
+}
+
+void KMZMap::cancelJobs(bool wait)
+{
+	for (int i = 0; i < _jobs.size(); i++)
+		_jobs.at(i)->cancel(wait);
+}
+
+void KMZMap::waitForJobs(int mapIndex)
+{
+	for (int i = 0; i < _jobs.size(); i++) {
+		KMZJob *job = _jobs.at(i);
+		const QList<KMZPyramid> &pyramids = job->pyramids();
+
+		for (int j = 0; j < pyramids.size(); j++) {
+			if (pyramids.at(j).index() != mapIndex)
+				continue;
+
+			job->wait();
+			if (!job->isCanceled())
+				cacheTiles(pyramids.at(j));
+		}
+	}
+}
+
+void KMZMap::cacheTiles(const KMZPyramid &pyramid)
+{
+	/* Do not try to decode broken images over and over again */
+	if (!pyramid.isValid()) {
+		_errors.insert(pyramid.index());
+		return;
+	}
+
+	for (int i = 0; i < pyramid.tiles().size(); i++)
+		QPixmapCache::insert(key(pyramid.index(), pyramid.level(),
+		  pyramid.tiles().at(i)), QPixmap::fromImage(pyramid.images().at(i)));
+}
+
+int KMZMap::level(QPainter *painter, const Tile &map) const
+{
+	/* The overlay image is drawn into a rect of size/_mapRatio, the painter
+	   transform (digital zoom, print/export scaling) maps the rect to the
+	   output device */
+	const QTransform &t = painter->transform();
+	qreal dpr = painter->device()->devicePixelRatioF();
+	QSizeF is(map.size());
+	QLineF w(t.map(QLineF(0, 0, is.width() / _mapRatio, 0)));
+	QLineF h(t.map(QLineF(0, 0, 0, is.height() / _mapRatio)));
+	/* image pixels per output device pixel, the finer of both axes */
+	qreal ipp = qMin(is.width() / (w.length() * dpr),
+	  is.height() / (h.length() * dpr));
+	int level = (ipp > 1.0) ? (int)floor(log2(ipp)) : 0;
+
+	return qMin(level, KMZPyramid::levels(map.size()) - 1);
+}
+
+QPointF KMZMap::levelFactor(const Tile &map, int level) const
+{
+	QSize ls(KMZPyramid::levelSize(map.size(), level));
+	return QPointF((qreal)map.size().width() / ls.width(),
+	  (qreal)map.size().height() / ls.height());
+}
 
-	delete _zip;
-	_zip = 0;
+void KMZMap::drawTile(QPainter *painter, const Tile &map, int level,
+  const QPoint &xy, const QPixmap &pm)
+{
+	QPointF f(levelFactor(map, level));
+	int ts = KMZPyramid::tileSize();
+	QRectF tr(QPointF(xy.x() * ts * f.x(), xy.y() * ts * f.y()),
+	  QSizeF(pm.width() * f.x(), pm.height() * f.y()));
+
+	painter->drawPixmap(QRectF(tr.topLeft() / _mapRatio,
+	  tr.size() / _mapRatio), pm, QRectF(pm.rect()));
+}
+
+bool KMZMap::drawFallback(QPainter *painter, int mapIndex, int level,
+  const QPoint &xy)
+{
+	const Tile &map = _tiles.at(mapIndex);
+	int ts = KMZPyramid::tileSize();
+	int levels = KMZPyramid::levels(map.size());
+	QPointF f(levelFactor(map, level));
+	QRectF tr(QRectF(xy.x() * ts * f.x(), xy.y() * ts * f.y(), ts * f.x(),
+	  ts * f.y()).intersected(QRectF(QPointF(0, 0), map.size())));
+
+	/* Draw the part of the nearest cached lower resolution tile */
+	for (int l = level + 1; l < levels; l++) {
+		QPoint axy(xy.x() >> (l - level), xy.y() >> (l - level));
+		QPixmap pm;
+
+		if (QPixmapCache::find(key(mapIndex, l, axy), &pm)) {
+			QPointF af(levelFactor(map, l));
+			QPointF ao(axy.x() * ts * af.x(), axy.y() * ts * af.y());
+			QRectF sr(QPointF((tr.left() - ao.x()) / af.x(),
+			  (tr.top() - ao.y()) / af.y()), QSizeF(tr.width() / af.x(),
+			  tr.height() / af.y()));
+
+			painter->drawPixmap(QRectF(tr.topLeft() / _mapRatio,
+			  tr.size() / _mapRatio), pm, sr);
+			return true;
+		}
+	}
+
+	return false;
 }
 
-void KMZMap::draw(QPainter *painter, const QRectF &rect, int mapIndex)
+void KMZMap::draw(QPainter *painter, const QRectF &rect, int mapIndex,
+  Flags flags)
 {
 	const Tile &map = _tiles.at(mapIndex);
 	const QPointF offset = _bounds.at(mapIndex).xy.topLeft();
 	QRectF pr = QRectF(rect.topLeft() - offset, rect.size());
-	QRectF sr(pr.topLeft() * _mapRatio, pr.size() * _mapRatio);
-	QString key(path() + "/" + map.path());
-	QPixmap pm;
+	int ts = KMZPyramid::tileSize();
+	QList<QPoint> missing;
 
 	painter->save();
 	painter->translate(offset);
-	if (map.rotation())
+	if (map.rotation()) {
 		painter->rotate(-map.rotation());
+		QTransform t;
+		t.rotate(map.rotation());
+		pr = t.mapRect(pr);
+	}
 
-	if (QPixmapCache::find(key, &pm)) {
-		pm.setDevicePixelRatio(_mapRatio);
-		painter->drawPixmap(pr.topLeft(), pm, sr);
-	} else {
-		QByteArray ba(_zip->fileData(map.path()));
-		QImage img(QImage::fromData(ba));
-		pm = QPixmap::fromImage(img);
-		pm.setDevicePixelRatio(_mapRatio);
-		painter->drawPixmap(pr.topLeft(), pm, sr);
-		QPixmapCache::insert(key, pm);
+	/* The overlay is drawn from the pyramid level matching the output
+	   resolution, so zooming out does not require the full image */
+	int l = level(painter, map);
+	QPointF f(levelFactor(map, l));
+	QSize ls(KMZPyramid::levelSize(map.size(), l));
+	QRectF lr(pr.left() * _mapRatio / f.x(), pr.top() * _mapRatio / f.y(),
+	  pr.width() * _mapRatio / f.x(), pr.height() * _mapRatio / f.y());
+	int left = qMax(0, (int)floor(lr.left() / ts));
+	int top = qMax(0, (int)floor(lr.top() / ts));
+	int right = qMin((ls.width() - 1) / ts, (int)floor(lr.right() / ts));
+	int bottom = qMin((ls.height() - 1) / ts, (int)floor(lr.bottom() / ts));
+
+	for (int y = top; y <= bottom; y++) {
+		for (int x = left; x <= right; x++) {
+			QPoint xy(x, y);
+			QPixmap pm;
+
+			if (QPixmapCache::find(key(mapIndex, l, xy), &pm))
+				drawTile(painter, map, l, xy, pm);
+			else {
+				if (!(flags & Map::Block))
+					drawFallback(painter, mapIndex, l, xy);
+				missing.append(xy);
+			}
+		}
+	}
+
+	if (!missing.isEmpty() && (flags & Map::Block)) {
+		/* A running job of the image may be writing the same tile files and
+		   may already have the tiles */
+		waitForJobs(mapIndex);
+
+		QList<QPoint> left;
+		for (int i = 0; i < missing.size(); i++) {
+			QPixmap pm;
+			if (QPixmapCache::find(key(mapIndex, l, missing.at(i)), &pm))
+				drawTile(painter, map, l, missing.at(i), pm);
+			else
+				left.append(missing.at(i));
+		}
+		missing = left;
+	}
+
+	if (!missing.isEmpty()) {
+		KMZPyramid pyramid(path(), map.path(), _diskCache ? _cacheDir
+		  : QString(), mapIndex, l, missing);
+
+		if (flags & Map::Block) {
+			pyramid.load();
+			if (pyramid.isValid()) {
+				for (int i = 0; i < missing.size(); i++) {
+					QPixmap pm(QPixmap::fromImage(pyramid.images().at(i)));
+					QPixmapCache::insert(key(mapIndex, l, missing.at(i)), pm);
+					drawTile(painter, map, l, missing.at(i), pm);
+				}
+			} else
+				_errors.insert(mapIndex);
+		} else if (!isRunning(mapIndex))
+			runJob(new KMZJob(QList<KMZPyramid>() << pyramid));
 	}
 
 	//painter->setPen(Qt::red);
@@ -486,6 +726,11 @@ void KMZMap::draw(QPainter *painter, const QRectF &rect, int mapIndex)
 	painter->restore();
 }
 
+void KMZMap::clearDiskCache()
+{
+	QDir(QDir(ProgramPaths::tilesDir()).filePath("KMZ")).removeRecursively();
+}
+
 Map *KMZMap::create(const QString &path, const Projection &proj, bool *isDir)
 {
 	Q_UNUSED(proj);
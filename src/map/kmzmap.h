@@ -2,12 +2,15 @@
 #define KMZMAP_H
 
 #include <QImage>
+#include <QSet>
 #include "projection.h"
 #include "transform.h"
 #include "map.h"
 
 class QXmlStreamReader;
 class QZipReader;
+class KMZJob;
+class KMZPyramid;
 
 class KMZMap : public Map
 {
@@ -38,8 +41,16 @@ public:
 	bool isValid() const {return _valid;}
 	QString errorString() const {return _errorString;}
 
+	void clearCache();
+
 	static Map *create(const QString &path, const Projection &proj, bool *isDir);
 
+	static void useDiskCache(bool use) {_diskCache = use;}
+	static void clearDiskCache();
+
+private slots:
+	void jobFinished(KMZJob *job);
+
 private:
 	class Overlay {
 	public:
@@ -64,6 +75,7 @@ private:
 		  {return _overlay.path() == other._overlay.path();}
 
 		bool isValid() const {return _size.isValid();}
+		const QSize &size() const {return _size;}
 		const QString &path() const {return _overlay.path();}
 		qreal rotation() const {return _overlay.rotation();}
 		const RectC &bbox() const {return _overlay.bbox();}
@@ -103,7 +115,21 @@ private:
 	QString icon(QXmlStreamReader &reader);
 	double number(QXmlStreamReader &reader);
 
-	void draw(QPainter *painter, const QRectF &rect, int mapIndex);
+	void draw(QPainter *painter, const QRectF &rect, int mapIndex,
+	  Flags flags);
+	int level(QPainter *painter, const Tile &map) const;
+	QPointF levelFactor(const Tile &map, int level) const;
+	void drawTile(QPainter *painter, const Tile &map, int level,
+	  const QPoint &xy, const QPixmap &pm);
+	bool drawFallback(QPainter *painter, int mapIndex, int level,
+	  const QPoint &xy);
+	QString key(int mapIndex, int level, const QPoint &xy) const;
+	bool isRunning(int mapIndex) const;
+	void runJob(KMZJob *job);
+	void removeJob(KMZJob *job);
+	void cancelJobs(bool wait);
+	void waitForJobs(int mapIndex);
+	void cacheTiles(const KMZPyramid &pyramid);
 
 	bool createTiles(const QList<Overlay> &overlays, QZipReader &zip);
 	void computeZooms();
@@ -125,13 +151,17 @@ private:
 	QVector<Bounds> _bounds;
 	int _zoom;
 	int _mapIndex;
-	QZipReader *_zip;
+	QString _cacheDir;
+	QList<KMZJob*> _jobs;
+	QSet<int> _errors;
 	qreal _adjust;
 	Projection _projection;
 	qreal _mapRatio;
 
 	bool _valid;
 	QString _errorString;
+
+	static bool _diskCache;
 };
 
 #endif // KMZMAP_H
@@ -0,0 +1,124 @@
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <private/qzipreader_p.h>
+#include "kmzpyramid.h"
+
+#define TILE_SIZE 256
+
+int KMZPyramid::tileSize()
+{
+	return TILE_SIZE;
+}
+
+int KMZPyramid::levels(const QSize &size)
+{
+	int max = qMax(size.width(), size.height());
+	int levels = 1;
+
+	while ((max >> (levels - 1)) > TILE_SIZE)
+		levels++;
+
+	return levels;
+}
+
+QSize KMZPyramid::levelSize(const QSize &size, int level)
+{
+	return QSize(qMax(1, size.width() >> level),
+	  qMax(1, size.height() >> level));
+}
+
+QString KMZPyramid::tileFile(int level, const QPoint &xy) const
+{
+	return QDir(_dir).filePath(QString::number(_index) + "-"
+	  + QString::number(level) + "_" + QString::number(xy.x()) + "_"
+	  + QString::number(xy.y()));
+}
+
+bool KMZPyramid::loadCached()
+{
+	for (int i = 0; i < _tiles.size(); i++) {
+		QString file(tileFile(_level, _tiles.at(i)));
+		if (!QFile::exists(file))
+			break;
+
+		QImage img(file);
+		if (img.isNull())
+			break;
+		_images.append(img);
+	}
+
+	if (_images.size() == _tiles.size())
+		return true;
+
+	_images.clear();
+	return false;
+}
+
+/* The tiles are stored losslessly, so the cached tiles look the same as the
+   decoded ones. QSaveFile makes the tiles appear atomically for the readers
+   (and other writers) of the same tiles. */
+void KMZPyramid::save(const QImage &tile, const QString &path)
+{
+	QSaveFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly) || !tile.save(&file, "PNG"))
+		return;
+	file.commit();
+}
+
+void KMZPyramid::create()
+{
+	QZipReader zip(_zip, QIODevice::ReadOnly);
+	QImage img(QImage::fromData(zip.fileData(_image)));
+	if (img.isNull())
+		return;
+
+	QSize size(img.size());
+	int count = levels(size);
+
+	/* The disk cache may have been enabled after the map has been loaded */
+	if (!_dir.isEmpty() && !QDir().mkpath(_dir))
+		_dir.clear();
+
+	for (int i = 0; i < _tiles.size(); i++)
+		_images.append(QImage());
+
+	for (int l = 0; l < count; l++) {
+		/* Without the disk cache, only the requested level is needed */
+		if (_dir.isEmpty() && l > _level)
+			break;
+		if (l)
+			img = img.scaled(levelSize(size, l), Qt::IgnoreAspectRatio,
+			  Qt::SmoothTransformation);
+		if (_dir.isEmpty() && l < _level)
+			continue;
+
+		for (int y = 0; y * TILE_SIZE < img.height(); y++) {
+			for (int x = 0; x * TILE_SIZE < img.width(); x++) {
+				QPoint xy(x, y);
+				QImage tile(img.copy(QRect(x * TILE_SIZE, y * TILE_SIZE,
+				  TILE_SIZE, TILE_SIZE).intersected(img.rect())));
+
+				if (l == _level) {
+					int idx = _tiles.indexOf(xy);
+					if (idx >= 0)
+						_images[idx] = tile;
+				}
+				if (!_dir.isEmpty())
+					save(tile, tileFile(l, xy));
+			}
+		}
+	}
+}
+
+void KMZPyramid::load()
+{
+	if (!_dir.isEmpty() && loadCached()) {
+		_valid = true;
+		return;
+	}
+
+	create();
+	_valid = !_images.isEmpty();
+}
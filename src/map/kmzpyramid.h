@@ -0,0 +1,53 @@
+#ifndef KMZPYRAMID_H
+#define KMZPYRAMID_H
+
+#include <QList>
+#include <QPoint>
+#include <QImage>
+
+/*
+  Tiled pyramid of a KMZ overlay image. Level 0 is the full resolution
+  image, every next level has half the size of the previous one. The
+  requested tiles of a single level are loaded from the disk cache if all
+  of them are available, otherwise the image is decoded from the KMZ file
+  and the whole pyramid is (re)created in the disk cache.
+*/
+class KMZPyramid
+{
+public:
+	KMZPyramid() : _index(-1), _level(0), _valid(false) {}
+	KMZPyramid(const QString &zip, const QString &image, const QString &dir,
+	  int index, int level, const QList<QPoint> &tiles)
+	  : _zip(zip), _image(image), _dir(dir), _index(index), _level(level),
+	  _tiles(tiles), _valid(false) {}
+
+	int index() const {return _index;}
+	int level() const {return _level;}
+	const QList<QPoint> &tiles() const {return _tiles;}
+	const QList<QImage> &images() const {return _images;}
+	bool isValid() const {return _valid;}
+
+	void load();
+
+	static int levels(const QSize &size);
+	static QSize levelSize(const QSize &size, int level);
+	static int tileSize();
+
+private:
+	QString tileFile(int level, const QPoint &xy) const;
+	bool loadCached();
+	void create();
+
+	static void save(const QImage &tile, const QString &path);
+
+	QString _zip;
+	QString _image;
+	QString _dir;
+	int _index;
+	int _level;
+	QList<QPoint> _tiles;
+	QList<QImage> _images;
+	bool _valid;
+};
+
+#endif // KMZPYRAMID_H
@@ -58,6 +58,8 @@ public:
 	virtual void draw(QPainter *painter, const QRectF &rect, Flags flags) = 0;
 
 	virtual double elevation(const Coordinates &c) {return DEM::elevation(c);}
+	virtual QVector<double> elevations(const QVector<Coordinates> &c)
+	  {return DEM::elevation(c);}
 
 	virtual QStringList layers(const QString &, int &) const
 	  {return QStringList();}
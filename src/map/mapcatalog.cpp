@@ -0,0 +1,266 @@
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+#include <QtConcurrent>
+#include "maplist.h"
+#include "catalogmap.h"
+#include "mapcatalog.h"
+
+#define MAGIC   0x4D435447 /* "MCTG" */
+#define VERSION 1
+
+#define IS_DIR 1
+#define VALID  2
+#define READY  4
+
+MapCatalog::Probe::Probe(const QFileInfo &fi, const Projection *proj)
+  : _path(fi.absoluteFilePath()), _proj(proj)
+{
+	_entry.size = fi.size();
+	_entry.time = fi.lastModified().toMSecsSinceEpoch();
+}
+
+void MapCatalog::Probe::process()
+{
+	Map *map = MapList::loadFile(_path, *_proj, &_entry.isDir, &_entry.parser);
+
+	_entry.valid = map->isValid();
+	_entry.ready = map->isReady();
+	if (_entry.valid) {
+		_entry.name = map->name();
+		_entry.bounds = map->llBounds();
+	}
+
+	delete map;
+}
+
+const MapCatalog::Entry *MapCatalog::entry(const QFileInfo &fi)
+{
+	QString path(fi.absoluteFilePath());
+	QHash<QString, Entry>::const_iterator it(_entries.constFind(path));
+
+	if (it == _entries.constEnd() || it->size != fi.size()
+	  || it->time != fi.lastModified().toMSecsSinceEpoch())
+		return 0;
+
+	_used.insert(path);
+	return &(*it);
+}
+
+void MapCatalog::update(const QString &path, const Projection &proj)
+{
+	QStringList dirs(path);
+
+	/* The tree is probed level by level as a map representing the whole
+	   directory (isDir) hides the subdirectories and we must know about it
+	   before going deeper. */
+	while (!dirs.isEmpty()) {
+		QList<QFileInfoList> files;
+		QList<QStringList> subdirs;
+		QList<Probe> probes, local;
+
+		for (int i = 0; i < dirs.size(); i++) {
+			QDir md(dirs.at(i));
+			md.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+			md.setSorting(QDir::DirsLast);
+			QFileInfoList ml = md.entryInfoList();
+			QFileInfoList mf;
+			QStringList sd;
+
+			for (int j = 0; j < ml.size(); j++) {
+				const QFileInfo &fi = ml.at(j);
+
+				if (fi.isDir())
+					sd.append(fi.absoluteFilePath());
+				else if (_filter.contains("*." + fi.suffix().toLower())) {
+					const Entry *e = entry(fi);
+					if (!e) {
+						mf.append(fi);
+						/* Online map sources create network objects that
+						   must not be created in the worker threads */
+						if (fi.suffix().toLower() == "xml")
+							local.append(Probe(fi, &proj));
+						else
+							probes.append(Probe(fi, &proj));
+					} else if (e->isDir)
+						break;
+				}
+			}
+
+			files.append(mf);
+			subdirs.append(sd);
+		}
+
+		QFuture<void> future = QtConcurrent::map(probes, &Probe::process);
+		for (int i = 0; i < local.size(); i++)
+			local[i].process();
+		future.waitForFinished();
+
+		probes.append(local);
+		for (int i = 0; i < probes.size(); i++) {
+			const Probe &p = probes.at(i);
+			_entries.insert(p.path(), p.entry());
+			_used.insert(p.path());
+			_changed = true;
+		}
+
+		dirs.clear();
+		for (int i = 0; i < files.size(); i++) {
+			const QFileInfoList &mf = files.at(i);
+			bool isDir = false;
+
+			for (int j = 0; j < mf.size(); j++) {
+				const Entry *e = entry(mf.at(j));
+				if (e && e->isDir) {
+					isDir = true;
+					break;
+				}
+			}
+			if (!isDir)
+				dirs.append(subdirs.at(i));
+		}
+	}
+}
+
+Map *MapCatalog::loadFile(const QFileInfo &fi, const Projection &proj,
+  bool *isDir)
+{
+	const Entry *e = entry(fi);
+
+	if (!e)
+		return MapList::loadFile(fi.absoluteFilePath(), proj, isDir);
+
+	*isDir = e->isDir;
+	if (!e->valid)
+		return 0;
+	else if (!e->ready)
+		return MapList::createMap(fi.absoluteFilePath(), proj, e->parser);
+	else
+		return new CatalogMap(fi.absoluteFilePath(), proj, e->parser, e->name,
+		  e->bounds);
+}
+
+TreeNode<Map*> MapCatalog::loadDir(const QString &path, const Projection &proj,
+  TreeNode<Map*> *parent)
+{
+	QDir md(path);
+	md.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+	md.setSorting(QDir::DirsLast);
+	QFileInfoList ml = md.entryInfoList();
+#ifdef Q_OS_ANDROID
+	TreeNode<Map*> tree(Util::displayName(path));
+#else // Q_OS_ANDROID
+	TreeNode<Map*> tree(md.dirName());
+#endif // Q_OS_ANDROID
+
+	for (int i = 0; i < ml.size(); i++) {
+		const QFileInfo &fi = ml.at(i);
+		QString suffix = fi.suffix().toLower();
+
+		if (fi.isDir()) {
+			TreeNode<Map*> child(loadDir(fi.absoluteFilePath(), proj, &tree));
+			if (!child.isEmpty())
+				tree.addChild(child);
+		} else if (_filter.contains("*." + suffix)) {
+			bool isDir = false;
+			Map *map = loadFile(fi, proj, &isDir);
+			if (isDir) {
+				if (map) {
+					if (parent)
+						parent->addItem(map);
+					else
+						tree.addItem(map);
+				}
+				break;
+			} else if (map)
+				tree.addItem(map);
+		}
+	}
+
+	return tree;
+}
+
+TreeNode<Map*> MapCatalog::loadMaps(const QString &path,
+  const Projection &proj)
+{
+	if (!QFileInfo(path).isDir())
+		return MapList::loadMaps(path, proj);
+
+	_filter = MapList::filter();
+
+	load();
+	update(path, proj);
+	TreeNode<Map*> tree(loadDir(path, proj));
+	if (_changed || _used.size() != _entries.size())
+		save();
+
+	return tree;
+}
+
+bool MapCatalog::load()
+{
+	QFile file(_file);
+	quint32 magic, version, count;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream >> magic >> version >> count;
+	if (stream.status() != QDataStream::Ok || magic != MAGIC
+	  || version != VERSION)
+		return false;
+
+	for (quint32 i = 0; i < count; i++) {
+		QString path;
+		Entry e;
+		double left, top, right, bottom;
+		quint8 flags;
+
+		stream >> path >> e.size >> e.time >> e.parser >> e.name >> left >> top
+		  >> right >> bottom >> flags;
+		if (stream.status() != QDataStream::Ok) {
+			_entries.clear();
+			return false;
+		}
+
+		e.bounds = RectC(Coordinates(left, top), Coordinates(right, bottom));
+		e.isDir = flags & IS_DIR;
+		e.valid = flags & VALID;
+		e.ready = flags & READY;
+
+		_entries.insert(path, e);
+	}
+
+	return true;
+}
+
+bool MapCatalog::save()
+{
+	QDir().mkpath(QFileInfo(_file).absolutePath());
+	QFile file(_file);
+
+	if (!file.open(QIODevice::WriteOnly)) {
+		qWarning("%s: %s", qUtf8Printable(_file),
+		  qUtf8Printable(file.errorString()));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << (quint32)MAGIC << (quint32)VERSION << (quint32)_used.size();
+
+	for (QSet<QString>::const_iterator it = _used.constBegin();
+	  it != _used.constEnd(); ++it) {
+		const Entry &e = _entries[*it];
+		quint8 flags = (e.isDir ? IS_DIR : 0) | (e.valid ? VALID : 0)
+		  | (e.ready ? READY : 0);
+
+		stream << *it << e.size << e.time << e.parser << e.name
+		  << e.bounds.left() << e.bounds.top() << e.bounds.right()
+		  << e.bounds.bottom() << flags;
+	}
+
+	return (stream.status() == QDataStream::Ok);
+}
@@ -0,0 +1,76 @@
+#ifndef MAPCATALOG_H
+#define MAPCATALOG_H
+
+#include <QHash>
+#include <QSet>
+#include <QFileInfo>
+#include "common/rectc.h"
+#include "common/treenode.h"
+
+class Map;
+class Projection;
+
+/*
+  Persistent catalog of the maps in the maps directory. The catalog stores the
+  results of the map files probing (name, format and bounds) keyed by the file
+  path, size and modification time, so the maps tree can be created without
+  opening the map files. New or changed files are probed in parallel and the
+  catalog maps are only created (using CatalogMap) when they are used.
+*/
+class MapCatalog
+{
+public:
+	MapCatalog(const QString &file) : _file(file), _changed(false) {}
+
+	TreeNode<Map*> loadMaps(const QString &path, const Projection &proj);
+
+private:
+	struct Entry
+	{
+		Entry() : size(-1), time(0), isDir(false), valid(false),
+		  ready(false) {}
+
+		qint64 size;
+		qint64 time;
+		QString parser;
+		QString name;
+		RectC bounds;
+		bool isDir;
+		bool valid;
+		bool ready;
+	};
+
+	class Probe
+	{
+	public:
+		Probe() : _proj(0) {}
+		Probe(const QFileInfo &fi, const Projection *proj);
+
+		const QString &path() const {return _path;}
+		const Entry &entry() const {return _entry;}
+
+		void process();
+
+	private:
+		QString _path;
+		const Projection *_proj;
+		Entry _entry;
+	};
+
+	const Entry *entry(const QFileInfo &fi);
+	void update(const QString &path, const Projection &proj);
+	TreeNode<Map*> loadDir(const QString &path, const Projection &proj,
+	  TreeNode<Map*> *parent = 0);
+	Map *loadFile(const QFileInfo &fi, const Projection &proj, bool *isDir);
+
+	bool load();
+	bool save();
+
+	QString _file;
+	QStringList _filter;
+	QHash<QString, Entry> _entries;
+	QSet<QString> _used;
+	bool _changed;
+};
+
+#endif // MAPCATALOG_H
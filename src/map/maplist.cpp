@@ -73,7 +73,8 @@ MapList::ParserMap MapList::parsers()
 
 MapList::ParserMap MapList::_parsers = MapList::parsers();
 
-Map *MapList::loadFile(const QString &path, const Projection &proj, bool *isDir)
+Map *MapList::loadFile(const QString &path, const Projection &proj, bool *isDir,
+  QString *parser)
 {
 	ParserMap::iterator it;
 	QFileInfo fi(Util::displayName(path));
@@ -85,9 +86,11 @@ Map *MapList::loadFile(const QString &path, const Projection &proj, bool *isDir)
 			const Parser &p = it.value();
 
 			Map *map = p.cb(path, proj, isDir);
-			if (map->isValid())
+			if (map->isValid()) {
+				if (parser)
+					*parser = p.name;
 				return map;
-			else {
+			} else {
 				errors.append(QPair<const char*, QString>(p.name,
 				  map->errorString()));
 				delete map;
@@ -111,9 +114,11 @@ Map *MapList::loadFile(const QString &path, const Projection &proj, bool *isDir)
 			const Parser &p = it.value();
 
 			Map *map = p.cb(path, proj, isDir);
-			if (map->isValid())
+			if (map->isValid()) {
+				if (parser)
+					*parser = p.name;
 				return map;
-			else {
+			} else {
 				errors.append(QPair<const char*, QString>(p.name,
 				  map->errorString()));
 				delete map;
@@ -129,6 +134,31 @@ Map *MapList::loadFile(const QString &path, const Projection &proj, bool *isDir)
 	}
 }
 
+Map *MapList::createMap(const QString &path, const Projection &proj,
+  const QString &parser)
+{
+	ParserMap::iterator it;
+	QFileInfo fi(Util::displayName(path));
+	QString suffix(fi.completeSuffix().toLower());
+
+	for (it = _parsers.find(suffix); it != _parsers.end()
+	  && it.key() == suffix; it++) {
+		const Parser &p = it.value();
+		if (parser == p.name)
+			return p.cb(path, proj, 0);
+	}
+
+	/* The parser may have been found by the unknown suffix fallback of
+	   loadFile(), so it can be any of the parsers */
+	for (it = _parsers.begin(); it != _parsers.end(); it++) {
+		const Parser &p = it.value();
+		if (parser == p.name)
+			return p.cb(path, proj, 0);
+	}
+
+	return new InvalidMap(path, "Unknown file format");
+}
+
 TreeNode<Map*> MapList::loadDir(const QString &path, const Projection &proj,
   TreeNode<Map*> *parent)
 {
@@ -14,7 +14,13 @@ public:
 	static QString formats();
 	static QStringList filter();
 
+	static Map *createMap(const QString &path, const Projection &proj,
+	  const QString &parser);
+
 private:
+	friend class MapCatalog;
+
+
 	typedef Map*(*Cb)(const QString &, const Projection &, bool *);
 
 	struct Parser {
@@ -27,7 +33,7 @@ private:
 	typedef QMultiMap<QString, Parser> ParserMap;
 
 	static Map *loadFile(const QString &path, const Projection &proj,
-	  bool *isDir = 0);
+	  bool *isDir = 0, QString *parser = 0);
 	static TreeNode<Map*> loadDir(const QString &path, const Projection &proj,
 	  TreeNode<Map*> *parent = 0);
 
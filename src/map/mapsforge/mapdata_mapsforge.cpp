@@ -12,6 +12,7 @@ using namespace Mapsforge;
 #define MAGIC "mapsforge binary OSM"
 #define MAGIC_SIZE (sizeof(MAGIC) - 1)
 #define MD(val) ((val) / 1e6)
+#define MD_SCALE 1e6
 #define OFFSET_MASK 0x7FFFFFFFFFL
 
 #define KEY_NAME  "name"
@@ -19,6 +20,54 @@ using namespace Mapsforge;
 #define KEY_REF   "ref"
 #define KEY_ELE   "ele"
 
+static qint64 cost(const MapData::Point &point)
+{
+	qint64 size = point.tags.size() * sizeof(MapData::Tag);
+
+	for (int i = 0; i < point.tags.size(); i++)
+		size += point.tags.at(i).value.size();
+
+	return size;
+}
+
+static qint64 cost(const QList<MapData::Point> *list)
+{
+	qint64 size = sizeof(QList<MapData::Point>)
+	  + list->size() * sizeof(MapData::Point);
+
+	for (int i = 0; i < list->size(); i++)
+		size += cost(list->at(i));
+
+	return size;
+}
+
+static qint64 cost(const QList<MapData::CachedPath> *list)
+{
+	qint64 size = sizeof(QList<MapData::CachedPath>)
+	  + list->size() * sizeof(MapData::CachedPath);
+
+	for (int i = 0; i < list->size(); i++) {
+		const MapData::CachedPath &path = list->at(i);
+		size += cost(path.point);
+		for (int j = 0; j < path.poly.size(); j++)
+			size += sizeof(CompactPath) + path.poly.at(j).cost();
+	}
+
+	return size;
+}
+
+static QList<MapData::CachedPath> *compact(const QList<MapData::Path> *src,
+  const Coordinates &pos)
+{
+	QList<MapData::CachedPath> *dst = new QList<MapData::CachedPath>();
+
+	dst->reserve(src->size());
+	for (int i = 0; i < src->size(); i++)
+		dst->append(MapData::CachedPath(src->at(i), pos));
+
+	return dst;
+}
+
 static void copyPaths(const RectC &rect, const QList<MapData::Path> *src,
   QList<MapData::Path> *dst)
 {
@@ -29,6 +78,16 @@ static void copyPaths(const RectC &rect, const QList<MapData::Path> *src,
 	}
 }
 
+static void copyPaths(const RectC &rect, const Coordinates &pos,
+  const QList<MapData::CachedPath> *src, QList<MapData::Path> *dst)
+{
+	for (int i = 0; i < src->size(); i++) {
+		const MapData::CachedPath &path = src->at(i);
+		if (rect.intersects(path.boundingRect))
+			dst->append(path.path(pos));
+	}
+}
+
 static void copyPoints(const RectC &rect, const QList<MapData::Point> *src,
   QList<MapData::Point> *dst)
 {
@@ -39,11 +98,11 @@ static void copyPoints(const RectC &rect, const QList<MapData::Point> *src,
 	}
 }
 
-static void copyPoints(const RectC &rect, const QList<MapData::Path> *src,
+static void copyPoints(const RectC &rect, const QList<MapData::CachedPath> *src,
   QList<MapData::Point> *dst)
 {
 	for (int i = 0; i < src->size(); i++) {
-		const MapData::Path &path = src->at(i);
+		const MapData::CachedPath &path = src->at(i);
 		if (path.closed && rect.contains(path.point.coordinates))
 			dst->append(path.point);
 	}
@@ -421,7 +480,31 @@ bool MapData::readHeader(QFile &file)
 	return true;
 }
 
-MapData::MapData(const QString &fileName) : _fileName(fileName), _valid(false)
+MapData::CachedPath::CachedPath(const Path &path, const Coordinates &pos)
+  : point(path.point), boundingRect(path.poly.boundingRect()),
+  closed(path.closed)
+{
+	poly.reserve(path.poly.size());
+	for (int i = 0; i < path.poly.size(); i++)
+		poly.append(CompactPath(path.poly.at(i), pos, MD_SCALE));
+}
+
+MapData::Path MapData::CachedPath::path(const Coordinates &pos) const
+{
+	Path p(0);
+
+	p.point = point;
+	p.poly.reserve(poly.size());
+	for (int i = 0; i < poly.size(); i++)
+		p.poly.append(poly.at(i).points(pos, MD_SCALE));
+	p.closed = closed;
+
+	return p;
+}
+
+MapData::MapData(const QString &fileName)
+  : _fileName(fileName), _pathCache("Mapsforge paths", &_pathCacheLock),
+  _pointCache("Mapsforge points", &_pointCacheLock), _valid(false)
 {
 	QFile file(fileName);
 
@@ -433,9 +516,6 @@ MapData::MapData(const QString &fileName) : _fileName(fileName), _valid(false)
 	if (!readHeader(file))
 		return;
 
-	_pathCache.setMaxCost(2048);
-	_pointCache.setMaxCost(2048);
-
 	_valid = true;
 }
 
@@ -469,8 +549,13 @@ void MapData::load()
 
 void MapData::clear()
 {
+	_pathCacheLock.lock();
 	_pathCache.clear();
+	_pathCacheLock.unlock();
+
+	_pointCacheLock.lock();
 	_pointCache.clear();
+	_pointCacheLock.unlock();
 
 	clearTiles();
 }
@@ -545,7 +630,7 @@ void MapData::points(QFile &file, VectorTile *tile, const RectC &rect,
 		if (readPoints(file, tile, zoom, p)) {
 			copyPoints(rect, p, list);
 			_pointCacheLock.lock();
-			_pointCache.insert(key, p);
+			_pointCache.insert(key, p, cost(p));
 			_pointCacheLock.unlock();
 		} else
 			delete p;
@@ -555,17 +640,17 @@ void MapData::points(QFile &file, VectorTile *tile, const RectC &rect,
 	}
 
 	_pathCacheLock.lock();
-	QList<Path> *tilePaths = _pathCache.object(key);
+	QList<CachedPath> *tilePaths = _pathCache.object(key);
 	if (!tilePaths) {
 		_pathCacheLock.unlock();
-		QList<Path> *p = new QList<Path>();
-		if (readPaths(file, tile, zoom, p)) {
-			copyPoints(rect, p, list);
+		QList<Path> p;
+		if (readPaths(file, tile, zoom, &p)) {
+			QList<CachedPath> *c = compact(&p, tile->pos);
+			copyPoints(rect, c, list);
 			_pathCacheLock.lock();
-			_pathCache.insert(key, p);
+			_pathCache.insert(key, c, cost(c));
 			_pathCacheLock.unlock();
-		} else
-			delete p;
+		}
 	} else {
 		copyPoints(rect, tilePaths, list);
 		_pathCacheLock.unlock();
@@ -600,19 +685,19 @@ void MapData::paths(QFile &file, VectorTile *tile, const RectC &rect, int zoom,
 	tile->lock.lock();
 
 	_pathCacheLock.lock();
-	QList<Path> *cached = _pathCache.object(key);
+	QList<CachedPath> *cached = _pathCache.object(key);
 	if (!cached) {
 		_pathCacheLock.unlock();
-		QList<Path> *p = new QList<Path>();
-		if (readPaths(file, tile, zoom, p)) {
-			copyPaths(rect, p, list);
+		QList<Path> p;
+		if (readPaths(file, tile, zoom, &p)) {
+			copyPaths(rect, &p, list);
+			QList<CachedPath> *c = compact(&p, tile->pos);
 			_pathCacheLock.lock();
-			_pathCache.insert(key, p);
+			_pathCache.insert(key, c, cost(c));
 			_pathCacheLock.unlock();
-		} else
-			delete p;
+		}
 	} else {
-		copyPaths(rect, cached, list);
+		copyPaths(rect, tile->pos, cached, list);
 		_pathCacheLock.unlock();
 	}
 
@@ -2,13 +2,14 @@
 #define MAPSFORGE_MAPDATA_H
 
 #include <QFile>
-#include <QCache>
 #include <QMutex>
 #include "common/hash.h"
 #include "common/rectc.h"
 #include "common/rtree.h"
 #include "common/range.h"
 #include "common/polygon.h"
+#include "common/memorycache.h"
+#include "common/compactpath.h"
 
 #define ID_NAME   1
 #define ID_HOUSE  2
@@ -58,6 +59,19 @@ public:
 		  {return point.layer < other.point.layer;}
 	};
 
+	/* Cache form of a path. The polygon points are stored as delta encoded
+	   microdegrees (the map file precision) relative to the tile position. */
+	struct CachedPath {
+		CachedPath(const Path &path, const Coordinates &pos);
+
+		Path path(const Coordinates &pos) const;
+
+		Point point;
+		QVector<CompactPath> poly;
+		RectC boundingRect;
+		bool closed;
+	};
+
 	const QString &fileName() const {return _fileName;}
 	RectC bounds() const;
 	Range zooms() const
@@ -177,9 +191,9 @@ private:
 	QList<TileTree*> _tiles;
 	QHash<QByteArray, unsigned> _keys;
 
-	QCache<Key, QList<Path> > _pathCache;
-	QCache<Key, QList<Point> > _pointCache;
 	QMutex _pathCacheLock, _pointCacheLock;
+	MemoryCache<Key, QList<CachedPath> > _pathCache;
+	MemoryCache<Key, QList<Point> > _pointCache;
 
 	bool _valid;
 	QString _errorString;
@@ -1,6 +1,5 @@
 #include <cmath>
 #include <QPainter>
-#include <QCache>
 #include "map/dem.h"
 #include "map/rectd.h"
 #include "map/hillshading.h"
@@ -197,7 +196,7 @@ void RasterTile::processLineLabels(const QVector<PainterPath> &paths,
 		if (!l.si && l.ti && l.ti->shield()) {
 			if (l.ti && l.lbl && set.contains(*l.lbl))
 				continue;
-			if (l.path->pp.length() < _rect.width() / 3.0)
+			if (l.path->pp.length() < _data->tileSize() / 3.0)
 				continue;
 
 			QPointF pos = l.path->pp.pointAtPercent(0.5);
@@ -290,49 +289,29 @@ void RasterTile::pathInstructions(const QList<MapData::Path> &paths,
   QVector<PainterPath> &painterPaths,
   QVector<RasterTile::RenderInstruction> &instructions) const
 {
-	QCache<PathKey, QList<const Style::PathRender *> > cache(8192);
-	QList<const Style::PathRender*> *ri;
-
 	for (int i = 0; i < paths.size(); i++) {
 		const MapData::Path &path = paths.at(i);
 		PainterPath &rp = painterPaths[i];
-		PathKey key(_zoom, path.closed, path.point.tags);
+		QList<const Style::PathRender*> ri(_style->paths(_zoom, path.closed,
+		  path.point.tags));
 
 		rp.path = &path;
 
-		if (!(ri = cache.object(key))) {
-			ri = new QList<const Style::PathRender*>(_style->paths(_zoom,
-			  path.closed, path.point.tags));
-			for (int j = 0; j < ri->size(); j++)
-				instructions.append(RenderInstruction(ri->at(j), &rp));
-			cache.insert(key, ri);
-		} else {
-			for (int j = 0; j < ri->size(); j++)
-				instructions.append(RenderInstruction(ri->at(j), &rp));
-		}
+		for (int j = 0; j < ri.size(); j++)
+			instructions.append(RenderInstruction(ri.at(j), &rp));
 	}
 }
 
 void RasterTile::circleInstructions(const QList<MapData::Point> &points,
   QVector<RasterTile::RenderInstruction> &instructions) const
 {
-	QCache<PointKey, QList<const Style::CircleRender *> > cache(8192);
-	QList<const Style::CircleRender*> *ri;
-
 	for (int i = 0; i < points.size(); i++) {
 		const MapData::Point &point = points.at(i);
-		PointKey key(_zoom, point.tags);
-
-		if (!(ri = cache.object(key))) {
-			ri = new QList<const Style::CircleRender*>(_style->circles(_zoom,
-			  point.tags));
-			for (int j = 0; j < ri->size(); j++)
-				instructions.append(RenderInstruction(ri->at(j), &point));
-			cache.insert(key, ri);
-		} else {
-			for (int j = 0; j < ri->size(); j++)
-				instructions.append(RenderInstruction(ri->at(j), &point));
-		}
+		QList<const Style::CircleRender*> ri(_style->circles(_zoom,
+		  point.tags));
+
+		for (int j = 0; j < ri.size(); j++)
+			instructions.append(RenderInstruction(ri.at(j), &point));
 	}
 }
 
@@ -24,7 +24,7 @@ class RasterTile
 {
 public:
 	RasterTile(const Projection *proj, const Transform &transform,
-	  const Style *style, MapData *data, int zoom, const QRect &rect,
+	  Style *style, MapData *data, int zoom, const QRect &rect,
 	  qreal ratio, bool hillShading)
 		: _proj(proj), _transform(transform), _style(style), _data(data),
 		_zoom(zoom), _rect(rect), _ratio(ratio), _hillShading(hillShading) {}
@@ -141,32 +141,6 @@ private:
 		const MapData::Point *_point;
 	};
 
-	struct PathKey {
-		PathKey(int zoom, bool closed, const QVector<MapData::Tag> &tags)
-		  : zoom(zoom), closed(closed), tags(tags) {}
-		bool operator==(const PathKey &other) const
-		{
-			return zoom == other.zoom && closed == other.closed
-			  && tags == other.tags;
-		}
-
-		int zoom;
-		bool closed;
-		const QVector<MapData::Tag> &tags;
-	};
-
-	struct PointKey {
-		PointKey(int zoom, const QVector<MapData::Tag> &tags)
-		  : zoom(zoom), tags(tags) {}
-		bool operator==(const PointKey &other) const
-		{
-			return zoom == other.zoom && tags == other.tags;
-		}
-
-		int zoom;
-		const QVector<MapData::Tag> &tags;
-	};
-
 	class PointItem : public TextPointItem
 	{
 	public:
@@ -206,9 +180,6 @@ private:
 		~PathItem() {delete _text;}
 	};
 
-	friend HASH_T qHash(const RasterTile::PathKey &key);
-	friend HASH_T qHash(const RasterTile::PointKey &key);
-
 	void fetchData(QList<MapData::Path> &paths,
 	  QList<MapData::Point> &points, bool &hasDEM) const;
 	void pathInstructions(const QList<MapData::Path> &paths,
@@ -236,7 +207,7 @@ private:
 
 	const Projection *_proj;
 	Transform _transform;
-	const Style *_style;
+	Style *_style;
 	MapData *_data;
 	int _zoom;
 	QRect _rect;
@@ -245,16 +216,6 @@ private:
 	bool _hillShading;
 };
 
-inline HASH_T qHash(const RasterTile::PathKey &key)
-{
-	return ::qHash(key.zoom) ^ ::qHash(key.tags);
-}
-
-inline HASH_T qHash(const RasterTile::PointKey &key)
-{
-	return ::qHash(key.zoom) ^ ::qHash(key.tags);
-}
-
 }
 
 #endif // MAPSFORGE_RASTERTILE_H
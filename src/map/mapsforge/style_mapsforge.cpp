@@ -879,7 +879,53 @@ bool Style::loadXml(const QString &path, const MapData &data, qreal ratio,
 	return !reader.error();
 }
 
+Style::Index::Index(const QList<const Rule*> &rules)
+{
+	for (int i = 0; i < rules.size(); i++) {
+		const QVector<Rule::Filter> &filters = rules.at(i)->_filters;
+		const Rule::Filter *guard = 0;
+
+		for (int j = 0; j < filters.size(); j++) {
+			if (filters.at(j).requiresKey()) {
+				guard = &filters.at(j);
+				break;
+			}
+		}
+
+		if (guard) {
+			for (int j = 0; j < guard->keys().size(); j++)
+				_keys[guard->keys().at(j)].append(i);
+		} else
+			_any.append(i);
+	}
+}
+
+QVector<int> Style::Index::candidates(const QVector<MapData::Tag> &tags) const
+{
+	QVector<int> list(_any);
+
+	for (int i = 0; i < tags.size(); i++) {
+		QHash<unsigned, QVector<int> >::const_iterator it(
+		  _keys.constFind(tags.at(i).key));
+		if (it != _keys.constEnd())
+			list << *it;
+	}
+
+	std::sort(list.begin(), list.end());
+	list.erase(std::unique(list.begin(), list.end()), list.end());
+
+	return list;
+}
+
+Style::Style() : _allTags(false),
+  _pathCache("Mapsforge style paths", &_cacheLock),
+  _circleCache("Mapsforge style circles", &_cacheLock)
+{
+}
+
 Style::Style(const QString &path, const MapData &data, qreal ratio, int layer)
+  : _allTags(false), _pathCache("Mapsforge style paths", &_cacheLock),
+  _circleCache("Mapsforge style circles", &_cacheLock)
 {
 	if (!loadXml(path, data, ratio, layer)) {
 		_paths = QList<PathRender>();
@@ -896,28 +942,137 @@ Style::Style(const QString &path, const MapData &data, qreal ratio, int layer)
 		std::stable_sort(_labels.begin(), _labels.end());
 		std::stable_sort(_pathLabels.begin(), _pathLabels.end());
 	}
+
+	compile();
+}
+
+void Style::compile()
+{
+	QList<const Rule*> paths, circles;
+
+	for (int i = 0; i < _paths.size(); i++)
+		paths.append(&_paths.at(i).rule());
+	for (int i = 0; i < _circles.size(); i++)
+		circles.append(&_circles.at(i).rule());
+
+	_pathIndex = Index(paths);
+	_circleIndex = Index(circles);
+
+	/* Tags whose key and value are not used in any rule can not affect the
+	   matching (unless there is a rule matching any key), so they are left
+	   out of the cache keys to get more cache hits for named objects. */
+	QList<const Rule*> rules(paths + circles);
+	for (int i = 0; i < rules.size(); i++) {
+		const QVector<Rule::Filter> &filters = rules.at(i)->_filters;
+
+		for (int j = 0; j < filters.size(); j++) {
+			const Rule::Filter &f = filters.at(j);
+
+			for (int k = 0; k < f.keys().size(); k++) {
+				if (f.keys().at(k))
+					_tagKeys.insert(f.keys().at(k));
+				else
+					_allTags = true;
+			}
+			for (int k = 0; k < f.vals().size(); k++)
+				if (!f.vals().at(k).isEmpty())
+					_tagValues.insert(f.vals().at(k));
+		}
+	}
+}
+
+QVector<MapData::Tag> Style::relevantTags(const QVector<MapData::Tag> &tags)
+  const
+{
+	QVector<MapData::Tag> list;
+	int i;
+
+	if (_allTags)
+		return tags;
+
+	for (i = 0; i < tags.size(); i++) {
+		const MapData::Tag &t = tags.at(i);
+		if (!(_tagKeys.contains(t.key) || _tagValues.contains(t.value)))
+			break;
+	}
+	if (i == tags.size())
+		return tags;
+
+	list.reserve(tags.size() - 1);
+	for (int j = 0; j < tags.size(); j++) {
+		const MapData::Tag &t = tags.at(j);
+		if (j != i && (_tagKeys.contains(t.key)
+		  || _tagValues.contains(t.value)))
+			list.append(t);
+	}
+
+	return list;
+}
+
+qint64 Style::cost(const Key &key, int renders)
+{
+	qint64 size = sizeof(Key) + renders * sizeof(void*) + 64;
+
+	for (int i = 0; i < key.tags.size(); i++)
+		size += sizeof(MapData::Tag) + key.tags.at(i).value.size();
+
+	return size;
 }
 
 QList<const Style::PathRender *> Style::paths(int zoom, bool closed,
-  const QVector<MapData::Tag> &tags) const
+  const QVector<MapData::Tag> &tags)
 {
+	Key key(zoom, closed, relevantTags(tags));
 	QList<const PathRender*> ri;
 
-	for (int i = 0; i < _paths.size(); i++)
-		if (_paths.at(i).rule().match(zoom, closed, tags))
-			ri.append(&_paths.at(i));
+	_cacheLock.lock();
+	QList<const PathRender*> *cached = _pathCache.object(key);
+	if (cached)
+		ri = *cached;
+	_cacheLock.unlock();
+	if (cached)
+		return ri;
+
+	QVector<int> candidates(_pathIndex.candidates(key.tags));
+	for (int i = 0; i < candidates.size(); i++) {
+		const PathRender &r = _paths.at(candidates.at(i));
+		if (r.rule().match(zoom, closed, key.tags))
+			ri.append(&r);
+	}
+
+	_cacheLock.lock();
+	_pathCache.insert(key, new QList<const PathRender*>(ri),
+	  cost(key, ri.size()));
+	_cacheLock.unlock();
 
 	return ri;
 }
 
 QList<const Style::CircleRender *> Style::circles(int zoom,
-  const QVector<MapData::Tag> &tags) const
+  const QVector<MapData::Tag> &tags)
 {
+	Key key(zoom, false, relevantTags(tags));
 	QList<const CircleRender*> ri;
 
-	for (int i = 0; i < _circles.size(); i++)
-		if (_circles.at(i).rule().match(zoom, tags))
-			ri.append(&_circles.at(i));
+	_cacheLock.lock();
+	QList<const CircleRender*> *cached = _circleCache.object(key);
+	if (cached)
+		ri = *cached;
+	_cacheLock.unlock();
+	if (cached)
+		return ri;
+
+	QVector<int> candidates(_circleIndex.candidates(key.tags));
+	for (int i = 0; i < candidates.size(); i++) {
+		const CircleRender &r = _circles.at(candidates.at(i));
+		if (r.rule().match(zoom, key.tags))
+			ri.append(&r);
+	}
+
+	_cacheLock.lock();
+	_circleCache.insert(key, new QList<const CircleRender*>(ri),
+	  cost(key, ri.size()));
+	_cacheLock.unlock();
 
 	return ri;
 }
@@ -5,6 +5,8 @@
 #include <QList>
 #include <QPen>
 #include <QFont>
+#include <QMutex>
+#include "common/memorycache.h"
 #include "map/textpointitem.h"
 #include "mapdata_mapsforge.h"
 
@@ -59,6 +61,11 @@ public:
 				  && _vals.contains(QByteArray()));
 			}
 
+			const QList<unsigned> &keys() const {return _keys;}
+			const QList<QByteArray> &vals() const {return _vals;}
+			/* The filter can only match tags containing one of its keys */
+			bool requiresKey() const {return !_neg && !_keys.contains(0u);}
+
 		private:
 			bool keyMatches(const QVector<MapData::Tag> &tags) const
 			{
@@ -264,13 +271,15 @@ public:
 		QImage _img;
 	};
 
-	Style() {}
+	Style();
 	Style(const QString &path, const MapData &data, qreal ratio, int layer);
 
+	/* Thread-safe, the results are cached for the style lifetime (within
+	   the global memory budget) */
 	QList<const PathRender *> paths(int zoom, bool closed,
-	  const QVector<MapData::Tag> &tags) const;
+	  const QVector<MapData::Tag> &tags);
 	QList<const CircleRender *> circles(int zoom,
-	  const QVector<MapData::Tag> &tags) const;
+	  const QVector<MapData::Tag> &tags);
 	QList<const TextRender*> pathLabels(int zoom) const;
 	QList<const TextRender*> labels(int zoom) const;
 	QList<const TextRender*> areaLabels(int zoom) const;
@@ -283,6 +292,38 @@ public:
 	bool hasHillShading() const {return _hillShading.isValid();}
 
 private:
+	/* Render-theme rules compiled into a tag key index. Every render is
+	   registered under the keys one of its filters requires (or as an "any"
+	   render when there is no such filter), so only the renders that may
+	   match the tags are tested. */
+	class Index {
+	public:
+		Index() {}
+		Index(const QList<const Rule*> &rules);
+
+		QVector<int> candidates(const QVector<MapData::Tag> &tags) const;
+
+	private:
+		QHash<unsigned, QVector<int> > _keys;
+		QVector<int> _any;
+	};
+
+	struct Key {
+		Key(int zoom, bool closed, const QVector<MapData::Tag> &tags)
+		  : zoom(zoom), closed(closed), tags(tags) {}
+		bool operator==(const Key &other) const
+		{
+			return zoom == other.zoom && closed == other.closed
+			  && tags == other.tags;
+		}
+
+		int zoom;
+		bool closed;
+		QVector<MapData::Tag> tags;
+	};
+
+	friend HASH_T qHash(const Style::Key &key);
+
 	class Menu {
 	public:
 		class Layer {
@@ -340,6 +381,19 @@ private:
 	QList<Symbol> _symbols, _lineSymbols;
 	Menu _menu;
 
+	Index _pathIndex, _circleIndex;
+	QSet<unsigned> _tagKeys;
+	QSet<QByteArray> _tagValues;
+	bool _allTags;
+
+	QMutex _cacheLock;
+	MemoryCache<Key, QList<const PathRender*> > _pathCache;
+	MemoryCache<Key, QList<const CircleRender*> > _circleCache;
+
+	void compile();
+	QVector<MapData::Tag> relevantTags(const QVector<MapData::Tag> &tags) const;
+	static qint64 cost(const Key &key, int renders);
+
 	bool loadXml(const QString &path, const MapData &data, qreal ratio,
 	  int layer);
 	void rendertheme(QXmlStreamReader &reader, const QString &dir,
@@ -364,6 +418,11 @@ private:
 	  const Rule &rule, bool line);
 };
 
+inline HASH_T qHash(const Style::Key &key)
+{
+	return ::qHash(key.zoom) ^ ::qHash(key.closed) ^ ::qHash(key.tags);
+}
+
 }
 
 #endif // MAPSFORGE_STYLE_H
@@ -6,12 +6,15 @@
 #include "common/programpaths.h"
 #include "rectd.h"
 #include "pcs.h"
+#include "tilefallback.h"
+#include "metatile.h"
 #include "mapsforgemap.h"
 
 
 using namespace Mapsforge;
 
 #define EPSILON     1e-6
+#define FALLBACK_LEVELS 3
 
 MapsforgeMap::MapsforgeMap(const QString &fileName, QObject *parent)
   : Map(fileName, parent), _data(fileName), _style(0), _zoom(0),
@@ -129,10 +132,15 @@ void MapsforgeMap::updateTransform()
 		_bounds.adjust(0.5, 0, -0.5, 0);
 }
 
+QString MapsforgeMap::prefix(int zoom) const
+{
+	return path() + "-" + QString::number(zoom) + "_";
+}
+
 QString MapsforgeMap::key(int zoom, const QPoint &xy) const
 {
-	return path() + "-" + QString::number(zoom) + "_"
-	  + QString::number(xy.x()) + "_" + QString::number(xy.y());
+	return prefix(zoom) + QString::number(xy.x()) + "_"
+	  + QString::number(xy.y());
 }
 
 bool MapsforgeMap::isRunning(int zoom, const QPoint &xy) const
@@ -170,7 +178,8 @@ void MapsforgeMap::jobFinished(MapsforgeMapJob *job)
 	for (int i = 0; i < tiles.size(); i++) {
 		const Mapsforge::RasterTile &mt = tiles.at(i);
 		if (!mt.pixmap().isNull())
-			QPixmapCache::insert(key(mt.zoom(), mt.xy()), mt.pixmap());
+			MetaTile::cache(prefix(mt.zoom()), mt.xy(), _data.tileSize(),
+			  mt.pixmap());
 	}
 
 	removeJob(job);
@@ -184,6 +193,19 @@ void MapsforgeMap::cancelJobs(bool wait)
 		_jobs.at(i)->cancel(wait);
 }
 
+TileFallback MapsforgeMap::fallback() const
+{
+	const Range &zooms = _data.zooms();
+	TileFallback fb(_data.tileSize());
+
+	for (int z = _zoom - 1; z >= qMax(zooms.min(), _zoom - FALLBACK_LEVELS); z--)
+		fb.addLevel(prefix(z), z);
+	if (_zoom < zooms.max())
+		fb.addLevel(prefix(_zoom + 1), _zoom + 1);
+
+	return fb;
+}
+
 void MapsforgeMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	int tileSize = _data.tileSize();
@@ -192,22 +214,33 @@ void MapsforgeMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	QSizeF s(rect.right() - tl.x(), rect.bottom() - tl.y());
 	int width = ceil(s.width() / tileSize);
 	int height = ceil(s.height() / tileSize);
+	TileFallback fb((flags & Map::Block) ? TileFallback() : fallback());
 
 	QList<RasterTile> tiles;
+	QList<QPoint> metaTiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPoint ttl(tl.x() + i * tileSize, tl.y() + j * tileSize);
-			if (isRunning(_zoom, ttl))
+			QRectF tr(ttl, QSizeF(tileSize, tileSize));
+			QPoint txy(ttl.x() / tileSize, ttl.y() / tileSize);
+			QRect mtr((flags & Map::Block) ? QRect(ttl, QSize(tileSize, tileSize))
+			  : MetaTile::rect(ttl, tileSize));
+			if (isRunning(_zoom, mtr.topLeft())) {
+				fb.draw(painter, tr, _zoom, txy);
 				continue;
+			}
 
 			QPixmap pm;
 			if (QPixmapCache::find(key(_zoom, ttl), &pm))
 				painter->drawPixmap(ttl, pm);
 			else {
-				tiles.append(RasterTile(&_projection, _transform, _style, &_data,
-				  _zoom, QRect(ttl, QSize(tileSize, tileSize)), _tileRatio,
-				  _hillShading));
+				fb.draw(painter, tr, _zoom, txy);
+				if (!metaTiles.contains(mtr.topLeft())) {
+					metaTiles.append(mtr.topLeft());
+					tiles.append(RasterTile(&_projection, _transform, _style,
+					  &_data, _zoom, mtr, _tileRatio, _hillShading));
+				}
 			}
 		}
 	}
@@ -221,7 +254,7 @@ void MapsforgeMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 				const RasterTile &mt = tiles.at(i);
 				const QPixmap &pm = mt.pixmap();
 				painter->drawPixmap(mt.xy(), pm);
-				QPixmapCache::insert(key(mt.zoom(), mt.xy()), pm);
+				MetaTile::cache(prefix(mt.zoom()), mt.xy(), tileSize, pm);
 			}
 		} else
 			runJob(new MapsforgeMapJob(tiles));
@@ -8,6 +8,7 @@
 #include "transform.h"
 #include "map.h"
 
+class TileFallback;
 
 class MapsforgeMapJob : public QObject
 {
@@ -91,6 +92,7 @@ private:
 		StyleList();
 	};
 
+	QString prefix(int zoom) const;
 	QString key(int zoom, const QPoint &xy) const;
 	Transform transform(int zoom) const;
 	void updateTransform();
@@ -98,6 +100,7 @@ private:
 	void runJob(MapsforgeMapJob *job);
 	void removeJob(MapsforgeMapJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback() const;
 
 	static StyleList &styles();
 
@@ -7,10 +7,12 @@
 #include <QImageReader>
 #include "common/util.h"
 #include "osm.h"
+#include "tilefallback.h"
 #include "mbtilesmap.h"
 
 #define MVT_TILE_SIZE 512
 #define MAX_TILE_SIZE 4096
+#define FALLBACK_LEVELS 3
 
 using namespace MVT;
 using namespace OSM;
@@ -435,6 +437,20 @@ QPointF MBTilesMap::tilePos(const QPointF &tl, const QPoint &tc,
 	  tl.y() + ((tc.y() - tile.y()) << overzoom) * tileSize());
 }
 
+TileFallback MBTilesMap::fallback() const
+{
+	TileFallback fb;
+
+	for (int i = _zoom - 1; i >= qMax(0, _zoom - FALLBACK_LEVELS); i--)
+		fb.addLevel(path() + "-" + QString::number(_zooms.at(i).z) + "_",
+		  _zooms.at(i).base);
+	if (_zoom < _zooms.size() - 1)
+		fb.addLevel(path() + "-" + QString::number(_zooms.at(_zoom + 1).z)
+		  + "_", _zooms.at(_zoom + 1).base);
+
+	return fb;
+}
+
 void MBTilesMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	const Zoom &zoom = _zooms.at(_zoom);
@@ -446,24 +462,31 @@ void MBTilesMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	unsigned f = 1U<<overzoom;
 	int width = ceil(s.width() / (tileSize() * f));
 	int height = ceil(s.height() / (tileSize() * f));
+	QSizeF ts(tileSize() * f, tileSize() * f);
+	TileFallback fb((flags & Map::Block || !_mvt)
+	  ? TileFallback() : fallback());
 
 	QList<RasterTile> tiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPoint t(tile.x() + i, tile.y() + j);
+			QPointF tp(tilePos(tl, t, tile, overzoom));
 
-			if (isRunning(zoom.z, t))
+			if (isRunning(zoom.z, t)) {
+				fb.draw(painter, QRectF(tp, ts), zoom.base, t);
 				continue;
+			}
 
 			QPixmap pm;
-			if (QPixmapCache::find(key(zoom.z, t), &pm)) {
-				QPointF tp(tilePos(tl, t, tile, overzoom));
+			if (QPixmapCache::find(key(zoom.z, t), &pm))
 				drawTile(painter, pm, tp);
-			} else
+			else {
+				fb.draw(painter, QRectF(tp, ts), zoom.base, t);
 				tiles.append(RasterTile(Source(tileData(zoom.base, t), _mvt,
 				  _mvt), _style, zoom.z, t, _tileSize, _tileRatio, overzoom,
 				  _hillShading));
+			}
 		}
 	}
 
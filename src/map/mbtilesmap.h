@@ -8,6 +8,7 @@
 #include "map.h"
 
 class QPixmap;
+class TileFallback;
 
 class MBTilesMap : public Map
 {
@@ -77,6 +78,7 @@ private:
 	void runJob(MVTJob *job);
 	void removeJob(MVTJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback() const;
 
 	const MVT::Style *defaultStyle() const;
 
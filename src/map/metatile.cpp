@@ -0,0 +1,47 @@
+#include <QPixmap>
+#include <QPixmapCache>
+#include "metatile.h"
+
+static int floorDiv(int a, int b)
+{
+	return (a >= 0) ? a / b : -((b - 1 - a) / b);
+}
+
+static QString key(const QString &prefix, const QPoint &xy)
+{
+	return prefix + QString::number(xy.x()) + "_" + QString::number(xy.y());
+}
+
+QRect MetaTile::rect(const QPoint &xy, int tileSize)
+{
+	int size = tileSize * METATILE_SIZE;
+	QPoint tl(floorDiv(xy.x(), size) * size, floorDiv(xy.y(), size) * size);
+
+	return QRect(tl, QSize(size, size));
+}
+
+void MetaTile::cache(const QString &prefix, const QPoint &xy, int tileSize,
+  const QPixmap &pixmap)
+{
+	qreal ratio = pixmap.devicePixelRatio();
+	qreal ts = tileSize * ratio;
+	int cols = qRound(pixmap.width() / ts);
+	int rows = qRound(pixmap.height() / ts);
+
+	if (cols <= 1 && rows <= 1) {
+		QPixmapCache::insert(key(prefix, xy), pixmap);
+		return;
+	}
+
+	for (int i = 0; i < cols; i++) {
+		for (int j = 0; j < rows; j++) {
+			int x = (int)(i * ts), y = (int)(j * ts);
+			QPixmap pm(pixmap.copy(x, y, (int)((i + 1) * ts) - x,
+			  (int)((j + 1) * ts) - y));
+			pm.setDevicePixelRatio(ratio);
+
+			QPixmapCache::insert(key(prefix, QPoint(xy.x() + i * tileSize,
+			  xy.y() + j * tileSize)), pm);
+		}
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef METATILE_H
+#define METATILE_H
+
+#include <QRect>
+#include <QString>
+
+class QPixmap;
+
+/*
+  Metatiles are blocks of METATILE_SIZE x METATILE_SIZE map tiles rendered at
+  once. The map data is fetched, projected and the labels are placed only
+  once for the whole block (with consistent labels across the inner tile
+  borders) and the rendered image is then sliced into the standard tiles
+  for the pixmap cache. Setting METATILE_SIZE to 1 disables the metatiles.
+
+  Tile keys are expected in the usual "prefix" + "x_y" form with x/y being
+  the pixel coordinates of the tile (see TileFallback).
+*/
+
+#define METATILE_SIZE 4
+
+namespace MetaTile
+{
+	/* The metatile containing the tile at xy */
+	QRect rect(const QPoint &xy, int tileSize);
+	/* Inserts all the tiles of the rendered (meta)tile at xy into the pixmap
+	   cache. Ordinary tiles are inserted as they are. */
+	void cache(const QString &prefix, const QPoint &xy, int tileSize,
+	  const QPixmap &pixmap);
+}
+
+#endif // METATILE_H
@@ -5,9 +5,11 @@
 #include "common/programpaths.h"
 #include "downloader.h"
 #include "osm.h"
+#include "tilefallback.h"
 #include "onlinemap.h"
 
 #define MAX_TILE_SIZE 4096
+#define FALLBACK_LEVELS 3
 
 using namespace MVT;
 using namespace OSM;
@@ -210,6 +212,19 @@ void OnlineMap::cancelJobs(bool wait)
 		_jobs.at(i)->cancel(wait);
 }
 
+TileFallback OnlineMap::fallback() const
+{
+	TileFallback fb(1, _invertY);
+
+	for (int z = _zoom - 1; z >= qMax(_zooms.min(), _zoom - FALLBACK_LEVELS); z--)
+		fb.addLevel(path() + "-" + QString::number(z) + "_", qMin(_baseZoom, z));
+	if (_zoom < _zooms.max())
+		fb.addLevel(path() + "-" + QString::number(_zoom + 1) + "_",
+		  qMin(_baseZoom, _zoom + 1));
+
+	return fb;
+}
+
 void OnlineMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	int baseZoom = qMin(_baseZoom, _zoom);
@@ -221,6 +236,8 @@ void OnlineMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	unsigned f = 1U<<overzoom;
 	int width = ceil(s.width() / (tileSize() * f));
 	int height = ceil(s.height() / (tileSize() * f));
+	QSizeF ts(tileSize() * f, tileSize() * f);
+	TileFallback fb((flags & Map::Block) ? TileFallback() : fallback());
 
 	QVector<TileLoader::Tile> fetchTiles;
 	fetchTiles.reserve(width * height);
@@ -239,18 +256,21 @@ void OnlineMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	QList<RasterTile> renderTiles;
 	for (int i = 0; i < fetchTiles.count(); i++) {
 		const TileLoader::Tile &t = fetchTiles.at(i);
-		if (!t.isComplete())
-			continue;
+		QPoint tc(tileCoordinates(t.xy().x(), t.xy().y(), baseZoom));
+		QPointF tp(tilePos(tl, tc, tile, overzoom));
 
-		if (isRunning(_zoom, t.xy()))
+		if (!t.isComplete() || isRunning(_zoom, t.xy())) {
+			fb.draw(painter, QRectF(tp, ts), baseZoom, tc);
 			continue;
+		}
 
 		QPixmap pm;
-		if (QPixmapCache::find(key(_zoom, t.xy()), &pm)) {
-			QPoint tc(tileCoordinates(t.xy().x(), t.xy().y(), baseZoom));
-			QPointF tp(tilePos(tl, tc, tile, overzoom));
+		if (QPixmapCache::find(key(_zoom, t.xy()), &pm))
 			drawTile(painter, pm, tp);
-		} else {
+		else {
+			if (_mvt)
+				fb.draw(painter, QRectF(tp, ts), baseZoom, tc);
+
 			QList<Source> sources;
 			for (int j = 0; j < t.files().size(); j++) {
 				const QString &path = t.files().at(j);
@@ -8,6 +8,7 @@
 #include "map.h"
 
 class QPixmap;
+class TileFallback;
 
 class OnlineMap : public Map
 {
@@ -61,6 +62,7 @@ private:
 	void runJob(MVTJob *job);
 	void removeJob(MVTJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback() const;
 
 	const MVT::Style *defaultStyle() const;
 
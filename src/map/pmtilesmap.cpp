@@ -5,19 +5,21 @@
 #include <QImageReader>
 #include "MVT/style_mvt.h"
 #include "osm.h"
+#include "tilefallback.h"
 #include "pmtilesmap.h"
 
 #define MVT_TILE_SIZE   512
 #define MAX_TILE_SIZE   4096
-#define LEAF_CACHE_SIZE 16
+#define FALLBACK_LEVELS 3
 
 using namespace PMTiles;
 using namespace MVT;
 using namespace OSM;
 
 PMTilesMap::PMTilesMap(const QString &fileName, QObject *parent)
-  : Map(fileName, parent), _file(fileName), _style(0), _mapRatio(1.0),
-  _tileRatio(1.0), _hillShading(false), _mvt(false), _valid(false)
+  : Map(fileName, parent), _file(fileName), _cache("PMTiles", &_cacheLock),
+  _style(0), _mapRatio(1.0), _tileRatio(1.0), _hillShading(false), _mvt(false),
+  _valid(false)
 {
 	if (!_file.open(QIODevice::ReadOnly)) {
 		_errorString = _file.errorString();
@@ -98,8 +100,6 @@ PMTilesMap::PMTilesMap(const QString &fileName, QObject *parent)
 
 	_file.close();
 
-	_cache.setMaxCost(LEAF_CACHE_SIZE);
-
 	_valid = true;
 }
 
@@ -142,7 +142,10 @@ void PMTilesMap::unload()
 {
 	cancelJobs(true);
 	_file.close();
+
+	_cacheLock.lock();
 	_cache.clear();
+	_cacheLock.unlock();
 }
 
 QString PMTilesMap::name() const
@@ -220,16 +223,21 @@ QByteArray PMTilesMap::tileData(quint64 id)
 	if (!d)
 		return QByteArray();
 	if (!d->runLength) {
+		_cacheLock.lock();
 		QVector<Directory> *leaf = _cache.object(d->offset);
 		if (!leaf) {
 			leaf = new QVector<Directory>(readDir(_file, _leafOffset + d->offset,
 			  d->length, _ic));
-			_cache.insert(d->offset, leaf);
+			_cache.insert(d->offset, leaf, sizeof(QVector<Directory>)
+			  + leaf->size() * sizeof(Directory));
 		}
 		const Directory *l = findDir(*leaf, id);
-		return (l)
+		QByteArray data((l)
 		  ? readData(_file, _tileOffset + l->offset, l->length, 1)
-		  : QByteArray();
+		  : QByteArray());
+		_cacheLock.unlock();
+
+		return data;
 	} else
 		return readData(_file, _tileOffset + d->offset, d->length, 1);
 }
@@ -296,6 +304,20 @@ QPointF PMTilesMap::tilePos(const QPointF &tl, const QPoint &tc,
 	  tl.y() + ((tc.y() - tile.y()) << overzoom) * tileSize());
 }
 
+TileFallback PMTilesMap::fallback() const
+{
+	TileFallback fb;
+
+	for (int i = _zoom - 1; i >= qMax(0, _zoom - FALLBACK_LEVELS); i--)
+		fb.addLevel(path() + "-" + QString::number(_zooms.at(i).z) + "_",
+		  _zooms.at(i).base);
+	if (_zoom < _zooms.size() - 1)
+		fb.addLevel(path() + "-" + QString::number(_zooms.at(_zoom + 1).z)
+		  + "_", _zooms.at(_zoom + 1).base);
+
+	return fb;
+}
+
 void PMTilesMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 {
 	const Zoom &zoom = _zooms.at(_zoom);
@@ -307,24 +329,31 @@ void PMTilesMap::draw(QPainter *painter, const QRectF &rect, Flags flags)
 	unsigned f = 1U<<overzoom;
 	int width = ceil(s.width() / (tileSize() * f));
 	int height = ceil(s.height() / (tileSize() * f));
+	QSizeF ts(tileSize() * f, tileSize() * f);
+	TileFallback fb((flags & Map::Block || !_mvt)
+	  ? TileFallback() : fallback());
 
 	QList<RasterTile> tiles;
 
 	for (int i = 0; i < width; i++) {
 		for (int j = 0; j < height; j++) {
 			QPoint t(tile.x() + i, tile.y() + j);
+			QPointF tp(tilePos(tl, t, tile, overzoom));
 
-			if (isRunning(zoom.z, t))
+			if (isRunning(zoom.z, t)) {
+				fb.draw(painter, QRectF(tp, ts), zoom.base, t);
 				continue;
+			}
 
 			QPixmap pm;
-			if (QPixmapCache::find(key(zoom.z, t), &pm)) {
-				QPointF tp(tilePos(tl, t, tile, overzoom));
+			if (QPixmapCache::find(key(zoom.z, t), &pm))
 				drawTile(painter, pm, tp);
-			} else
+			else {
+				fb.draw(painter, QRectF(tp, ts), zoom.base, t);
 				tiles.append(RasterTile(Source(tileData(id(zoom.base, t)),
 				  _tc == 2, _mvt), _style, zoom.z, t, _tileSize, _tileRatio,
 				  overzoom, _hillShading));
+			}
 		}
 	}
 
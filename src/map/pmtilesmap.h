@@ -2,10 +2,14 @@
 #define PMTILESMAP_H
 
 #include <QFile>
+#include <QMutex>
+#include "common/memorycache.h"
 #include "pmtiles.h"
 #include "mvtjob.h"
 #include "map.h"
 
+class TileFallback;
+
 class PMTilesMap : public Map
 {
 public:
@@ -66,6 +70,7 @@ private:
 	void runJob(MVTJob *job);
 	void removeJob(MVTJob *job);
 	void cancelJobs(bool wait);
+	TileFallback fallback() const;
 
 	const MVT::Style *defaultStyle() const;
 
@@ -73,7 +78,8 @@ private:
 	QString _name;
 	RectC _bounds;
 	QVector<PMTiles::Directory> _root;
-	QCache<quint64, QVector<PMTiles::Directory> > _cache;
+	QMutex _cacheLock;
+	MemoryCache<quint64, QVector<PMTiles::Directory> > _cache;
 	quint64 _tileOffset, _leafOffset;
 	quint8 _tc, _ic;
 	QVector<Zoom> _zooms, _zoomsBase;
@@ -0,0 +1,85 @@
+#include <QPainter>
+#include <QPixmapCache>
+#include "tilefallback.h"
+
+static int parent(int v, int d)
+{
+	return (v >= 0) ? (v >> d) : -((-v - 1) >> d) - 1;
+}
+
+bool TileFallback::find(const Level &level, const QPoint &xy, QPixmap *pm) const
+{
+	int y = _invertY ? (1<<level.base) - xy.y() - 1 : xy.y();
+	QString key(level.prefix + QString::number(xy.x() * _step) + "_"
+	  + QString::number(y * _step));
+
+	return QPixmapCache::find(key, pm);
+}
+
+bool TileFallback::drawAncestor(QPainter *painter, const QRectF &rect,
+  int base, const QPoint &xy) const
+{
+	QPixmap pm;
+
+	for (int i = 0; i < _levels.size(); i++) {
+		const Level &l = _levels.at(i);
+		int d = base - l.base;
+		if (d < 0)
+			continue;
+
+		QPoint p(parent(xy.x(), d), parent(xy.y(), d));
+		if (find(l, p, &pm)) {
+			int n = 1<<d;
+			qreal w = pm.width() / (qreal)n;
+			qreal h = pm.height() / (qreal)n;
+			QRectF src((xy.x() - p.x() * n) * w, (xy.y() - p.y() * n) * h, w, h);
+
+			painter->drawPixmap(rect, pm, src);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool TileFallback::drawChildren(QPainter *painter, const QRectF &rect,
+  int base, const QPoint &xy) const
+{
+	for (int i = 0; i < _levels.size(); i++) {
+		const Level &l = _levels.at(i);
+		if (l.base != base + 1)
+			continue;
+
+		QPixmap pm[4];
+		int found = 0;
+		for (int j = 0; j < 4; j++)
+			if (find(l, QPoint(2 * xy.x() + (j & 1), 2 * xy.y() + (j >> 1)),
+			  &pm[j]))
+				found++;
+		if (!found)
+			continue;
+
+		qreal w = rect.width() / 2.0;
+		qreal h = rect.height() / 2.0;
+		for (int j = 0; j < 4; j++)
+			if (!pm[j].isNull())
+				painter->drawPixmap(QRectF(rect.left() + (j & 1) * w,
+				  rect.top() + (j >> 1) * h, w, h), pm[j],
+				  QRectF(pm[j].rect()));
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TileFallback::draw(QPainter *painter, const QRectF &rect, int base,
+  const QPoint &xy) const
+{
+	/* Prefer the ancestors as the partial children sets leave holes and we do
+	   not want to draw both as the tiles may be transparent (overlays). */
+	if (drawAncestor(painter, rect, base, xy))
+		return true;
+
+	return drawChildren(painter, rect, base, xy);
+}
@@ -0,0 +1,56 @@
+#ifndef TILEFALLBACK_H
+#define TILEFALLBACK_H
+
+#include <QList>
+#include <QString>
+#include <QPoint>
+
+class QPainter;
+class QPixmap;
+class QRectF;
+
+/*
+  Finds the "best available" substitute of a not yet rendered tile in the
+  pixmap cache - the nearest cached ancestor tile (scaled up) or the cached
+  child tiles (scaled down) - and draws it as a placeholder.
+
+  Every zoom level is described by the cache key prefix of its tiles and
+  the zoom of its tile grid (that differs from the zoom level itself for
+  overzoomed tiles). Tile keys are expected in the usual "prefix" + "x_y"
+  form, with x/y being the tile indexes multiplied by step (pixel based
+  tile keys).
+*/
+class TileFallback
+{
+public:
+	TileFallback(int step = 1, bool invertY = false)
+	  : _step(step), _invertY(invertY) {}
+
+	void addLevel(const QString &prefix, int base)
+	  {_levels.append(Level(prefix, base));}
+	bool isEmpty() const {return _levels.isEmpty();}
+
+	bool draw(QPainter *painter, const QRectF &rect, int base,
+	  const QPoint &xy) const;
+
+private:
+	struct Level {
+		Level() : base(-1) {}
+		Level(const QString &prefix, int base) : prefix(prefix), base(base) {}
+
+		QString prefix;
+		int base;
+	};
+
+	bool find(const Level &level, const QPoint &xy, QPixmap *pm) const;
+	bool drawAncestor(QPainter *painter, const QRectF &rect, int base,
+	  const QPoint &xy) const;
+	bool drawChildren(QPainter *painter, const QRectF &rect, int base,
+	  const QPoint &xy) const;
+
+	QList<Level> _levels;
+	int _step;
+	bool _invertY;
+};
+
+#endif // TILEFALLBACK_H